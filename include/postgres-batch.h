@@ -0,0 +1,257 @@
+/**
+ * Copyright (c) 2016 Philippe FERDINAND
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ **/
+#pragma once
+
+#include "postgres-connection.h"
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <iterator>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace db {
+  namespace postgres {
+
+    /**
+     * Rows loaded by key, the keys requested by many threads being loaded
+     * together.
+     *
+     * Keys requested within a short window are collected and loaded with a
+     * single query taking all the keys as an array. The rows returned are
+     * dispatched to the callers according to the value of their key column:
+     * N lookups cost a few round trips instead of N.
+     *
+     * ```
+     * auto cnx = std::make_shared<Connection>();
+     * cnx->connect();
+     * BatchLoader<int32_t, std::string> names(cnx,
+     *   "SELECT emp_no, last_name FROM employees WHERE emp_no = ANY($1)",
+     *   [](const Row &row) { return row.as<std::string>(1); });
+     *
+     * // From any thread.
+     * std::future<std::vector<std::string>> future = names.load(10001);
+     * std::vector<std::string> values = future.get();
+     * ```
+     *
+     * A key requested several times in the same window is loaded once and its
+     * values are copied to each caller. The queries are executed by a thread
+     * owning the connection, a batch being loaded when the window of its
+     * first key has elapsed or when it reaches the batch size.
+     *
+     * @tparam K Type of the keys. It must be bound as an array (see
+     *           Connection::execute()) and read from the key column with
+     *           Row::as(), and it must be ordered by `operator <`.
+     * @tparam V Type of the values built from the rows.
+     **/
+    template<typename K, typename V>
+    class BatchLoader {
+    public:
+
+      typedef std::function<V(const Row &row)> mapper_t;
+
+      /**
+       * Constructor.
+       *
+       * @param cnx    An open connection with no query in progress. Until the
+       *               loader is destroyed, the connection must not be used
+       *               by other threads.
+       * @param sql    The query, taking the array of keys as its only
+       *               parameter `$1`.
+       * @param mapper Builds a value from a row.
+       * @param key    Column of the rows holding the key.
+       **/
+      BatchLoader(std::shared_ptr<Connection> cnx, const char *sql, mapper_t mapper, int key = 0)
+        : cnx_(cnx), sql_(sql), mapper_(mapper), key_(key),
+          window_(std::chrono::milliseconds(1)), batchSize_(256), stopped_(false) {
+        thread_ = std::thread(&BatchLoader::run, this);
+      }
+
+      /**
+       * Destructor.
+       *
+       * Keys already requested are loaded before the thread is stopped.
+       **/
+      ~BatchLoader() {
+        {
+          std::lock_guard<std::mutex> lock(mutex_);
+          stopped_ = true;
+        }
+        condition_.notify_one();
+        thread_.join();
+      }
+
+      /**
+       * Time a key waits for other keys before being loaded, 1 ms by
+       * default.
+       **/
+      BatchLoader &window(std::chrono::microseconds window) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        window_ = window;
+        return *this;
+      }
+
+      /**
+       * Maximum number of distinct keys loaded by a query, 256 by default.
+       **/
+      BatchLoader &batchSize(size_t size) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        batchSize_ = std::max<size_t>(size, 1);
+        return *this;
+      }
+
+      /**
+       * Load the values of a key. This method is thread-safe.
+       *
+       * @param key The key.
+       * @return The values built from the rows of the key, in the order of
+       *         the query, none if the key is not found. The future raises
+       *         the exception of the query if it fails.
+       **/
+      std::future<std::vector<V>> load(const K &key) {
+        std::promise<std::vector<V>> promise;
+        std::future<std::vector<V>> future = promise.get_future();
+        bool notify;
+        {
+          std::lock_guard<std::mutex> lock(mutex_);
+          if (pending_.empty()) {
+            started_ = std::chrono::steady_clock::now();
+          }
+          pending_[key].promises.push_back(std::move(promise));
+          notify = pending_.size() == 1 || pending_.size() >= batchSize_;
+        }
+        if (notify) {
+          condition_.notify_one();
+        }
+        return future;
+      }
+
+    private:
+
+      /**
+       * Callers waiting for the values of a key.
+       **/
+      struct Request {
+        std::vector<std::promise<std::vector<V>>> promises;
+        std::vector<V> values;
+      };
+
+      typedef std::map<K, Request> batch_t;
+
+      std::shared_ptr<Connection> cnx_;
+      std::string sql_;
+      mapper_t mapper_;
+      int key_;
+
+      std::mutex mutex_;                    /**< Protects the members below. **/
+      std::condition_variable condition_;
+      std::chrono::microseconds window_;
+      size_t batchSize_;
+      batch_t pending_;                     /**< Keys not loaded yet. **/
+      std::chrono::steady_clock::time_point started_;  /**< First request of the pending keys. **/
+      bool stopped_;
+      std::thread thread_;
+
+      /**
+       * Body of the thread.
+       **/
+      void run() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        for (;;) {
+          condition_.wait(lock, [this]() { return stopped_ || !pending_.empty(); });
+          if (pending_.empty()) {
+            return;
+          }
+          condition_.wait_until(lock, started_ + window_, [this]() {
+            return stopped_ || pending_.size() >= batchSize_;
+          });
+
+          // Keys in excess are left for the next batch, which is loaded
+          // without waiting.
+          batch_t batch;
+          if (pending_.size() <= batchSize_) {
+            batch.swap(pending_);
+          }
+          else {
+            auto last = pending_.begin();
+            std::advance(last, batchSize_);
+            batch.insert(std::make_move_iterator(pending_.begin()), std::make_move_iterator(last));
+            pending_.erase(pending_.begin(), last);
+          }
+
+          lock.unlock();
+          dispatch(batch);
+          lock.lock();
+        }
+      }
+
+      /**
+       * Load a batch and fulfill its requests.
+       **/
+      void dispatch(batch_t &batch) {
+        try {
+          std::vector<array_item<K>> keys;
+          keys.reserve(batch.size());
+          for (auto &request: batch) {
+            keys.push_back(request.first);
+          }
+          for (auto &row: cnx_->execute(sql_.c_str(), keys)) {
+            auto request = batch.find(row.template as<K>(key_));
+            if (request != batch.end()) {
+              request->second.values.push_back(mapper_(row));
+            }
+          }
+        }
+        catch (...) {
+          std::exception_ptr error = std::current_exception();
+          for (auto &request: batch) {
+            for (auto &promise: request.second.promises) {
+              promise.set_exception(error);
+            }
+          }
+          return;
+        }
+
+        for (auto &request: batch) {
+          auto &promises = request.second.promises;
+          for (size_t i = 0; i + 1 < promises.size(); i++) {
+            promises[i].set_value(request.second.values);
+          }
+          promises.back().set_value(std::move(request.second.values));
+        }
+      }
+
+      BatchLoader(const BatchLoader&) = delete;
+      BatchLoader(const BatchLoader&&) = delete;
+      BatchLoader& operator = (const BatchLoader&) = delete;
+      BatchLoader& operator = (const BatchLoader&&) = delete;
+    };
+
+  } // namespace postgres
+}   // namespace db
@@ -0,0 +1,123 @@
+/**
+ * Copyright (c) 2016 Philippe FERDINAND
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ **/
+#pragma once
+
+#include "postgres-types.h"
+
+#include <cassert>
+#include <chrono>
+
+#if __cplusplus >= 202002L && (__cpp_lib_chrono >= 201907L || _GLIBCXX_RELEASE >= 11)
+  #define LIBPQMXX_HAS_CALENDAR 1
+#endif
+
+namespace db {
+  namespace postgres {
+
+    /**
+     * Conversions between the binary values of date and time types and
+     * `std::chrono` types.
+     *
+     * Those conversions are used by Row::as() and Connection::execute() for
+     * the following types:
+
+       SQL Type                      | C++ Type
+       ------------------------------|-------------------------------------------------
+       timestamp, timestamptz        | std::chrono::time_point\<std::chrono::system_clock, Duration\>
+       interval, time                | std::chrono::duration\<Rep, Period\>
+       date                          | std::chrono::year_month_day (C++20)
+
+     * A time point is bound as a `timestamp with time zone` and a duration as
+     * an `interval`. When read, an interval with days and months is converted
+     * using 24 hours per day and 30 days per month, as `justify_interval()`.
+     **/
+    template<typename Duration>
+    std::chrono::time_point<std::chrono::system_clock, Duration> toTimePoint(int64_t epoch_time) {
+      return std::chrono::time_point<std::chrono::system_clock, Duration>(
+        std::chrono::duration_cast<Duration>(std::chrono::microseconds(epoch_time)));
+    }
+
+    template<typename Duration>
+    std::chrono::time_point<std::chrono::system_clock, Duration> readTimePoint(Oid type, char *buf) {
+      assert(type == TIMESTAMPTZOID || type == TIMESTAMPOID);
+      if (buf == nullptr) {
+        return std::chrono::time_point<std::chrono::system_clock, Duration>();
+      }
+      return toTimePoint<Duration>(read<int64_t>(&buf) + MICROSEC_UNIX_TO_J2000_EPOCH);
+    }
+
+    template<typename Duration>
+    char *writeTimePoint(std::chrono::time_point<std::chrono::system_clock, Duration> value, char *buf) {
+      auto microseconds = std::chrono::duration_cast<std::chrono::microseconds>(value.time_since_epoch());
+      return write(int64_t(microseconds.count()) - MICROSEC_UNIX_TO_J2000_EPOCH, buf);
+    }
+
+    template<typename Rep, typename Period>
+    std::chrono::duration<Rep, Period> toDuration(interval_t value) {
+      int64_t microseconds = value.time + (int64_t(value.months) * 30 + value.days) * MICROSEC_PER_DAY;
+      return std::chrono::duration_cast<std::chrono::duration<Rep, Period>>(
+        std::chrono::microseconds(microseconds));
+    }
+
+    template<typename Rep, typename Period>
+    std::chrono::duration<Rep, Period> readDuration(Oid type, char *buf) {
+      assert(type == INTERVALOID || type == TIMEOID);
+      if (buf == nullptr) {
+        return std::chrono::duration<Rep, Period>();
+      }
+      interval_t value = { read<int64_t>(&buf), 0, 0 };
+      if (type == INTERVALOID) {
+        value.days = read<int32_t>(&buf);
+        value.months = read<int32_t>(&buf);
+      }
+      return toDuration<Rep, Period>(value);
+    }
+
+    template<typename Rep, typename Period>
+    char *writeDuration(std::chrono::duration<Rep, Period> value, char *buf) {
+      auto microseconds = std::chrono::duration_cast<std::chrono::microseconds>(value);
+      buf = write(int64_t(microseconds.count()), buf);
+      buf = write(int32_t(0), buf); // days
+      return write(int32_t(0), buf); // months
+    }
+
+#if LIBPQMXX_HAS_CALENDAR
+    inline std::chrono::year_month_day toDate(int32_t epoch_days) {
+      return std::chrono::year_month_day(std::chrono::sys_days(std::chrono::days(epoch_days)));
+    }
+
+    inline std::chrono::year_month_day readDate(Oid type, char *buf) {
+      assert(type == DATEOID);
+      if (buf == nullptr) {
+        return std::chrono::year_month_day(std::chrono::sys_days());
+      }
+      return toDate(read<int32_t>(&buf) + DAYS_UNIX_TO_J2000_EPOCH);
+    }
+
+    inline char *writeDate(std::chrono::year_month_day value, char *buf) {
+      int32_t days = int32_t(std::chrono::sys_days(value).time_since_epoch().count());
+      return write(days - DAYS_UNIX_TO_J2000_EPOCH, buf);
+    }
+#endif
+
+  } // namespace postgres
+}   // namespace db
@@ -0,0 +1,219 @@
+/**
+ * Copyright (c) 2016 Philippe FERDINAND
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ **/
+#pragma once
+
+#include "postgres-pool.h"
+
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace db {
+  namespace postgres {
+
+    /**
+     * Databases sharing the rows of the same tables, split by a shard key.
+     *
+     * Each shard is a pool of connections to one database. A shard key is
+     * mapped to a shard by consistent hashing: each shard owns many points
+     * (virtual nodes) on a ring of hashes, and a key belongs to the shard
+     * owning the first point after the hash of the key.
+     *
+     * ```
+     * ShardedCluster cluster;
+     * cluster.add("eu", std::make_shared<ConnectionPool>(16, "postgresql://eu/tenants"));
+     * cluster.add("us", std::make_shared<ConnectionPool>(16, "postgresql://us/tenants"));
+     *
+     * // On the shard of the tenant.
+     * ResultSet users = cluster.execute(tenant_id, "SELECT * FROM users WHERE tenant_id=$1", tenant_id);
+     *
+     * // On all the shards.
+     * std::vector<ResultSet> counts = cluster.scatter("SELECT count(*) FROM users");
+     * ```
+     *
+     * Adding or removing a shard only moves the keys of the points it owns,
+     * about `1/N` of the keys for N shards: locate() tells the shard of a key
+     * before and after such a change, to know which rows to move. Shards can
+     * be added and removed while other threads execute queries.
+     *
+     * Shard keys are integers or strings.
+     **/
+    class ShardedCluster {
+    public:
+
+      /**
+       * Constructor.
+       *
+       * @param vnodes Number of points on the ring for a shard of weight 1.
+       *               The more points, the more even the distribution of the
+       *               keys.
+       **/
+      explicit ShardedCluster(size_t vnodes = 160);
+
+      /**
+       * Add a shard.
+       *
+       * @param name   Name of the shard, the points of the shard on the ring
+       *               depend only on its name.
+       * @param pool   The connections to the database of the shard.
+       * @param weight Relative share of the keys.
+       **/
+      void add(const std::string &name, std::shared_ptr<ConnectionPool> pool, size_t weight = 1);
+
+      /**
+       * Remove a shard.
+       *
+       * @param name Name of the shard.
+       **/
+      void remove(const std::string &name);
+
+      /**
+       * Number of shards.
+       **/
+      size_t size() const;
+
+      /**
+       * Name of the shard of a key.
+       **/
+      template<typename Key>
+      std::string locate(const Key &key) const {
+        auto ring = snapshot();
+        return ring->nodes[ring->find(hash(key))].name;
+      }
+
+      /**
+       * Connections to the shard of a key.
+       **/
+      template<typename Key>
+      std::shared_ptr<ConnectionPool> shard(const Key &key) const {
+        auto ring = snapshot();
+        return ring->nodes[ring->find(hash(key))].pool;
+      }
+
+      /**
+       * Execute an SQL command on the shard of a key.
+       *
+       * @param key  The shard key.
+       * @param sql  The SQL command.
+       * @param args Parameters of the SQL command (see Connection::execute()).
+       * @return The rows returned by the command.
+       **/
+      template<typename Key, typename... Args>
+      ResultSet execute(const Key &key, const char *sql, Args... args) {
+        auto cnx = shard(key)->acquire();
+        return cnx->execute(sql, args...).detach();
+      }
+
+      /**
+       * Execute an SQL command on all the shards concurrently.
+       *
+       * The command is sent to all the shards before waiting for the results:
+       * the elapsed time is the one of the slowest shard.
+       *
+       * @param sql  The SQL command.
+       * @param args Parameters of the SQL command (see Connection::execute()).
+       * @return The rows returned by each shard, in the order the shards were
+       *         added. If the command fails on a shard, the first error is
+       *         raised once all the shards are done.
+       **/
+      template<typename... Args>
+      std::vector<ResultSet> scatter(const char *sql, Args... args) {
+        auto ring = snapshot();
+        std::vector<ConnectionPool::Lease> leases;
+        for (auto &node: ring->nodes) {
+          leases.push_back(node.pool->acquire());
+        }
+
+        std::exception_ptr error;
+        std::vector<bool> sent(leases.size(), false);
+        for (size_t i = 0; i < leases.size(); i++) {
+          try {
+            leases[i]->send(Format::BINARY, sql, args...);
+            sent[i] = true;
+          }
+          catch (...) {
+            if (!error) {
+              error = std::current_exception();
+            }
+          }
+        }
+        return gather(leases, sent, error);
+      }
+
+    private:
+
+      /**
+       * A shard.
+       **/
+      struct Node {
+        std::string name;
+        std::shared_ptr<ConnectionPool> pool;
+        size_t weight;
+      };
+
+      /**
+       * An immutable state of the ring, replaced when shards are added or
+       * removed.
+       **/
+      struct Ring {
+        std::vector<Node> nodes;
+        std::vector<std::pair<uint64_t, size_t>> points;  /**< Sorted hashes of the points and their node. **/
+
+        /**
+         * Node owning a hash.
+         **/
+        size_t find(uint64_t hash) const;
+      };
+
+      size_t vnodes_;
+      std::shared_ptr<const Ring> ring_;    /**< Accessed with std::atomic_load() and std::atomic_store(). **/
+      std::mutex mutex_;                    /**< Serializes the changes of the ring. **/
+
+      std::shared_ptr<const Ring> snapshot() const;
+
+      /**
+       * Replace the ring by a ring made of some nodes.
+       **/
+      void rebuild(std::vector<Node> nodes);
+
+      /**
+       * Receive the results of the command sent to the shards.
+       **/
+      static std::vector<ResultSet> gather(std::vector<ConnectionPool::Lease> &leases,
+                                           const std::vector<bool> &sent,
+                                           std::exception_ptr error);
+
+      static uint64_t hash(int64_t key) noexcept;
+      static uint64_t hash(const std::string &key) noexcept;
+      static uint64_t hash(const char *key) noexcept;
+
+      ShardedCluster(const ShardedCluster&) = delete;
+      ShardedCluster(const ShardedCluster&&) = delete;
+      ShardedCluster& operator = (const ShardedCluster&) = delete;
+      ShardedCluster& operator = (const ShardedCluster&&) = delete;
+    };
+
+  } // namespace postgres
+}   // namespace db
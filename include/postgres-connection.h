@@ -27,6 +27,8 @@
 #include <functional>
 #include <memory>
 #include <cstddef>
+#include <utility>
+#include <vector>
 
 namespace db {
   namespace postgres {
@@ -45,12 +47,26 @@ namespace db {
       bool emptyStringAsNull = true;
     };
 
+    /**
+     * Format of the results of a query.
+     **/
+    enum class Format {
+      TEXT = 0,  /**< Values as printed by the server, parsed when read. **/
+      BINARY = 1 /**< Values in binary format (the default). **/
+    };
+
     /**
      * A connection to a PostgreSQL database.
      **/
     class Connection : public std::enable_shared_from_this<Connection> {
 
+      friend class CopyLoader;
+      friend class FanOut;
+      friend class Params;
+      friend class Multiplexer;
+      friend class Reactor;
       friend class Result;
+      friend class ShardedCluster;
 
       public:
       
@@ -87,6 +103,17 @@ namespace db {
          * @return The connection itself.
          **/
         Connection &connect(const char *connInfo = nullptr);
+
+        /**
+         * Resolve the OIDs of the types registered in the TypeRegistry.
+         *
+         * The types are resolved by connect(). This method must be called
+         * again for the types registered or created in the database once the
+         * connection is open, before they are used.
+         *
+         * @return The connection itself.
+         **/
+        Connection &resolveTypes();
       
         /**
          * Close the database connection.
@@ -135,7 +162,17 @@ namespace db {
            timestamp with time zone    | db::postgres::timestamptz_t
            interval                    | db::postgres::interval_t
            time with time zone         | db::postgres::timetz_t
-
+           numeric                     | db::postgres::numeric_t
+           uuid                        | db::postgres::uuid_t
+           macaddr                     | db::postgres::macaddr_t
+           inet, cidr                  | db::postgres::inet_t
+           json                        | db::postgres::json_t
+           jsonb                       | db::postgres::jsonb_t
+
+         * Other types can be used once registered in the TypeRegistry. The
+         * `std::chrono` time points and durations are sent as
+         * `timestamp with time zone` and `interval`, and with C++17 an empty
+         * `std::optional` is sent as `null`.
          *
          * ```
 
@@ -193,10 +230,33 @@ namespace db {
          **/
         template<typename... Args>
         Result &execute(const char *sql, Args... args) {
-          Params params(settings_, sizeof...(args));
-          std::make_tuple((params.bind(std::forward<Args>(args)), 0)...);
-          execute(sql, params);
-          return result_;
+          return execute(Format::BINARY, sql, args...);
+        }
+
+        /**
+         * Execute one or more SQL commands with results in a given format.
+         *
+         * Rows are read the same way whatever the format of the results: the
+         * values in text format are parsed by Row::as() and Row::asArray(),
+         * except records and types registered in the TypeRegistry that are
+         * only read in binary format. The text format is useful for types
+         * with no binary decoding, which can be read as `std::string`.
+         *
+         * ```
+         * auto &result = cnx.execute(Format::TEXT, "SELECT emp_no, hire_date FROM employees");
+         * ```
+         *
+         * The results of multiple SQL commands are always in text format.
+         *
+         * @param format Format of the results.
+         * @param sql    One or more SQL commands to be executed.
+         * @param args   Zero or more parameters of the SQL command.
+         * @return The results of the SQL commands.
+         **/
+        template<typename... Args>
+        Result &execute(Format format, const char *sql, Args... args) {
+          send(format, sql, args...);
+          return receive();
         }
 
         /**
@@ -267,9 +327,42 @@ namespace db {
         int transaction_;
 
         /**
-         * Private implementation of the exectute public method.
+         * OIDs of the types registered in the TypeRegistry, indexed by
+         * type_codec::id. Each item holds the OID of the type and the OID of
+         * its array type.
+         **/
+        std::vector<std::pair<Oid, Oid>> types_;
+
+        /**
+         * OID of a type registered in the TypeRegistry, as resolved by
+         * resolveTypes(). No query is executed: parameters can be bound while
+         * other queries are in progress.
+         *
+         * @param id    Index of the type in the registry.
+         * @param array If true, the OID of the array type is returned.
+         **/
+        Oid typeOid(size_t id, bool array) const;
+
+        /**
+         * Send SQL commands without waiting for their results.
+         *
+         * execute() is send() followed by receive(). Sending commands on
+         * several connections before receiving their results lets the servers
+         * execute them concurrently.
+         **/
+        template<typename... Args>
+        void send(Format format, const char *sql, Args... args) {
+          Params params(*this, sizeof...(args));
+          std::make_tuple((params.bind(std::forward<Args>(args)), 0)...);
+          send(sql, params, format);
+        }
+
+        void send(const char *sql, const Params &params, Format format);
+
+        /**
+         * Wait for the first results of the SQL commands sent.
          **/
-        void execute(const char *sql, const Params &params);
+        Result &receive();
 
         Connection(const Connection&) = delete;
         Connection(const Connection&&) = delete;
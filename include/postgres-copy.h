@@ -0,0 +1,208 @@
+/**
+ * Copyright (c) 2016 Philippe FERDINAND
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ **/
+#pragma once
+
+#include "postgres-connection.h"
+
+#include <string>
+#include <vector>
+
+namespace db {
+  namespace postgres {
+
+    /**
+     * A file loaded into a table over several connections with COPY.
+     *
+     * The file is memory-mapped and split into chunks on record boundaries.
+     * Each connection runs in its own thread, takes the chunks not yet
+     * loaded, checks their records and streams the valid ones with
+     * `COPY ... FROM STDIN`. The threads share the parsing of the file and
+     * the servers share the parsing of the rows.
+     *
+     * ```
+     * std::vector<Connection *> connections = ...;
+     * CopyLoader loader(connections);
+     * size_t rows = loader.format(CopyLoader::FileFormat::CSV).header(true).load("employees.csv", "employees");
+     * ```
+     *
+     * Each connection loads its chunks in a transaction, and all the
+     * transactions are committed once all the chunks are loaded: if the
+     * server rejects a row, all the transactions are rolled back. Records
+     * that cannot be parsed are reported by errors() and skipped, up to the
+     * limit set by rejects().
+     *
+     * The transactions are committed one after the other: a connection lost
+     * while committing leaves the rows of the connections committed before
+     * it, reported by committed(), the next ones being rolled back. With
+     * twoPhase(), the transactions are all prepared before being committed,
+     * so that none is committed unless all of them can be.
+     *
+     * A connection sends a chunk only once the server has accepted the
+     * previous one in its socket buffer: a slow server slows the parsing
+     * down instead of growing the memory.
+     *
+     * @attention A unique key found twice in the file must be loaded by the
+     * same connection: on two connections the second insert waits for the
+     * transaction of the first one, which is committed only once all the
+     * chunks are loaded.
+     *
+     * @attention Not available on Windows.
+     **/
+    class CopyLoader {
+    public:
+
+      /**
+       * Format of the file.
+       **/
+      enum class FileFormat {
+        CSV,      /**< `FORMAT csv`, with `"` as quote and escape character. **/
+        TEXT,     /**< `FORMAT text`, the default format of COPY. **/
+        BINARY    /**< `FORMAT binary`. **/
+      };
+
+      /**
+       * A record that cannot be loaded.
+       **/
+      struct Error {
+        size_t connection;    /**< Index of the connection loading the record. **/
+        size_t offset;        /**< Offset of the record in the file, or SIZE_MAX for an error of the server. **/
+        std::string message;
+      };
+
+      /**
+       * Constructor.
+       *
+       * @param connections Connections with no transaction in progress.
+       **/
+      explicit CopyLoader(std::vector<Connection *> connections);
+
+      /**
+       * Format of the file, CSV by default.
+       **/
+      CopyLoader &format(FileFormat format);
+
+      /**
+       * Whether the first line of a CSV or text file is a header to skip.
+       **/
+      CopyLoader &header(bool header);
+
+      /**
+       * Delimiter of the columns in CSV and text formats, by default `,` in
+       * CSV and a tab in text.
+       **/
+      CopyLoader &delimiter(char delimiter);
+
+      /**
+       * Number of fields of a record. Records with another number of fields
+       * are rejected. By default the number of fields of the first record.
+       **/
+      CopyLoader &fields(size_t count);
+
+      /**
+       * Approximate size of the chunks, 1 MiB by default.
+       **/
+      CopyLoader &chunkSize(size_t size);
+
+      /**
+       * Maximum number of records rejected before the load fails, 0 by
+       * default.
+       **/
+      CopyLoader &rejects(size_t max);
+
+      /**
+       * Whether the transactions are committed in two phases, with
+       * `PREPARE TRANSACTION` and `COMMIT PREPARED`, false by default. The
+       * server must allow as many prepared transactions
+       * (`max_prepared_transactions`) as there are connections. A
+       * transaction that cannot be committed once all are prepared is left
+       * prepared, reported by errors() with its identifier.
+       **/
+      CopyLoader &twoPhase(bool enabled);
+
+      /**
+       * Load a file.
+       *
+       * @param path    The file.
+       * @param table   The table, inserted as is in the COPY command.
+       * @param columns The columns of the table in the file separated by
+       *                commas, all the columns by default.
+       * @return The number of rows loaded.
+       *
+       * An ExecutionException is raised if the server rejects a row or too
+       * many records are rejected: nothing is loaded then. It is raised as
+       * well if a transaction cannot be committed, committed() telling the
+       * connections whose rows are loaded.
+       **/
+      size_t load(const char *path, const char *table, const char *columns = nullptr);
+
+      /**
+       * Records rejected and errors of the server during the last load.
+       **/
+      const std::vector<Error> &errors() const noexcept;
+
+      /**
+       * Indexes of the connections whose transaction is committed by the
+       * last load, all of them unless the load failed.
+       **/
+      const std::vector<size_t> &committed() const noexcept;
+
+    private:
+
+      std::vector<Connection *> connections_;
+      FileFormat format_;
+      bool header_;
+      char delimiter_;
+      size_t fields_;
+      size_t chunkSize_;
+      size_t rejects_;
+      bool twoPhase_;
+      std::vector<Error> errors_;
+      std::vector<size_t> committed_;
+
+      /**
+       * Offsets of the chunks of a file, the last one being the end of the
+       * file.
+       **/
+      std::vector<size_t> split(const char *data, size_t begin, size_t end);
+
+      /**
+       * End of the record starting at `p`.
+       *
+       * @param fields Set to the number of fields of the record, 0 if the
+       *               record is malformed.
+       **/
+      const char *record(const char *p, const char *end, size_t &fields) const noexcept;
+
+      /**
+       * Commit the transactions of the connections in two phases.
+       *
+       * @param error Set to the last error.
+       * @return true if all the transactions are committed.
+       **/
+      bool commitPrepared(std::string &error);
+
+      CopyLoader(const CopyLoader&) = delete;
+      CopyLoader& operator = (const CopyLoader&) = delete;
+    };
+
+  } // namespace postgres
+}   // namespace db
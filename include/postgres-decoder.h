@@ -0,0 +1,227 @@
+/**
+ * Copyright (c) 2016 Philippe FERDINAND
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ **/
+#pragma once
+
+#include "postgres-result.h"
+#include "postgres-workers.h"
+
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace db {
+  namespace postgres {
+
+    /**
+     * Parallel decoding of the rows of a Result.
+     *
+     * Chunks of rows are detached from the result on the calling thread (the
+     * one owning the connection) and decoded into user objects by the
+     * workers of a WorkerPool, so one connection can keep several cores busy.
+     *
+     * ```
+     * WorkerPool pool;
+     * ParallelDecoder<Employee> decoder(pool, [](const Row &row) {
+     *   return Employee { row.as<int32_t>(0), row.as<std::string>(1) };
+     * });
+     *
+     * decoder.run(cnx.execute("SELECT emp_no, first_name FROM employees"),
+     *   [](std::vector<Employee> &employees) {
+     *     ...
+     *   });
+     * ```
+     *
+     * At most twice as many chunks as workers are detached and not yet
+     * delivered, whether being decoded or waiting for a previous chunk.
+     **/
+    template <typename T>
+    class ParallelDecoder {
+    public:
+
+      typedef std::function<T(const Row &)> decoder_t;
+      typedef std::function<void(std::vector<T> &)> consumer_t;
+
+      /**
+       * Constructor.
+       *
+       * @param pool      The workers decoding the rows.
+       * @param decoder   The function decoding a row. It is called
+       *                  concurrently from the workers.
+       * @param ordered   If true (the default), decoded chunks are delivered
+       *                  in the order of the result. Otherwise they are
+       *                  delivered as soon as they are decoded.
+       * @param chunkSize Number of rows decoded by a task.
+       **/
+      ParallelDecoder(WorkerPool &pool, decoder_t decoder, bool ordered = true, size_t chunkSize = 1000)
+        : pool_(pool), decoder_(decoder), ordered_(ordered), chunkSize_(chunkSize) {
+      }
+
+      /**
+       * Decode all the rows of a result.
+       *
+       * @param result   The result to decode.
+       * @param consumer The function receiving the decoded chunks. It is
+       *                 always called from the calling thread.
+       *
+       * Exceptions raised by the decoder or the consumer are rethrown once
+       * the tasks in progress are completed.
+       **/
+      void run(Result &result, consumer_t consumer) {
+        State state;
+        size_t submitted = 0;
+        size_t maxPending = 2 * pool_.size();
+
+        try {
+          for (;;) {
+            ResultSet chunk = result.detach(chunkSize_);
+            if (chunk.empty()) {
+              break;
+            }
+
+            // Backpressure: deliver decoded chunks while too many are pending.
+            // Chunks decoded out of order wait for the previous ones and
+            // count as pending.
+            deliver(state, consumer, [&state, maxPending] {
+              return state.pending + state.decoded.size() < maxPending || state.error;
+            });
+            if (state.error) {
+              break;
+            }
+
+            submit(state, std::move(chunk), submitted++);
+          }
+
+          deliver(state, consumer, [&state] { return state.pending == 0; });
+        }
+        catch (...) {
+          // Tasks in progress are referencing the state.
+          std::unique_lock<std::mutex> lock(state.mutex);
+          state.done.wait(lock, [&state] { return state.pending == 0; });
+          throw;
+        }
+
+        if (state.error) {
+          std::rethrow_exception(state.error);
+        }
+      }
+
+    private:
+      WorkerPool &pool_;
+      decoder_t decoder_;
+      bool ordered_;
+      size_t chunkSize_;
+
+      /**
+       * State of a run shared with the tasks.
+       **/
+      struct State {
+        std::mutex mutex;
+        std::condition_variable done;
+        std::map<size_t, std::vector<T>> decoded;  /**< Chunks by sequence. **/
+        size_t pending = 0;                         /**< Chunks being decoded. **/
+        size_t next = 0;                            /**< Next chunk to deliver in order. **/
+        std::exception_ptr error;
+      };
+
+      /**
+       * Submit the decoding of a chunk to the pool.
+       **/
+      void submit(State &state, ResultSet &&chunk, size_t sequence) {
+        {
+          std::lock_guard<std::mutex> lock(state.mutex);
+          state.pending++;
+        }
+
+        // std::function requires a copyable task.
+        std::shared_ptr<ResultSet> rows = std::make_shared<ResultSet>(std::move(chunk));
+        decoder_t &decoder = decoder_;
+        pool_.submit([&state, &decoder, rows, sequence]() {
+          std::vector<T> values;
+          std::exception_ptr error;
+          try {
+            values.reserve(rows->size());
+            for (auto &row: *rows) {
+              values.push_back(decoder(row));
+            }
+          }
+          catch (...) {
+            error = std::current_exception();
+          }
+
+          // Notify under the lock: the state is gone as soon as run() sees
+          // that nothing is pending anymore.
+          std::lock_guard<std::mutex> lock(state.mutex);
+          if (error) {
+            if (!state.error) {
+              state.error = error;
+            }
+          }
+          else {
+            state.decoded.emplace(sequence, std::move(values));
+          }
+          state.pending--;
+          state.done.notify_one();
+        });
+      }
+
+      /**
+       * Deliver decoded chunks to the consumer until `until` is satisfied.
+       **/
+      template <typename Predicate>
+      void deliver(State &state, consumer_t &consumer, Predicate until) {
+        std::unique_lock<std::mutex> lock(state.mutex);
+        for (;;) {
+          std::vector<std::vector<T>> ready;
+          auto it = state.decoded.begin();
+          while (it != state.decoded.end() && (!ordered_ || it->first == state.next)) {
+            ready.push_back(std::move(it->second));
+            it = state.decoded.erase(it);
+            state.next++;
+          }
+
+          if (!ready.empty()) {
+            // The consumer is called without holding the lock.
+            lock.unlock();
+            for (auto &values: ready) {
+              consumer(values);
+            }
+            lock.lock();
+            continue;
+          }
+
+          if (until()) {
+            return;
+          }
+          state.done.wait(lock);
+        }
+      }
+
+      ParallelDecoder(const ParallelDecoder&) = delete;
+      ParallelDecoder& operator = (const ParallelDecoder&) = delete;
+    };
+
+  } // namespace postgres
+}   // namespace db
@@ -0,0 +1,188 @@
+/**
+ * Copyright (c) 2016 Philippe FERDINAND
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ **/
+#pragma once
+
+#include "postgres-connection.h"
+
+#include <cassert>
+#include <functional>
+#include <vector>
+
+namespace db {
+  namespace postgres {
+
+    /**
+     * The same query executed concurrently on several connections, with the
+     * rows of all the connections merged into a single stream.
+     *
+     * The query is sent to all the connections before reading any row, so
+     * the servers execute it concurrently and the elapsed time is the one of
+     * the slowest server. Rows are streamed from each connection, in the
+     * order they arrive or merged by a key when each connection returns rows
+     * sorted by that key.
+     *
+     * ```
+     * FanOut fanout;
+     * fanout.orderBy(FanOut::ascending<timestamptz_t>(0)).limit(100);
+     * for (auto &shard: shards) {
+     *   fanout.execute(*shard, "SELECT created_at, id FROM events WHERE tenant=$1 ORDER BY created_at LIMIT 100", tenant);
+     * }
+     * while (const Row *row = fanout.next()) {
+     *   ...
+     * }
+     * ```
+     *
+     * Each connection can execute a different query, e.g. the same query
+     * bound to the range of a partition. Once the limit is reached or the
+     * fan-out is destroyed, the queries still in progress are cancelled.
+     **/
+    class FanOut {
+    public:
+
+      /**
+       * Order of two rows: true if the first row comes before the second one.
+       **/
+      typedef std::function<bool(const Row &, const Row &)> comparator_t;
+
+      /**
+       * Constructor.
+       **/
+      FanOut();
+
+      /**
+       * Destructor.
+       *
+       * The queries still in progress are cancelled.
+       **/
+      ~FanOut();
+
+      /**
+       * Send a query on a connection.
+       *
+       * @param cnx  The connection, with no query in progress until the end of
+       *             the fan-out.
+       * @param sql  A single SQL command.
+       * @param args Parameters of the SQL command (see Connection::execute()).
+       * @return The fan-out itself.
+       **/
+      template<typename... Args>
+      FanOut &execute(Connection &cnx, const char *sql, Args... args) {
+        assert(!started_);  // queries must be sent before reading the rows.
+        cnx.send(Format::BINARY, sql, args...);
+        streams_.push_back({ &cnx, false, false });
+        return *this;
+      }
+
+      /**
+       * Merge the rows by a key.
+       *
+       * @param less Order of the rows, each connection must return its rows
+       *             in this order. Rows are merged with a k-way merge.
+       * @return The fan-out itself.
+       **/
+      FanOut &orderBy(comparator_t less);
+
+      /**
+       * Maximum number of rows.
+       *
+       * @return The fan-out itself.
+       **/
+      FanOut &limit(size_t rows);
+
+      /**
+       * Get the next row.
+       *
+       * @return The next row, valid until the next call, or nullptr after the
+       *         last row.
+       **/
+      const Row *next();
+
+      /**
+       * Index of the connection of the last row returned by next(), in the
+       * order of the calls to execute().
+       **/
+      size_t source() const noexcept;
+
+      /**
+       * Ascending order of a column.
+       **/
+      template<typename T>
+      static comparator_t ascending(int column) {
+        return [column](const Row &a, const Row &b) {
+          return a.as<T>(column) < b.as<T>(column);
+        };
+      }
+
+      /**
+       * Descending order of a column.
+       **/
+      template<typename T>
+      static comparator_t descending(int column) {
+        return [column](const Row &a, const Row &b) {
+          return b.as<T>(column) < a.as<T>(column);
+        };
+      }
+
+    private:
+
+      /**
+       * Rows of a connection.
+       **/
+      struct Stream {
+        Connection *cnx;
+        bool started;     /**< The first result has been received. **/
+        bool done;        /**< No more rows. **/
+      };
+
+      std::vector<Stream> streams_;
+      comparator_t less_;
+      size_t limit_;
+      size_t count_;                 /**< Number of rows returned. **/
+      size_t last_;                  /**< Stream of the last row returned, to be advanced. **/
+      bool started_;
+      std::vector<size_t> ready_;    /**< Streams with a row, a heap when ordered by a key. **/
+
+      /**
+       * Receive the next row of a stream.
+       *
+       * @return true if a row is available.
+       **/
+      bool advance(size_t index);
+
+      /**
+       * Wait until a stream in progress can be advanced without blocking.
+       **/
+      void wait();
+
+      /**
+       * Cancel the queries in progress.
+       **/
+      void stop() noexcept;
+
+      FanOut(const FanOut&) = delete;
+      FanOut(const FanOut&&) = delete;
+      FanOut& operator = (const FanOut&) = delete;
+      FanOut& operator = (const FanOut&&) = delete;
+    };
+
+  } // namespace postgres
+}   // namespace db
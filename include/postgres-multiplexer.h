@@ -0,0 +1,194 @@
+/**
+ * Copyright (c) 2016 Philippe FERDINAND
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ **/
+#pragma once
+
+#include "postgres-connection.h"
+
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <string>
+#include <thread>
+
+namespace db {
+  namespace postgres {
+
+    /**
+     * Many threads sharing a single connection running in pipeline mode.
+     *
+     * Queries executed from any thread are queued on a lock-free queue. An
+     * I/O thread owning the connection sends the queued queries in batches
+     * without waiting for the results of the previous ones, and reads the
+     * results in order to fulfill the futures returned to the callers.
+     *
+     * ```
+     * auto cnx = std::make_shared<Connection>();
+     * cnx->connect();
+     * Multiplexer mux(cnx);
+     *
+     * // From any thread.
+     * std::future<ResultSet> future = mux.execute("SELECT * FROM employees WHERE emp_no=$1", emp_no);
+     * ResultSet rows = future.get();
+     * ```
+     *
+     * Each query is followed by a synchronization point: queries run in their
+     * own implicit transaction and the failure of a query does not affect the
+     * others. Explicit transactions are not supported as the queries of
+     * different threads are interleaved.
+     *
+     * @attention Requires libpq 14 or later (pipeline mode). Not available on
+     *            Windows.
+     **/
+    class Multiplexer {
+    public:
+
+      /**
+       * Constructor.
+       *
+       * @param cnx   An open connection with no query in progress. Until the
+       *              multiplexer is destroyed, the connection must only be used
+       *              through the multiplexer.
+       * @param batch Maximum number of queries sent before reading the
+       *              available results.
+       *
+       * The types registered in the TypeRegistry are resolved before the
+       * connection enters the pipeline mode (see Connection::resolveTypes()).
+       **/
+      explicit Multiplexer(std::shared_ptr<Connection> cnx, size_t batch = 256);
+
+      /**
+       * Destructor.
+       *
+       * Queries already executed are completed before the I/O thread is
+       * stopped. The connection is switched back to the blocking mode.
+       **/
+      ~Multiplexer();
+
+      /**
+       * Execute an SQL command. This method is thread-safe.
+       *
+       * @param sql  The SQL command. Only a single command is supported.
+       * @param args Zero or more parameters of the SQL command (see
+       *             Connection::execute()). Parameters are copied, except
+       *             `const char *` strings and views such as json_t that must
+       *             remain valid until the future is ready.
+       * @return The rows returned by the command. The future raises an
+       *         ExecutionException if the command fails, or a
+       *         ConnectionException if the connection is lost.
+       **/
+      template<typename... Args>
+      std::future<ResultSet> execute(const char *sql, Args... args) {
+        std::unique_ptr<Query> query(new Query());
+        query->sql = sql;
+        query->size = sizeof...(args);
+        query->bind = [args...](Params &params) {
+          std::make_tuple((params.bind(args), 0)...);
+        };
+        std::future<ResultSet> future = query->promise.get_future();
+        push(query.release());
+        return future;
+      }
+
+    private:
+
+      /**
+       * Node of the lock-free queue.
+       **/
+      struct Node {
+        std::atomic<Node *> next;
+      };
+
+      /**
+       * A query waiting to be sent or waiting for its results.
+       **/
+      struct Query : Node {
+        std::string sql;
+        int size;                              /**< Number of parameters. **/
+        std::function<void(Params &)> bind;    /**< Binds the copied parameters. **/
+        std::promise<ResultSet> promise;
+        ResultSet rows;                        /**< Rows received. **/
+        std::exception_ptr error;
+      };
+
+      std::shared_ptr<Connection> cnx_;
+      size_t batch_;
+
+      // Multiple producers single consumer queue (D. Vyukov's intrusive queue).
+      std::atomic<Node *> head_;               /**< Last query pushed by the producers. **/
+      Node *tail_;                             /**< Next query popped by the I/O thread. **/
+      Node stub_;
+
+      std::deque<std::unique_ptr<Query>> sent_;  /**< Queries waiting for their results. **/
+      std::atomic<bool> sleeping_;             /**< The I/O thread is waiting for events. **/
+      std::atomic<bool> stopped_;
+      int wakeup_[2];                          /**< Pipe waking up the I/O thread. **/
+      std::thread thread_;
+
+      /**
+       * Queue a query (any thread).
+       **/
+      void push(Query *query);
+
+      /**
+       * Get the next queued query (I/O thread).
+       **/
+      Query *pop();
+
+      /**
+       * Body of the I/O thread.
+       **/
+      void run();
+
+      /**
+       * Send a batch of queued queries.
+       *
+       * @return The number of queries sent.
+       **/
+      size_t send();
+
+      /**
+       * Read the available results and fulfill the completed queries.
+       *
+       * @return false if the connection is lost.
+       **/
+      bool receive();
+
+      /**
+       * Fail all the queries waiting for their results.
+       **/
+      void fail(std::exception_ptr error);
+
+      /**
+       * Wake up the I/O thread.
+       **/
+      void notify();
+
+      Multiplexer(const Multiplexer&) = delete;
+      Multiplexer(const Multiplexer&&) = delete;
+      Multiplexer& operator = (const Multiplexer&) = delete;
+      Multiplexer& operator = (const Multiplexer&&) = delete;
+    };
+
+  } // namespace postgres
+}   // namespace db
@@ -21,6 +21,8 @@
  **/
 #pragma once
 
+#include "postgres-chrono.h"
+#include "postgres-registry.h"
 #include "postgres-types.h"
 
 #include <string>
@@ -29,12 +31,33 @@
 namespace db {
   namespace postgres {
 
+    class Connection;
+
+    class Params;
+
+    /**
+     * Binding of the parameters that have no overload of Params::bind():
+     * types registered in the TypeRegistry and, depending on the C++ standard
+     * of the application, `std::optional` and `std::chrono::year_month_day`.
+     * Those are specializations rather than overloads so that Params is the
+     * same class in the library and in the application.
+     **/
+    template<typename T>
+    struct value_encoder {
+      static void bind(Params &params, const T &v);
+    };
+
     /**
      * A private class to bind SQL command parameters.
      **/
     class Params {
 
       friend class Connection;
+      friend class Multiplexer;
+      friend class Reactor;
+
+      template<typename T>
+      friend struct value_encoder;
 
     private:
       std::vector<Oid>      types_;
@@ -43,10 +66,16 @@ namespace db {
       std::vector<int>      formats_;
       std::vector<char *>   buffers_;
       const struct Settings &settings_;
+      Connection            &conn_;
 
-      Params(const Settings &settings, int size);
+      Params(Connection &conn, int size);
       ~Params();
 
+      /**
+       * OID of a type registered in the TypeRegistry.
+       **/
+      Oid typeOid(size_t id, bool array) const;
+
       char *bind(Oid type, size_t length);
 
       void bind() const {}
@@ -62,6 +91,19 @@ namespace db {
       template <typename T>
       T *bind(Oid type, size_t length);
 
+      /**
+       * std::chrono types
+       **/
+      template<typename Duration>
+      void bind(std::chrono::time_point<std::chrono::system_clock, Duration> v) {
+        writeTimePoint(v, bind(TIMESTAMPTZOID, sizeof(int64_t)));
+      }
+
+      template<typename Rep, typename Period>
+      void bind(std::chrono::duration<Rep, Period> v) {
+        writeDuration(v, bind(INTERVALOID, sizeof(int64_t) + 2 * sizeof(int32_t)));
+      }
+
       /**
        * Arrays
        **/
@@ -70,7 +112,147 @@ namespace db {
 
       template<typename T>
       void bind(Oid type, Oid elemType, const std::vector<array_item<T>> &array);
+
+      template<typename T>
+      void bind(const compact_array<T> &array);
+
+      template<typename T>
+      void bind(Oid type, Oid elemType, const compact_array<T> &array);
+
+      void bind(const string_array &array);
     };
 
+    /**
+     * Types natively supported.
+     **/
+    template<> void Params::bind(bool v);
+    template<> void Params::bind(int16_t v);
+    template<> void Params::bind(int32_t v);
+    template<> void Params::bind(int64_t v);
+    template<> void Params::bind(float v);
+    template<> void Params::bind(double v);
+    template<> void Params::bind(char v);
+    template<> void Params::bind(const char *v);
+    template<> void Params::bind(date_t v);
+    template<> void Params::bind(timestamptz_t v);
+    template<> void Params::bind(timestamp_t v);
+    template<> void Params::bind(timetz_t v);
+    template<> void Params::bind(time_t v);
+    template<> void Params::bind(interval_t v);
+    template<> void Params::bind(numeric_t v);
+    template<> void Params::bind(uuid_t v);
+    template<> void Params::bind(macaddr_t v);
+    template<> void Params::bind(inet_t v);
+    template<> void Params::bind(json_t v);
+    template<> void Params::bind(jsonb_t v);
+    template<> void Params::bind(range<int32_t> v);
+    template<> void Params::bind(range<int64_t> v);
+    template<> void Params::bind(range<numeric_t> v);
+    template<> void Params::bind(range<date_t> v);
+    template<> void Params::bind(range<timestamp_t> v);
+    template<> void Params::bind(range<timestamptz_t> v);
+    template<> void Params::bind(multirange<int32_t> v);
+    template<> void Params::bind(multirange<int64_t> v);
+    template<> void Params::bind(multirange<numeric_t> v);
+    template<> void Params::bind(multirange<date_t> v);
+    template<> void Params::bind(multirange<timestamp_t> v);
+    template<> void Params::bind(multirange<timestamptz_t> v);
+
+    template<> void Params::bind(const std::vector<array_item<bool>> &array);
+    template<> void Params::bind(const std::vector<array_item<int16_t>> &array);
+    template<> void Params::bind(const std::vector<array_item<int32_t>> &array);
+    template<> void Params::bind(const std::vector<array_item<int64_t>> &array);
+    template<> void Params::bind(const std::vector<array_item<float>> &array);
+    template<> void Params::bind(const std::vector<array_item<double>> &array);
+    template<> void Params::bind(const std::vector<array_item<std::string>> &array);
+    template<> void Params::bind(const std::vector<array_item<date_t>> &array);
+    template<> void Params::bind(const std::vector<array_item<time_t>> &array);
+    template<> void Params::bind(const std::vector<array_item<timetz_t>> &array);
+    template<> void Params::bind(const std::vector<array_item<timestamp_t>> &array);
+    template<> void Params::bind(const std::vector<array_item<timestamptz_t>> &array);
+    template<> void Params::bind(const std::vector<array_item<interval_t>> &array);
+    template<> void Params::bind(const std::vector<array_item<numeric_t>> &array);
+    template<> void Params::bind(const std::vector<array_item<uuid_t>> &array);
+    template<> void Params::bind(const std::vector<array_item<macaddr_t>> &array);
+    template<> void Params::bind(const std::vector<array_item<inet_t>> &array);
+    template<> void Params::bind(const std::vector<array_item<json_t>> &array);
+    template<> void Params::bind(const std::vector<array_item<jsonb_t>> &array);
+    template<> void Params::bind(const std::vector<array_item<range<int32_t>>> &array);
+    template<> void Params::bind(const std::vector<array_item<range<int64_t>>> &array);
+    template<> void Params::bind(const std::vector<array_item<range<numeric_t>>> &array);
+    template<> void Params::bind(const std::vector<array_item<range<date_t>>> &array);
+    template<> void Params::bind(const std::vector<array_item<range<timestamp_t>>> &array);
+    template<> void Params::bind(const std::vector<array_item<range<timestamptz_t>>> &array);
+
+    template<typename T>
+    void Params::bind(T v) {
+      value_encoder<T>::bind(*this, v);
+    }
+
+    /**
+     * Types registered in the TypeRegistry.
+     **/
+    template<typename T>
+    void value_encoder<T>::bind(Params &params, const T &v) {
+      const type_codec<T> *codec = TypeRegistry::find<T>();
+      assert(codec != nullptr); // unsupported type, see TypeRegistry.
+      codec->write(v, params.bind(params.typeOid(codec->id, false), codec->length(v)));
+    }
+
+#if LIBPQMXX_HAS_OPTIONAL
+    template<typename T>
+    struct value_encoder<std::optional<T>> {
+      static void bind(Params &params, const std::optional<T> &v) {
+        if (v) {
+          params.bind(*v);
+        }
+        else {
+          params.bind(nullptr);
+        }
+      }
+    };
+#endif
+
+#if LIBPQMXX_HAS_CALENDAR
+    template<>
+    struct value_encoder<std::chrono::year_month_day> {
+      static void bind(Params &params, const std::chrono::year_month_day &v) {
+        writeDate(v, params.bind(DATEOID, sizeof(int32_t)));
+      }
+    };
+#endif
+
+    template<typename T>
+    void Params::bind(const std::vector<array_item<T>> &array) {
+      const type_codec<T> *codec = TypeRegistry::find<T>();
+      assert(codec != nullptr); // unsupported type, see TypeRegistry.
+
+      size_t bufferSize = 5 * sizeof(int32_t); // array headers
+      for (auto &i: array) {
+        bufferSize += sizeof(int32_t);
+        if (!i.isNull) {
+          bufferSize += codec->length(i.value);
+        }
+      }
+
+      Oid elemType = typeOid(codec->id, false);
+      char *buf = bind(typeOid(codec->id, true), bufferSize);
+      buf = write(int32_t(1), buf);            /* Number of dimensions */
+      buf = write(int32_t(0), buf);            /* ignored */
+      buf = write(int32_t(elemType), buf);     /* type of elements in the array */
+      buf = write(int32_t(array.size()), buf); /* Number of elements */
+      buf = write(int32_t(1), buf);            /* Index of first element */
+      for (auto &i: array) {
+        if (i.isNull) {
+          buf = write(int32_t(-1), buf);
+        }
+        else {
+          char *value = codec->write(i.value, buf + sizeof(int32_t));
+          write(int32_t(value - buf - sizeof(int32_t)), buf);
+          buf = value;
+        }
+      }
+    }
+
   } // namespace postgres
 }   // namespace db
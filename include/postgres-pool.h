@@ -0,0 +1,178 @@
+/**
+ * Copyright (c) 2016 Philippe FERDINAND
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ **/
+#pragma once
+
+#include "postgres-connection.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace db {
+  namespace postgres {
+
+    /**
+     * A pool of connections sharded by core.
+     *
+     * Idle connections are spread over shards, each one with its own lock. A
+     * thread acquires a connection from the shard of the core it is running on
+     * and gives it back to that shard, so the connections and the locks stay
+     * local to a core. When its shard is empty, a thread steals a connection
+     * from the other shards. The cost of a checkout does not depend on the
+     * number of cores.
+     *
+     * ```
+     * ConnectionPool pool(32, "postgresql://localhost/employees");
+     *
+     * // From any thread.
+     * auto cnx = pool.acquire();
+     * cnx->execute("UPDATE titles SET to_date=$1::date WHERE emp_no=$2", "1988-02-10", 10020);
+     * ```
+     **/
+    class ConnectionPool {
+    public:
+
+      /**
+       * A connection acquired from the pool, given back when destroyed.
+       **/
+      class Lease {
+      public:
+        Lease() noexcept;
+        Lease(Lease &&other) noexcept;
+        Lease &operator = (Lease &&other) noexcept;
+        ~Lease();
+
+        Connection &operator *() const noexcept { return *cnx_; }
+        Connection *operator ->() const noexcept { return cnx_; }
+        Connection *get() const noexcept { return cnx_; }
+        explicit operator bool() const noexcept { return cnx_ != nullptr; }
+
+        /**
+         * Give the connection back to the pool.
+         **/
+        void release() noexcept;
+
+      private:
+        friend class ConnectionPool;
+        Lease(ConnectionPool *pool, Connection *cnx) noexcept;
+
+        ConnectionPool *pool_;
+        Connection *cnx_;
+
+        Lease(const Lease&) = delete;
+        Lease& operator = (const Lease&) = delete;
+      };
+
+      /**
+       * Constructor.
+       *
+       * @param size     Number of connections, opened by the constructor.
+       * @param connInfo The connection string (see Connection::connect()).
+       * @param settings Settings of the connections.
+       * @param shards   Number of shards. By default one per core, but no more
+       *                 than the number of connections.
+       **/
+      explicit ConnectionPool(size_t size, const char *connInfo = nullptr,
+                              Settings settings = Settings(), size_t shards = 0);
+
+      /**
+       * Destructor.
+       *
+       * @attention All the connections must have been given back.
+       **/
+      ~ConnectionPool();
+
+      /**
+       * Acquire a connection, waiting for one to be given back if needed.
+       **/
+      Lease acquire();
+
+      /**
+       * Acquire a connection if one is idle.
+       *
+       * @return An empty lease if all the connections are in use.
+       **/
+      Lease tryAcquire();
+
+      /**
+       * Number of connections.
+       **/
+      size_t size() const noexcept;
+
+      /**
+       * Number of shards.
+       **/
+      size_t shards() const noexcept;
+
+      /**
+       * Number of idle connections. The number may be outdated as soon as it
+       * is returned.
+       **/
+      size_t idle() const noexcept;
+
+    private:
+
+      /**
+       * Idle connections of a shard.
+       *
+       * Shards are padded so that two shards never share a cache line.
+       **/
+      struct Shard {
+        std::mutex mutex;
+        std::vector<Connection *> idle;     /**< Last given back first, most likely to be hot in cache. **/
+        std::atomic<size_t> available;      /**< Size of idle, read by stealers without locking. **/
+        char padding[64];
+      };
+
+      std::vector<std::shared_ptr<Connection>> connections_;
+      std::vector<Shard> shards_;
+
+      std::mutex mutex_;                    /**< Protects the sleep of waiting threads. **/
+      std::condition_variable released_;
+      std::atomic<size_t> waiters_;         /**< Number of threads waiting for a connection. **/
+
+      /**
+       * Shard of the core running the current thread.
+       **/
+      size_t local() const noexcept;
+
+      /**
+       * Get an idle connection from the local shard or steal one.
+       **/
+      Connection *pop(size_t index) noexcept;
+
+      /**
+       * Give a connection back to the local shard.
+       **/
+      void push(Connection *cnx) noexcept;
+
+      ConnectionPool(const ConnectionPool&) = delete;
+      ConnectionPool(const ConnectionPool&&) = delete;
+      ConnectionPool& operator = (const ConnectionPool&) = delete;
+      ConnectionPool& operator = (const ConnectionPool&&) = delete;
+    };
+
+  } // namespace postgres
+}   // namespace db
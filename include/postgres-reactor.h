@@ -0,0 +1,286 @@
+/**
+ * Copyright (c) 2016 Philippe FERDINAND
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ **/
+#pragma once
+
+#include "postgres-connection.h"
+
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace db {
+  namespace postgres {
+
+    /**
+     * An event loop driving many connections from a single thread.
+     *
+     * The connections added to the reactor are switched to the non-blocking
+     * mode. Queries are sent to the first idle connection, or queued until a
+     * connection becomes idle, and the sockets of all the connections are
+     * watched with io_uring or epoll: sending, flushing and reading the
+     * results never block the thread.
+     *
+     * ```
+     * Reactor reactor;
+     * for (int i = 0; i < 16; i++) {
+     *   auto cnx = std::make_shared<Connection>();
+     *   cnx->connect();
+     *   reactor.add(cnx);
+     * }
+     *
+     * for (int32_t emp_no: employees) {
+     *   reactor.execute([](ResultSet &rows, std::exception_ptr error) {
+     *     ...
+     *   }, "SELECT * FROM titles WHERE emp_no=$1", emp_no);
+     * }
+     * reactor.run();
+     * ```
+     *
+     * The results of a query are delivered all at once to its callback, as a
+     * ResultSet. The reactor is not thread-safe, except post(): a thread
+     * needing thousands of concurrent queries runs its own reactor, and
+     * queries can be executed from the callbacks or from the tasks posted by
+     * other threads.
+     *
+     * @attention Available on Linux only.
+     **/
+    class Reactor {
+    public:
+
+      /**
+       * Completion callback of a query.
+       *
+       * @param rows  The rows returned by the query.
+       * @param error The error raised by the query, if any.
+       **/
+      typedef std::function<void(ResultSet &rows, std::exception_ptr error)> callback_t;
+
+      /**
+       * Readiness notification backends.
+       **/
+      enum class Backend {
+        AUTO,       /**< io_uring when available, epoll otherwise. **/
+        EPOLL,      /**< One epoll_wait() per wakeup. **/
+        IO_URING    /**< Poll requests re-armed and reaped in batches, one io_uring_enter() per wakeup. **/
+      };
+
+      /**
+       * Constructor.
+       *
+       * @param backend The readiness notification backend. io_uring requires
+       *                Linux 5.5 or later and may be disabled by the system
+       *                (e.g. a seccomp profile): in that case `AUTO` falls
+       *                back to epoll while `IO_URING` raises an
+       *                ExecutionException.
+       **/
+      Reactor(Backend backend = Backend::AUTO);
+
+      /**
+       * Destructor.
+       *
+       * Queries in progress are waited for, but their callbacks are not
+       * called. Connections are switched back to the blocking mode.
+       **/
+      ~Reactor();
+
+      /**
+       * Add a connection to the reactor.
+       *
+       * A connection lost is no longer used by the reactor: its query in
+       * progress fails with a ConnectionException, the queries waiting are
+       * executed by the other connections. Once all the connections are
+       * lost, the queries waiting fail as well.
+       *
+       * @param cnx An open connection with no query in progress. Until the
+       *            reactor is destroyed, the connection must only be used
+       *            through the reactor.
+       **/
+      void add(std::shared_ptr<Connection> cnx);
+
+      /**
+       * Execute an SQL command asynchronously.
+       *
+       * @param callback Called by poll() or run() once the command is
+       *                 completed.
+       * @param sql      The SQL command. Only a single command is supported.
+       * @param args     Zero or more parameters of the SQL command (see
+       *                 Connection::execute()). Parameters are copied, except
+       *                 `const char *` strings and views such as json_t that
+       *                 must remain valid until the callback is called.
+       **/
+      template<typename... Args>
+      void execute(callback_t callback, const char *sql, Args... args) {
+        Query query;
+        query.sql = sql;
+        query.size = sizeof...(args);
+        query.bind = [args...](Params &params) {
+          std::make_tuple((params.bind(args), 0)...);
+        };
+        query.callback = std::move(callback);
+        execute(std::move(query));
+      }
+
+      /**
+       * Post a task to be executed by the thread running the reactor.
+       *
+       * Unlike the other methods, post() can be called from any thread: it
+       * wakes up poll() which executes the posted tasks, typically to
+       * execute queries on behalf of other threads.
+       *
+       * @param task The task to execute.
+       **/
+      void post(std::function<void()> task);
+
+      /**
+       * The readiness notification backend in use (never `AUTO`).
+       **/
+      Backend backend() const noexcept;
+
+      /**
+       * Wait for events and process them.
+       *
+       * @param timeout Maximum time to wait for events, in milliseconds. -1
+       *                waits until at least one event occurs.
+       * @return The number of queries completed.
+       *
+       * Exceptions raised by the callbacks are propagated to the caller.
+       **/
+      size_t poll(int timeout = -1);
+
+      /**
+       * Process the events until all the queries are completed. Tasks posted
+       * later are not waited for.
+       **/
+      void run();
+
+      /**
+       * Number of queries waiting or in progress.
+       **/
+      size_t pending() const noexcept;
+
+    private:
+
+      /**
+       * A query waiting for a connection or in progress.
+       **/
+      struct Query {
+        std::string sql;
+        int size;                              /**< Number of parameters. **/
+        std::function<void(Params &)> bind;    /**< Binds the copied parameters. **/
+        callback_t callback;
+      };
+
+      /**
+       * State of a connection of the reactor.
+       **/
+      struct Channel {
+        std::shared_ptr<Connection> cnx;
+        int socket;
+        bool busy;           /**< A query is in progress. **/
+        bool done;           /**< The query in progress is completed. **/
+        bool writing;        /**< Waiting for the socket to be writable. **/
+        bool broken;         /**< The connection is lost, no longer used. **/
+        Query query;         /**< The query in progress. **/
+        ResultSet rows;      /**< Rows received for the query in progress. **/
+        std::exception_ptr error;
+      };
+
+      class Poller;
+      class EpollPoller;
+      class UringPoller;
+
+      Backend backend_;
+      std::unique_ptr<Poller> poller_;                 /**< The readiness notification backend. **/
+      int wakeup_;                                     /**< eventfd signaled by post(). **/
+      std::mutex mutex_;                               /**< Protects tasks_. **/
+      std::vector<std::function<void()>> tasks_;       /**< Tasks posted by other threads. **/
+      std::vector<std::unique_ptr<Channel>> channels_;
+      std::deque<Query> queue_;                        /**< Queries waiting for a connection. **/
+      std::vector<Channel *> done_;                    /**< Connections with a completed query. **/
+      size_t running_;                                 /**< Number of queries in progress. **/
+
+      /**
+       * Send a query or queue it if there is no idle connection.
+       **/
+      void execute(Query &&query);
+
+      /**
+       * Send a query on an idle connection.
+       **/
+      void send(Channel &channel, Query &&query);
+
+      /**
+       * Flush the data to be sent, and watch the socket for writing if needed.
+       **/
+      void flush(Channel &channel);
+
+      /**
+       * Read the data available on the socket.
+       **/
+      void receive(Channel &channel);
+
+      /**
+       * Stop using a connection lost.
+       **/
+      void lost(Channel &channel);
+
+      /**
+       * Fail the queries waiting once all the connections are lost.
+       *
+       * @return The number of queries failed.
+       **/
+      size_t abandon();
+
+      /**
+       * Mark the query in progress on a connection as completed. Its callback
+       * is called by poll().
+       **/
+      void done(Channel &channel);
+
+      /**
+       * Call the callback of a completed query and send the next query
+       * waiting for a connection.
+       **/
+      void complete(Channel &channel);
+
+      /**
+       * Set the events watched on the socket of a connection.
+       **/
+      void watch(Channel &channel, bool writing);
+
+      /**
+       * Wake up poll() to execute the posted tasks.
+       **/
+      void notify();
+
+      Reactor(const Reactor&) = delete;
+      Reactor(const Reactor&&) = delete;
+      Reactor& operator = (const Reactor&) = delete;
+      Reactor& operator = (const Reactor&&) = delete;
+    };
+
+  } // namespace postgres
+}   // namespace db
@@ -0,0 +1,118 @@
+/**
+ * Copyright (c) 2016 Philippe FERDINAND
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ **/
+#pragma once
+
+#include "postgres-result.h"
+
+#include <condition_variable>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace db {
+  namespace postgres {
+
+    /**
+     * Background read-ahead of a Result.
+     *
+     * A producer thread keeps detaching chunks of rows from the result into a
+     * bounded ring while the consumer processes the current chunk, so the
+     * network latency overlaps with the processing of the rows.
+     *
+     * ```
+     * ReadAhead rows(cnx.execute("SELECT * FROM employees"));
+     * ResultSet chunk;
+     * while (rows.next(chunk)) {
+     *   for (auto &row: chunk) {
+     *     ...
+     *   }
+     * }
+     * ```
+     *
+     * @attention The connection owning the result must not be used until the
+     *            ReadAhead object has been destroyed.
+     **/
+    class ReadAhead {
+    public:
+
+      /**
+       * Constructor.
+       *
+       * The producer thread is started right away.
+       *
+       * @param result    The result to read.
+       * @param chunkSize Maximum number of rows in a chunk.
+       * @param depth     Maximum number of chunks read ahead of the consumer.
+       *                  The default value of 2 gives a double buffering.
+       **/
+      ReadAhead(Result &result, size_t chunkSize = 1000, size_t depth = 2);
+
+      /**
+       * Destructor.
+       *
+       * If all the rows have not been consumed, the producer thread is
+       * stopped and the remaining rows of the result are left on the
+       * connection (they will be discarded by the next query).
+       **/
+      ~ReadAhead();
+
+      /**
+       * Get the next chunk of rows.
+       *
+       * Blocks until a chunk is available. Exceptions raised by the producer
+       * thread are rethrown by this method.
+       *
+       * @param chunk Receives the rows of the next chunk.
+       * @return false if all the rows have been read.
+       **/
+      bool next(ResultSet &chunk);
+
+    private:
+      Result &result_;
+      size_t chunkSize_;
+
+      std::vector<ResultSet> ring_;  /**< Chunks read ahead. **/
+      size_t head_;                  /**< Next chunk to consume. **/
+      size_t count_;                 /**< Number of chunks in the ring. **/
+      bool done_;                    /**< All rows have been read. **/
+      bool stopped_;                 /**< The consumer has gone. **/
+      std::exception_ptr error_;     /**< Error raised by the producer. **/
+
+      std::mutex mutex_;
+      std::condition_variable notEmpty_;
+      std::condition_variable notFull_;
+      std::thread producer_;
+
+      /**
+       * Body of the producer thread.
+       **/
+      void run();
+
+      ReadAhead(const ReadAhead&) = delete;
+      ReadAhead(const ReadAhead&&) = delete;
+      ReadAhead& operator = (const ReadAhead&) = delete;
+      ReadAhead& operator = (const ReadAhead&&) = delete;
+    };
+
+  } // namespace postgres
+}   // namespace db
@@ -0,0 +1,172 @@
+/**
+ * Copyright (c) 2016 Philippe FERDINAND
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ **/
+#pragma once
+
+#include "postgres-types.h"
+
+#include <cassert>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace db {
+  namespace postgres {
+
+    /**
+     * Binary codec of a type registered in the TypeRegistry.
+     **/
+    template<typename T>
+    struct type_codec {
+      size_t      id;   /**< Index of the type in the registry. **/
+      std::string name; /**< SQL name of the type. **/
+
+      /**
+       * Number of bytes of a value in the PostgreSQL binary format.
+       **/
+      std::function<size_t(const T &value)> length;
+
+      /**
+       * Write a value in the PostgreSQL binary format.
+       *
+       * @return The position next to the end of the value in `buf`.
+       **/
+      std::function<char *(const T &value, char *buf)> write;
+
+      /**
+       * Read a value from the PostgreSQL binary format.
+       **/
+      std::function<T(char *buf, size_t length)> read;
+    };
+
+    /**
+     * Registry of user defined types.
+     *
+     * Types that are not natively supported by the library (enums, domains,
+     * composites or types from extensions such as hstore) can be used as
+     * parameters of Connection::execute() and read with Row::as() and
+     * Row::asArray() once a binary codec has been registered for the C++ type.
+     *
+     * The OID of those types is not known in advance: it is resolved by name
+     * when a connection is opened, using a single lookup into `pg_type` for
+     * all the registered types, and cached for the lifetime of the connection
+     * (see Connection::resolveTypes()). Any name accepted by `to_regtype()`
+     * can be used, including schema-qualified names. Values read as a
+     * registered type must have one of the OIDs resolved for that type.
+     *
+     * ```
+     * enum class mood { sad, ok, happy };
+     * static const char *moods[] = { "sad", "ok", "happy" };
+     *
+     * TypeRegistry::add<mood>("mood",
+     *   [](const mood &m) { return strlen(moods[int(m)]); },
+     *   [](const mood &m, char *buf) {
+     *     size_t length = strlen(moods[int(m)]);
+     *     memcpy(buf, moods[int(m)], length);
+     *     return buf + length;
+     *   },
+     *   [](char *buf, size_t length) {
+     *     for (int i = 0; i < 3; i++) {
+     *       if (strncmp(moods[i], buf, length) == 0) return mood(i);
+     *     }
+     *     throw std::runtime_error("unexpected mood");
+     *   });
+     *
+     * cnx.execute("INSERT INTO person VALUES ($1, $2)", "Moe", mood::happy);
+     * mood m = cnx.execute("SELECT current_mood FROM person").as<mood>(0);
+     * ```
+     *
+     * @attention Types must be registered before being used, typically at the
+     *            startup of the application. Registering types is not thread
+     *            safe regarding the use of those types by other threads.
+     *            Connections opened before a type is registered, or before
+     *            it is created in the database, must call
+     *            Connection::resolveTypes().
+     **/
+    class TypeRegistry {
+    public:
+
+      /**
+       * Register a type.
+       *
+       * @param name   SQL name of the type.
+       * @param length Number of bytes of a value in the binary format.
+       * @param write  Write a value in the binary format.
+       * @param read   Read a value from the binary format.
+       **/
+      template<typename T>
+      static void add(const std::string &name,
+                      std::function<size_t(const T &value)> length,
+                      std::function<char *(const T &value, char *buf)> write,
+                      std::function<T(char *buf, size_t length)> read) {
+        std::unique_ptr<type_codec<T>> &codec = slot<T>();
+        assert(!codec); // a C++ type can only be registered once.
+        codec.reset(new type_codec<T> { add(name), name, length, write, read });
+      }
+
+      /**
+       * Codec of a type.
+       *
+       * @return The codec registered for the C++ type `T`, or `nullptr` if
+       *         the type has not been registered.
+       **/
+      template<typename T>
+      static const type_codec<T> *find() noexcept {
+        return slot<T>().get();
+      }
+
+      /**
+       * SQL names of the registered types, indexed by type_codec::id.
+       **/
+      static std::vector<std::string> names();
+
+      /**
+       * Check the type of a value read as a registered type.
+       *
+       * @param id    Index of the type in the registry.
+       * @param oid   OID of the value.
+       * @param array If true, the value is an array of the registered type.
+       * @throw ExecutionException if no connection has resolved the
+       *        registered type to `oid`.
+       **/
+      static void check(size_t id, Oid oid, bool array);
+
+    private:
+
+      friend class Connection;
+
+      static size_t add(const std::string &name);
+
+      /**
+       * Record the OIDs of a type resolved by a connection.
+       **/
+      static void resolved(size_t id, Oid oid, Oid array);
+
+      template<typename T>
+      static std::unique_ptr<type_codec<T>> &slot() noexcept {
+        static std::unique_ptr<type_codec<T>> codec;
+        return codec;
+      }
+    };
+
+  } // namespace postgres
+}   // namespace db
@@ -0,0 +1,186 @@
+/**
+ * Copyright (c) 2016 Philippe FERDINAND
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ **/
+#pragma once
+
+#include "postgres-pool.h"
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+namespace db {
+  namespace postgres {
+
+    /**
+     * Position in the write-ahead log (`pg_lsn`).
+     **/
+    typedef uint64_t lsn_t;
+
+    /**
+     * Routing of the queries between a primary server and its replicas.
+     *
+     * Writes are executed on the primary and reads on the replicas. A write
+     * returns the position of the primary in the write-ahead log: a read
+     * given this position is only executed on a replica that has replayed
+     * the write-ahead log up to it, or on the primary if none has, so a
+     * client always reads its own writes.
+     *
+     * ```
+     * auto primary = std::make_shared<ConnectionPool>(8, "postgresql://primary/employees");
+     * auto replica = std::make_shared<ConnectionPool>(32, "postgresql://replica/employees");
+     * ReplicaRouter router(primary, { replica });
+     *
+     * lsn_t lsn = 0;
+     * router.write(&lsn, "UPDATE titles SET to_date=$1::date WHERE emp_no=$2", "1988-02-10", 10020);
+     * ResultSet titles = router.read(lsn, "SELECT * FROM titles WHERE emp_no=$1", 10020);
+     * ```
+     *
+     * The replay position of a replica is cached, and only queried again
+     * when a read needs a more recent position. A server that is not a
+     * standby has no replay position: it only executes the reads given no
+     * position, unless standalone servers are accepted as replicas.
+     **/
+    class ReplicaRouter {
+    public:
+
+      /**
+       * Choice of the replica executing a read.
+       **/
+      enum class Policy {
+        ROUND_ROBIN,    /**< Each replica in turn. **/
+        LEAST_LOADED    /**< The replica with the most idle connections. **/
+      };
+
+      /**
+       * Constructor.
+       *
+       * @param primary    The connections to the primary server.
+       * @param replicas   The connections to each replica. Without replicas,
+       *                   reads are executed on the primary.
+       * @param policy     Choice of the replica executing a read.
+       * @param standalone Accept a replica that is not a standby (e.g. a
+       *                   copy of the primary, or a standby promoted) as
+       *                   always up to date. Its status is checked again by
+       *                   each read given a position.
+       **/
+      ReplicaRouter(std::shared_ptr<ConnectionPool> primary,
+                    std::vector<std::shared_ptr<ConnectionPool>> replicas,
+                    Policy policy = Policy::LEAST_LOADED,
+                    bool standalone = false);
+
+      /**
+       * Destructor.
+       **/
+      virtual ~ReplicaRouter() {}
+
+      /**
+       * Acquire a connection to the primary.
+       **/
+      ConnectionPool::Lease primary();
+
+      /**
+       * Acquire a connection to a replica that has replayed the write-ahead
+       * log up to a position.
+       *
+       * @param lsn The position, 0 for any replica.
+       * @return A connection to a replica, or to the primary if no replica
+       *         has reached the position.
+       **/
+      ConnectionPool::Lease replica(lsn_t lsn = 0);
+
+      /**
+       * Current position in the write-ahead log of the primary.
+       *
+       * @param primary A connection to the primary.
+       **/
+      lsn_t position(Connection &primary);
+
+      /**
+       * Execute an SQL command on the primary.
+       *
+       * @param lsn  If not null, set to the position in the write-ahead log
+       *             after the command. This costs a second query.
+       * @param sql  The SQL command.
+       * @param args Parameters of the SQL command (see Connection::execute()).
+       * @return The rows returned by the command.
+       **/
+      template<typename... Args>
+      ResultSet write(lsn_t *lsn, const char *sql, Args... args) {
+        auto cnx = primary();
+        ResultSet rows = cnx->execute(sql, args...).detach();
+        if (lsn != nullptr) {
+          *lsn = position(*cnx);
+        }
+        return rows;
+      }
+
+      /**
+       * Execute a read-only SQL command on a replica.
+       *
+       * @param lsn  The position in the write-ahead log the replica must have
+       *             replayed (as returned by write()), 0 for any replica.
+       * @param sql  The SQL command.
+       * @param args Parameters of the SQL command (see Connection::execute()).
+       * @return The rows returned by the command.
+       **/
+      template<typename... Args>
+      ResultSet read(lsn_t lsn, const char *sql, Args... args) {
+        auto cnx = replica(lsn);
+        return cnx->execute(sql, args...).detach();
+      }
+
+    protected:
+
+      /**
+       * Replay position of a replica.
+       *
+       * @param replica A connection to the replica.
+       * @param lsn     Set to the position in the write-ahead log replayed by
+       *                the replica.
+       * @return false if the replica is not a standby server.
+       **/
+      virtual bool replayed(Connection &replica, lsn_t &lsn);
+
+    private:
+
+      /**
+       * A replica and its last known replay position.
+       **/
+      struct Replica {
+        std::shared_ptr<ConnectionPool> pool;
+        std::atomic<lsn_t> replayed;
+      };
+
+      std::shared_ptr<ConnectionPool> primary_;
+      std::vector<std::unique_ptr<Replica>> replicas_;
+      Policy policy_;
+      bool standalone_;               /**< Standalone servers are accepted as replicas. **/
+      std::atomic<size_t> next_;      /**< Next replica for round-robin reads. **/
+
+      ReplicaRouter(const ReplicaRouter&) = delete;
+      ReplicaRouter(const ReplicaRouter&&) = delete;
+      ReplicaRouter& operator = (const ReplicaRouter&) = delete;
+      ReplicaRouter& operator = (const ReplicaRouter&&) = delete;
+    };
+
+  } // namespace postgres
+}   // namespace db
@@ -21,13 +21,184 @@
  **/
 #pragma once
 
+#include "postgres-chrono.h"
+#include "postgres-registry.h"
 #include "postgres-types.h"
 
+#include <cstdint>
+#include <functional>
+#include <vector>
+
 namespace db {
   namespace postgres {
     
     class Connection;
     class Result;
+    class ResultSet;
+
+    /**
+     * Walk through the elements of an array.
+     *
+     * Multi-dimensional arrays are walked in row-major order.
+     *
+     * @param array   Binary value of the array, `nullptr` for a null array.
+     * @param element Called for each element with the binary value of the
+     *                element and its length, or `nullptr` and -1 for null
+     *                elements.
+     **/
+    void readElements(char *array, const std::function<void(char *buf, int32_t length)> &element);
+
+    class Record;
+    class Row;
+
+    /**
+     * Decoding of the values that have no specialization of Row::as() and
+     * Record::as(): types registered in the TypeRegistry and, depending on
+     * the C++ standard of the application, `std::optional` and
+     * `std::chrono::year_month_day`. Those are specializations rather than
+     * overloads so that Row and Record are the same classes in the library
+     * and in the application.
+     **/
+    template<typename T>
+    struct value_decoder {
+      static T read(const Row &row, int column);
+      static T read(const Record &record, int field);
+    };
+
+    /**
+     * A value of a composite type.
+     *
+     * Records are returned by `ROW(...)` expressions and by columns of a
+     * composite type. A record is a view on the value held by the row: the
+     * fields are located and decoded only when they are read, and the record
+     * remains valid as long as the row it has been read from.
+     *
+     * ```
+     * auto &result = cnx.execute(R"SQL(
+     *   SELECT d.dept_no, array_agg(ROW(e.emp_no, e.last_name))
+     *     FROM dept_emp d JOIN employees e USING (emp_no)
+     *    GROUP BY d.dept_no
+     * )SQL");
+     *
+     * for (auto &row: result) {
+     *   for (auto &employee: row.asArray<Record>(1)) {
+     *     int32_t emp_no = employee.value.as<int32_t>(0);
+     *     std::string last_name = employee.value.as<std::string>(1);
+     *   }
+     * }
+     * ```
+     *
+     * Fields are read the same way as the columns of a Row (see Row::as()),
+     * nested records and arrays included.
+     **/
+    class Record {
+
+      template<typename T>
+      friend struct value_decoder;
+
+    public:
+
+      /**
+       * Constructor of an empty record, the value of a null record. Reading
+       * a field raises an ExecutionException.
+       **/
+      Record() noexcept;
+
+      /**
+       * Constructor.
+       *
+       * @param buf    Binary value of the record.
+       * @param length Length of the binary value.
+       **/
+      Record(char *buf, size_t length);
+
+      /**
+       * Number of fields of the record.
+       **/
+      int size() const noexcept;
+
+      /**
+       * Type of a field.
+       *
+       * @param field Field number. Field numbers start at 0.
+       * @return The OID of the type of the field.
+       **/
+      Oid type(int field) const;
+
+      /**
+       * Test a field for a null value.
+       *
+       * @param field Field number. Field numbers start at 0.
+       * @return true if the field value is a null value.
+       **/
+      bool isNull(int field) const;
+
+      /**
+       * Get a field value.
+       *
+       * @param field Field number. Field numbers start at 0.
+       * @return The value of the field. See Row::as() for supported types and
+       *         null values.
+       **/
+      template<typename T>
+      T as(int field) const;
+
+      /**
+       * Get a field values for arrays.
+       *
+       * @param field Field number. Field numbers start at 0.
+       * @return The value of the field. See Row::asArray().
+       **/
+      template<typename T>
+      std::vector<array_item<T>> asArray(int field) const;
+
+    private:
+      char    *buf_;                  /**< First field of the record. **/
+      int32_t size_;                  /**< Number of fields. **/
+      std::vector<int32_t> offsets_;  /**< Offset of each field from the first one. **/
+
+      /**
+       * Locate a field, raising an ExecutionException if out of range.
+       *
+       * @param field  Field number.
+       * @param type   Receives the type of the field.
+       * @param length Receives the length of the field, -1 for a null value.
+       * @return The value of the field.
+       **/
+      char *field(int field, Oid &type, int32_t &length) const;
+
+      template<typename T>
+      T value(int field, Oid oid, T defVal) const;
+
+      /**
+       * Value of a field that is not null, located by field().
+       **/
+      template<typename T>
+      T valueOf(int field, char *buf, Oid type, int32_t length) const;
+
+      /**
+       * Types without a specialization of as().
+       **/
+      template<typename T>
+      T decode(int field, T *) const;
+
+      template<typename Duration>
+      std::chrono::time_point<std::chrono::system_clock, Duration>
+      decode(int field, std::chrono::time_point<std::chrono::system_clock, Duration> *) const {
+        Oid type;
+        int32_t length;
+        char *buf = this->field(field, type, length);
+        return readTimePoint<Duration>(type, buf);
+      }
+
+      template<typename Rep, typename Period>
+      std::chrono::duration<Rep, Period> decode(int field, std::chrono::duration<Rep, Period> *) const {
+        Oid type;
+        int32_t length;
+        char *buf = this->field(field, type, length);
+        return readDuration<Rep, Period>(type, buf);
+      }
+    };
 
     /**
      * A row in a Result.
@@ -38,6 +209,10 @@ namespace db {
     class Row {
 
       friend class Result;
+      friend class ResultSet;
+
+      template<typename T>
+      friend struct value_decoder;
 
     public:
 
@@ -79,13 +254,34 @@ namespace db {
          timestamp with time zone    | db::postgres::timestamptz_t | { 0 }
          interval                    | db::postgres::interval_t    | { 0, 0 }
          time with time zone         | db::postgres::timetz_t      | { 0, 0, 0 }
+         numeric                     | db::postgres::numeric_t     | 0
+         uuid                        | db::postgres::uuid_t        | { 0 }
+         macaddr                     | db::postgres::macaddr_t     | { 0 }
+         inet, cidr                  | db::postgres::inet_t        | { 0 }
+         json                        | db::postgres::json_t        | *empty view*
+         jsonb                       | db::postgres::jsonb_t       | *empty view*
+         record, composite types     | db::postgres::Record        | *empty record*
+         int4range, int8range        | db::postgres::int4range_t, db::postgres::int8range_t | *empty range*
+         numrange, daterange         | db::postgres::numrange_t, db::postgres::daterange_t  | *empty range*
+         tsrange, tstzrange          | db::postgres::tsrange_t, db::postgres::tstzrange_t   | *empty range*
+         *type*multirange            | db::postgres::multirange\<T\> | *empty vector*
          smallserial                 | int16_t                     | 0
          serial                      | int32_t                     | 0
          bigserial                   | int64_t                     | 0
 
+       * Other types can be read once registered in the TypeRegistry, their
+       * null value is the value built by their default constructor. The
+       * `std::chrono` types can be used for date and time values (see
+       * postgres-chrono.h).
+       *
        * If the column value is null, the null value defined in the table above
        * will be returned. To insure the column value is really null the method
-       * isNull() should be used.
+       * isNull() should be used, or with C++17 the value can be read as a
+       * `std::optional<T>`:
+       *
+       * ```
+       * std::optional<date_t> to_date = row.as<std::optional<date_t>>(3);
+       * ```
        *
        * @param column Column number. Column numbers start at 0.
        * @return The value of the column.
@@ -111,7 +307,7 @@ namespace db {
        * SQL names and C++ types are the same. Only bytea is not
        * supported.
        *
-       * Only array of one dimention are supported.
+       * Multi-dimensional arrays are flattened in row-major order.
        *
        * @param column Column number. Column numbers start at 0.
        * @return The value of the column. The value is actually a vector
@@ -121,6 +317,43 @@ namespace db {
       template<typename T>
       std::vector<array_item<T>> asArray(int column) const;
 
+      /**
+       * Get a column values for arrays into a compact array.
+       *
+
+        ```
+        compact_array<double> values;
+        for (auto &row: result) {
+          row.asArray(0, values); // the memory of `values` is reused.
+          ...
+        }
+        ```
+
+       *
+       * Values are decoded into a contiguous buffer with a separate validity
+       * bitmap (see compact_array). The supported types are the same as for
+       * `asArray(int column)` except `std::string`. The shape of
+       * multi-dimensional arrays is given by `compact_array::dims`.
+       *
+       * @param column Column number. Column numbers start at 0.
+       * @param array  Receives the values of the column. A null array gives
+       *               an empty array.
+       **/
+      template<typename T>
+      void asArray(int column, compact_array<T> &array) const;
+
+      /**
+       * Get a column values for arrays of strings into a string array.
+       *
+       * All the strings are decoded into a single buffer (see string_array)
+       * rather than allocating one `std::string` per value.
+       *
+       * @param column Column number. Column numbers start at 0.
+       * @param array  Receives the values of the column. A null array gives
+       *               an empty array.
+       **/
+      void asArray(int column, string_array &array) const;
+
       /**
        * Get a column name.
        *
@@ -155,13 +388,62 @@ namespace db {
         return as<T>(column);
       }
 
-    private:
-      Result &result_;  /**< The result set by the constructor **/
+    protected:
+      PGresult *pgresult_;  /**< Native result holding the row. **/
+      int row_;             /**< Row number in the native result. **/
+      int num_;             /**< Row number in the query result. **/
 
       /**
        * Constructor.
        **/
-      Row(Result &result);
+      Row(PGresult *pgresult = nullptr, int row = 0, int num = 0);
+
+      /**
+       * Value of a column, or `nullptr` for a null value.
+       **/
+      char *value(int column) const {
+        return PQgetisnull(pgresult_, row_, column) ? nullptr : PQgetvalue(pgresult_, row_, column);
+      }
+
+      /**
+       * Test if a column is in text format (see Format::TEXT).
+       **/
+      bool isText(int column) const {
+        return PQfformat(pgresult_, column) == 0;
+      }
+
+      /**
+       * Value of a column that is not null.
+       **/
+      template<typename T>
+      T valueOf(int column) const;
+
+      /**
+       * Types without a specialization of as().
+       **/
+      template<typename T>
+      T decode(int column, T *) const;
+
+      template<typename Duration>
+      std::chrono::time_point<std::chrono::system_clock, Duration>
+      decode(int column, std::chrono::time_point<std::chrono::system_clock, Duration> *) const {
+        if (isText(column)) {
+          return toTimePoint<Duration>(PQftype(pgresult_, column) == TIMESTAMPTZOID
+                                       ? as<timestamptz_t>(column).epoch_time
+                                       : as<timestamp_t>(column).epoch_time);
+        }
+        return readTimePoint<Duration>(PQftype(pgresult_, column), value(column));
+      }
+
+      template<typename Rep, typename Period>
+      std::chrono::duration<Rep, Period> decode(int column, std::chrono::duration<Rep, Period> *) const {
+        if (isText(column)) {
+          return toDuration<Rep, Period>(PQftype(pgresult_, column) == INTERVALOID
+                                         ? as<interval_t>(column)
+                                         : interval_t { as<time_t>(column).time, 0, 0 });
+        }
+        return readDuration<Rep, Period>(PQftype(pgresult_, column), value(column));
+      }
 
       Row(const Row&) = delete;
       Row& operator = (const Row&) = delete;
@@ -169,6 +451,325 @@ namespace db {
       Row& operator = (const Row&&) = delete;
     };
 
+    /**
+     * Types natively supported.
+     **/
+    template<> bool Row::as(int column) const;
+    template<> int16_t Row::as(int column) const;
+    template<> int32_t Row::as(int column) const;
+    template<> int64_t Row::as(int column) const;
+    template<> float Row::as(int column) const;
+    template<> double Row::as(int column) const;
+    template<> std::string Row::as(int column) const;
+    template<> char Row::as(int column) const;
+    template<> std::vector<uint8_t> Row::as(int column) const;
+    template<> date_t Row::as(int column) const;
+    template<> timestamptz_t Row::as(int column) const;
+    template<> timestamp_t Row::as(int column) const;
+    template<> timetz_t Row::as(int column) const;
+    template<> time_t Row::as(int column) const;
+    template<> interval_t Row::as(int column) const;
+    template<> numeric_t Row::as(int column) const;
+    template<> uuid_t Row::as(int column) const;
+    template<> macaddr_t Row::as(int column) const;
+    template<> inet_t Row::as(int column) const;
+    template<> json_t Row::as(int column) const;
+    template<> jsonb_t Row::as(int column) const;
+    template<> Record Row::as(int column) const;
+    template<> range<int32_t> Row::as(int column) const;
+    template<> range<int64_t> Row::as(int column) const;
+    template<> range<numeric_t> Row::as(int column) const;
+    template<> range<date_t> Row::as(int column) const;
+    template<> range<timestamp_t> Row::as(int column) const;
+    template<> range<timestamptz_t> Row::as(int column) const;
+    template<> multirange<int32_t> Row::as(int column) const;
+    template<> multirange<int64_t> Row::as(int column) const;
+    template<> multirange<numeric_t> Row::as(int column) const;
+    template<> multirange<date_t> Row::as(int column) const;
+    template<> multirange<timestamp_t> Row::as(int column) const;
+    template<> multirange<timestamptz_t> Row::as(int column) const;
+
+    template<> std::vector<array_item<bool>> Row::asArray(int column) const;
+    template<> std::vector<array_item<int16_t>> Row::asArray(int column) const;
+    template<> std::vector<array_item<int32_t>> Row::asArray(int column) const;
+    template<> std::vector<array_item<int64_t>> Row::asArray(int column) const;
+    template<> std::vector<array_item<float>> Row::asArray(int column) const;
+    template<> std::vector<array_item<double>> Row::asArray(int column) const;
+    template<> std::vector<array_item<date_t>> Row::asArray(int column) const;
+    template<> std::vector<array_item<timestamptz_t>> Row::asArray(int column) const;
+    template<> std::vector<array_item<timestamp_t>> Row::asArray(int column) const;
+    template<> std::vector<array_item<timetz_t>> Row::asArray(int column) const;
+    template<> std::vector<array_item<time_t>> Row::asArray(int column) const;
+    template<> std::vector<array_item<interval_t>> Row::asArray(int column) const;
+    template<> std::vector<array_item<numeric_t>> Row::asArray(int column) const;
+    template<> std::vector<array_item<uuid_t>> Row::asArray(int column) const;
+    template<> std::vector<array_item<macaddr_t>> Row::asArray(int column) const;
+    template<> std::vector<array_item<inet_t>> Row::asArray(int column) const;
+    template<> std::vector<array_item<json_t>> Row::asArray(int column) const;
+    template<> std::vector<array_item<jsonb_t>> Row::asArray(int column) const;
+    template<> std::vector<array_item<std::string>> Row::asArray(int column) const;
+    template<> std::vector<array_item<Record>> Row::asArray(int column) const;
+    template<> std::vector<array_item<range<int32_t>>> Row::asArray(int column) const;
+    template<> std::vector<array_item<range<int64_t>>> Row::asArray(int column) const;
+    template<> std::vector<array_item<range<numeric_t>>> Row::asArray(int column) const;
+    template<> std::vector<array_item<range<date_t>>> Row::asArray(int column) const;
+    template<> std::vector<array_item<range<timestamp_t>>> Row::asArray(int column) const;
+    template<> std::vector<array_item<range<timestamptz_t>>> Row::asArray(int column) const;
+
+    /**
+     * Types registered in the TypeRegistry.
+     **/
+    template<typename T>
+    T Row::as(int column) const {
+      return decode(column, static_cast<T *>(nullptr));
+    }
+
+    template<typename T>
+    T Row::decode(int column, T *) const {
+      return value_decoder<T>::read(*this, column);
+    }
+
+    template<typename T>
+    T Row::valueOf(int column) const {
+      const type_codec<T> *codec = TypeRegistry::find<T>();
+      if (codec == nullptr) {
+        // Types checking the null values by themselves.
+        return as<T>(column);
+      }
+      assert(!isText(column)); // registered types are read in binary format.
+      TypeRegistry::check(codec->id, PQftype(pgresult_, column), false);
+      return codec->read(PQgetvalue(pgresult_, row_, column), PQgetlength(pgresult_, row_, column));
+    }
+
+    template<> bool Row::valueOf(int column) const;
+    template<> int16_t Row::valueOf(int column) const;
+    template<> int32_t Row::valueOf(int column) const;
+    template<> int64_t Row::valueOf(int column) const;
+    template<> float Row::valueOf(int column) const;
+    template<> double Row::valueOf(int column) const;
+    template<> std::string Row::valueOf(int column) const;
+    template<> date_t Row::valueOf(int column) const;
+    template<> timestamptz_t Row::valueOf(int column) const;
+    template<> timestamp_t Row::valueOf(int column) const;
+    template<> timetz_t Row::valueOf(int column) const;
+    template<> time_t Row::valueOf(int column) const;
+    template<> interval_t Row::valueOf(int column) const;
+    template<> numeric_t Row::valueOf(int column) const;
+    template<> uuid_t Row::valueOf(int column) const;
+    template<> macaddr_t Row::valueOf(int column) const;
+    template<> json_t Row::valueOf(int column) const;
+    template<> jsonb_t Row::valueOf(int column) const;
+
+    template<typename T>
+    std::vector<array_item<T>> Row::asArray(int column) const {
+      const type_codec<T> *codec = TypeRegistry::find<T>();
+      assert(codec != nullptr); // unsupported type, see TypeRegistry.
+      assert(!isText(column)); // registered types are read in binary format.
+      TypeRegistry::check(codec->id, PQftype(pgresult_, column), true);
+      std::vector<array_item<T>> array;
+      readElements(value(column), [&](char *buf, int32_t length) {
+        array_item<T> item;
+        item.isNull = length == -1;
+        item.value = item.isNull ? T() : codec->read(buf, length);
+        array.push_back(std::move(item));
+      });
+      return array;
+    }
+
+    /**
+     * Fields of records.
+     **/
+    template<> bool Record::as(int field) const;
+    template<> int16_t Record::as(int field) const;
+    template<> int32_t Record::as(int field) const;
+    template<> int64_t Record::as(int field) const;
+    template<> float Record::as(int field) const;
+    template<> double Record::as(int field) const;
+    template<> std::string Record::as(int field) const;
+    template<> char Record::as(int field) const;
+    template<> std::vector<uint8_t> Record::as(int field) const;
+    template<> date_t Record::as(int field) const;
+    template<> timestamptz_t Record::as(int field) const;
+    template<> timestamp_t Record::as(int field) const;
+    template<> timetz_t Record::as(int field) const;
+    template<> time_t Record::as(int field) const;
+    template<> interval_t Record::as(int field) const;
+    template<> numeric_t Record::as(int field) const;
+    template<> uuid_t Record::as(int field) const;
+    template<> macaddr_t Record::as(int field) const;
+    template<> inet_t Record::as(int field) const;
+    template<> json_t Record::as(int field) const;
+    template<> jsonb_t Record::as(int field) const;
+    template<> Record Record::as(int field) const;
+    template<> range<int32_t> Record::as(int field) const;
+    template<> range<int64_t> Record::as(int field) const;
+    template<> range<numeric_t> Record::as(int field) const;
+    template<> range<date_t> Record::as(int field) const;
+    template<> range<timestamp_t> Record::as(int field) const;
+    template<> range<timestamptz_t> Record::as(int field) const;
+    template<> multirange<int32_t> Record::as(int field) const;
+    template<> multirange<int64_t> Record::as(int field) const;
+    template<> multirange<numeric_t> Record::as(int field) const;
+    template<> multirange<date_t> Record::as(int field) const;
+    template<> multirange<timestamp_t> Record::as(int field) const;
+    template<> multirange<timestamptz_t> Record::as(int field) const;
+
+    template<> std::vector<array_item<bool>> Record::asArray(int field) const;
+    template<> std::vector<array_item<int16_t>> Record::asArray(int field) const;
+    template<> std::vector<array_item<int32_t>> Record::asArray(int field) const;
+    template<> std::vector<array_item<int64_t>> Record::asArray(int field) const;
+    template<> std::vector<array_item<float>> Record::asArray(int field) const;
+    template<> std::vector<array_item<double>> Record::asArray(int field) const;
+    template<> std::vector<array_item<date_t>> Record::asArray(int field) const;
+    template<> std::vector<array_item<timestamptz_t>> Record::asArray(int field) const;
+    template<> std::vector<array_item<timestamp_t>> Record::asArray(int field) const;
+    template<> std::vector<array_item<timetz_t>> Record::asArray(int field) const;
+    template<> std::vector<array_item<time_t>> Record::asArray(int field) const;
+    template<> std::vector<array_item<interval_t>> Record::asArray(int field) const;
+    template<> std::vector<array_item<numeric_t>> Record::asArray(int field) const;
+    template<> std::vector<array_item<uuid_t>> Record::asArray(int field) const;
+    template<> std::vector<array_item<macaddr_t>> Record::asArray(int field) const;
+    template<> std::vector<array_item<inet_t>> Record::asArray(int field) const;
+    template<> std::vector<array_item<json_t>> Record::asArray(int field) const;
+    template<> std::vector<array_item<jsonb_t>> Record::asArray(int field) const;
+    template<> std::vector<array_item<std::string>> Record::asArray(int field) const;
+    template<> std::vector<array_item<Record>> Record::asArray(int field) const;
+    template<> std::vector<array_item<range<int32_t>>> Record::asArray(int field) const;
+    template<> std::vector<array_item<range<int64_t>>> Record::asArray(int field) const;
+    template<> std::vector<array_item<range<numeric_t>>> Record::asArray(int field) const;
+    template<> std::vector<array_item<range<date_t>>> Record::asArray(int field) const;
+    template<> std::vector<array_item<range<timestamp_t>>> Record::asArray(int field) const;
+    template<> std::vector<array_item<range<timestamptz_t>>> Record::asArray(int field) const;
+
+    template<typename T>
+    T Record::as(int field) const {
+      return decode(field, static_cast<T *>(nullptr));
+    }
+
+    template<typename T>
+    T Record::decode(int field, T *) const {
+      return value_decoder<T>::read(*this, field);
+    }
+
+    template<typename T>
+    T Record::valueOf(int field, char *buf, Oid type, int32_t length) const {
+      const type_codec<T> *codec = TypeRegistry::find<T>();
+      if (codec == nullptr) {
+        // Types checking the null values by themselves.
+        return as<T>(field);
+      }
+      TypeRegistry::check(codec->id, type, false);
+      return codec->read(buf, length);
+    }
+
+    template<> bool Record::valueOf(int field, char *buf, Oid type, int32_t length) const;
+    template<> int16_t Record::valueOf(int field, char *buf, Oid type, int32_t length) const;
+    template<> int32_t Record::valueOf(int field, char *buf, Oid type, int32_t length) const;
+    template<> int64_t Record::valueOf(int field, char *buf, Oid type, int32_t length) const;
+    template<> float Record::valueOf(int field, char *buf, Oid type, int32_t length) const;
+    template<> double Record::valueOf(int field, char *buf, Oid type, int32_t length) const;
+    template<> std::string Record::valueOf(int field, char *buf, Oid type, int32_t length) const;
+    template<> date_t Record::valueOf(int field, char *buf, Oid type, int32_t length) const;
+    template<> timestamptz_t Record::valueOf(int field, char *buf, Oid type, int32_t length) const;
+    template<> timestamp_t Record::valueOf(int field, char *buf, Oid type, int32_t length) const;
+    template<> timetz_t Record::valueOf(int field, char *buf, Oid type, int32_t length) const;
+    template<> time_t Record::valueOf(int field, char *buf, Oid type, int32_t length) const;
+    template<> interval_t Record::valueOf(int field, char *buf, Oid type, int32_t length) const;
+    template<> numeric_t Record::valueOf(int field, char *buf, Oid type, int32_t length) const;
+    template<> uuid_t Record::valueOf(int field, char *buf, Oid type, int32_t length) const;
+    template<> macaddr_t Record::valueOf(int field, char *buf, Oid type, int32_t length) const;
+    template<> json_t Record::valueOf(int field, char *buf, Oid type, int32_t length) const;
+    template<> jsonb_t Record::valueOf(int field, char *buf, Oid type, int32_t length) const;
+
+    /**
+     * Types registered in the TypeRegistry.
+     **/
+    template<typename T>
+    T value_decoder<T>::read(const Row &row, int column) {
+      const type_codec<T> *codec = TypeRegistry::find<T>();
+      assert(codec != nullptr); // unsupported type, see TypeRegistry.
+      assert(!row.isText(column)); // registered types are read in binary format.
+      TypeRegistry::check(codec->id, PQftype(row.pgresult_, column), false);
+      if (PQgetisnull(row.pgresult_, row.row_, column)) {
+        return T();
+      }
+      return codec->read(PQgetvalue(row.pgresult_, row.row_, column), PQgetlength(row.pgresult_, row.row_, column));
+    }
+
+    template<typename T>
+    T value_decoder<T>::read(const Record &record, int field) {
+      const type_codec<T> *codec = TypeRegistry::find<T>();
+      assert(codec != nullptr); // unsupported type, see TypeRegistry.
+      Oid type;
+      int32_t length;
+      char *buf = record.field(field, type, length);
+      TypeRegistry::check(codec->id, type, false);
+      return buf == nullptr ? T() : codec->read(buf, length);
+    }
+
+#if LIBPQMXX_HAS_OPTIONAL
+    /**
+     * A null value is read as `std::nullopt`, other values are decoded
+     * without checking again for a null value.
+     **/
+    template<typename T>
+    struct value_decoder<std::optional<T>> {
+      static std::optional<T> read(const Row &row, int column) {
+        if (PQgetisnull(row.pgresult_, row.row_, column)) {
+          return std::nullopt;
+        }
+        return row.template valueOf<T>(column);
+      }
+
+      static std::optional<T> read(const Record &record, int field) {
+        Oid type;
+        int32_t length;
+        char *buf = record.field(field, type, length);
+        if (buf == nullptr) {
+          return std::nullopt;
+        }
+        return record.template valueOf<T>(field, buf, type, length);
+      }
+    };
+#endif
+
+#if LIBPQMXX_HAS_CALENDAR
+    template<>
+    struct value_decoder<std::chrono::year_month_day> {
+      static std::chrono::year_month_day read(const Row &row, int column) {
+        if (row.isText(column)) {
+          return toDate(row.as<date_t>(column).epoch_date / 86400);
+        }
+        return readDate(PQftype(row.pgresult_, column), row.value(column));
+      }
+
+      static std::chrono::year_month_day read(const Record &record, int field) {
+        Oid type;
+        int32_t length;
+        char *buf = record.field(field, type, length);
+        return readDate(type, buf);
+      }
+    };
+#endif
+
+    template<typename T>
+    std::vector<array_item<T>> Record::asArray(int field) const {
+      const type_codec<T> *codec = TypeRegistry::find<T>();
+      assert(codec != nullptr); // unsupported type, see TypeRegistry.
+      Oid type;
+      int32_t length;
+      std::vector<array_item<T>> array;
+      char *value = this->field(field, type, length);
+      TypeRegistry::check(codec->id, type, true);
+      readElements(value, [&](char *buf, int32_t length) {
+        array_item<T> item;
+        item.isNull = length == -1;
+        item.value = item.isNull ? T() : codec->read(buf, length);
+        array.push_back(std::move(item));
+      });
+      return array;
+    }
+
     /**
      * A result from an SQL command.
      *
@@ -182,6 +783,7 @@ namespace db {
     class Result : public Row {
 
       friend class Connection;
+      friend class FanOut;
       friend class Row;
 
     public:
@@ -214,12 +816,14 @@ namespace db {
       class iterator {
       public:
 
-        iterator(Row *ptr): ptr_(ptr) {} /**< Constructor. **/
-        iterator operator ++();          /**< Next row in the resultset **/
+        iterator(Result *result, Row *ptr)   /**< Constructor. **/
+          : result_(result), ptr_(ptr) {}
+        iterator operator ++();              /**< Next row in the resultset **/
         bool operator != (const iterator &other) { return ptr_ != other.ptr_; }
         Row &operator *() { return *ptr_; }
 
       private:
+        Result *result_;
         Row *ptr_;
       };
 
@@ -237,12 +841,32 @@ namespace db {
        **/
       iterator end();
 
+      /**
+       * Detach rows from the connection.
+       *
+       * Moves up to `rows` rows, starting at the current one, into a
+       * ResultSet owning them. The returned ResultSet remains valid after the
+       * next call to Connection::execute() and can be handed to another
+       * thread, so the processing of a result can overlap with the next query.
+       *
+       * ```
+       * ResultSet employees = cnx.execute("SELECT * FROM employees").detach();
+       * cnx.execute("SELECT * FROM titles"); // `employees` is still valid.
+       * ```
+       *
+       * After the call, the result is positioned on the first row that has
+       * not been detached, or at its end if all the rows have been detached.
+       *
+       * @param rows Maximum number of rows to detach. By default all the
+       *             remaining rows of the result are detached.
+       * @return The detached rows.
+       **/
+      ResultSet detach(size_t rows = SIZE_MAX);
+
     private:
 
-      PGresult *pgresult_;  /**< Native result **/
       Connection &conn_;    /**< Connection owning the result. **/
-      Row begin_, end_;     /**< Virtual begin and end of the result. **/
-      int num_;             /**< Current row number. */
+      Row end_;             /**< Virtual end of the result. **/
 
       ExecStatusType status_ = PGRES_EMPTY_QUERY;
 
@@ -276,6 +900,109 @@ namespace db {
       Result& operator = (const Result&) = delete;
       Result& operator = (const Result&&) = delete;
     };
+
+    /**
+     * Rows detached from a Result.
+     *
+     * Unlike a Result, a ResultSet owns its rows and is not bound to the
+     * connection: it can be moved around, kept while other queries are
+     * executed on the connection, and read from another thread.
+     *
+     * ```
+     * ResultSet rows = cnx.execute("SELECT emp_no FROM employees").detach();
+     * std::thread worker([](ResultSet rows) {
+     *   for (auto &row: rows) {
+     *     ...
+     *   }
+     * }, std::move(rows));
+     * ```
+     **/
+    class ResultSet {
+
+      friend class Multiplexer;
+      friend class Reactor;
+      friend class Result;
+
+    public:
+
+      /**
+       * Constructor of an empty set.
+       **/
+      ResultSet() noexcept;
+
+      /**
+       * Move constructor.
+       **/
+      ResultSet(ResultSet &&other) noexcept;
+
+      /**
+       * Move assignment.
+       **/
+      ResultSet &operator = (ResultSet &&other) noexcept;
+
+      /**
+       * Destructor.
+       *
+       * Native results owned by the set are released.
+       **/
+      ~ResultSet();
+
+      /**
+       * Number of rows in the set.
+       **/
+      size_t size() const noexcept;
+
+      /**
+       * Test if the set has no row.
+       **/
+      bool empty() const noexcept;
+
+      /**
+       * Support of the range-based for loops.
+       **/
+      class iterator {
+      public:
+
+        iterator(const ResultSet *set, size_t index);  /**< Constructor. **/
+        iterator(const iterator &other);               /**< Copy constructor. **/
+        iterator &operator = (const iterator &other);  /**< Copy assignment. **/
+        iterator operator ++();                        /**< Next row in the set **/
+        bool operator != (const iterator &other) const { return index_ != other.index_; }
+        const Row &operator *() const { return row_; }
+
+      private:
+        const ResultSet *set_;
+        size_t index_;  /**< Index of the row in the set. **/
+        size_t chunk_;  /**< Index of the native result holding the row. **/
+        Row row_;
+
+        void seek();
+      };
+
+      /**
+       * First row of the set.
+       **/
+      iterator begin() const;
+
+      /**
+       * Past-the-end row of the set.
+       **/
+      iterator end() const;
+
+    private:
+
+      std::vector<PGresult *> chunks_;  /**< Native results owned by the set. **/
+      size_t size_;                     /**< Number of rows. **/
+      int num_;                         /**< Row number of the first row. **/
+
+      /**
+       * Take the ownership of a native result.
+       **/
+      void add(PGresult *pgresult);
+
+      ResultSet(const ResultSet&) = delete;
+      ResultSet& operator = (const ResultSet&) = delete;
+    };
     
   } // namespace postgres
 }   // namespace db
@@ -0,0 +1,133 @@
+/**
+ * Copyright (c) 2016 Philippe FERDINAND
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ **/
+#pragma once
+
+#include "postgres-connection.h"
+
+#include <functional>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace db {
+  namespace postgres {
+
+    /**
+     * A table scanned concurrently over several connections.
+     *
+     * The table is split into ranges of blocks (by `ctid`) or ranges of an
+     * integer key. Each connection runs in its own thread and scans the
+     * ranges not yet scanned until there is none left. All the connections
+     * share the same snapshot, exported by the first connection with
+     * `pg_export_snapshot()`: the rows scanned are the ones of a consistent
+     * state of the table, as if scanned by a single query.
+     *
+     * ```
+     * std::vector<Connection *> connections = ...;
+     * ParallelScan scan(connections);
+     * std::mutex mutex;
+     * scan.byBlocks("employees", "emp_no, last_name", [&](const Row &row) {
+     *   std::lock_guard<std::mutex> lock(mutex);
+     *   ...
+     * });
+     * ```
+     *
+     * @attention The consumer is called concurrently from the threads of the
+     *            connections. The names of the table and the columns are
+     *            inserted as is in the SQL commands.
+     **/
+    class ParallelScan {
+    public:
+
+      /**
+       * Consumer of the rows scanned.
+       **/
+      typedef std::function<void(const Row &row)> consumer_t;
+
+      /**
+       * Constructor.
+       *
+       * @param connections Connections with no transaction in progress.
+       **/
+      explicit ParallelScan(std::vector<Connection *> connections);
+
+      /**
+       * Number of ranges the table is split into.
+       *
+       * @param count Number of ranges, by default 4 per connection so that
+       *              connections done sooner scan more ranges.
+       * @return The scan itself.
+       **/
+      ParallelScan &ranges(size_t count);
+
+      /**
+       * Scan a table by ranges of blocks.
+       *
+       * Each range is read with a TID range scan (PostgreSQL 14 or later,
+       * sequential scan with a filter otherwise).
+       *
+       * @param table    The table.
+       * @param columns  The columns to read, separated by commas.
+       * @param consumer Called for each row.
+       **/
+      void byBlocks(const char *table, const char *columns, consumer_t consumer);
+
+      /**
+       * Scan a table by ranges of an integer key.
+       *
+       * The ranges split the interval between the minimum and the maximum
+       * values of the key evenly: the key should be indexed and its values
+       * evenly distributed.
+       *
+       * @param table    The table.
+       * @param key      The integer column used to split the table.
+       * @param columns  The columns to read, separated by commas.
+       * @param consumer Called for each row.
+       **/
+      void byKey(const char *table, const char *key, const char *columns, consumer_t consumer);
+
+    private:
+
+      std::vector<Connection *> connections_;
+      size_t ranges_;
+
+      /**
+       * Start a transaction on the first connection and export its snapshot.
+       **/
+      std::string begin();
+
+      /**
+       * Scan the ranges concurrently.
+       *
+       * @param snapshot The snapshot exported by begin().
+       * @param sql      SQL command reading a range, with the bounds of the
+       *                 range as parameters.
+       * @param ranges   The bounds of the ranges.
+       * @param consumer Called for each row.
+       **/
+      template<typename T>
+      void scan(const std::string &snapshot, const std::string &sql,
+                const std::vector<std::pair<T, T>> &ranges, const consumer_t &consumer);
+    };
+
+  } // namespace postgres
+}   // namespace db
@@ -24,10 +24,17 @@
 #include "libpq-fe.h"
 
 #include <cstddef>
+#include <functional>
 #include <string>
+#include <type_traits>
 #include <vector>
 #include <stdint.h>
 
+#if __cplusplus >= 201703L
+  #include <optional>
+  #define LIBPQMXX_HAS_OPTIONAL 1
+#endif
+
 namespace db {
   namespace postgres {
 
@@ -142,6 +149,27 @@ namespace db {
     const Oid TSM_HANDLEROID = 3310;
     const Oid JSONBARRAYOID = 3807;
     const Oid ANYRANGEOID = 3831;
+    const Oid UUIDARRAYOID = 2951;
+    const Oid INETARRAYOID = 1041;
+    const Oid CIDRARRAYOID = 651;
+    const Oid MACADDRARRAYOID = 1040;
+    const Oid INT4RANGEARRAYOID = 3905;
+    const Oid NUMRANGEOID = 3906;
+    const Oid NUMRANGEARRAYOID = 3907;
+    const Oid TSRANGEOID = 3908;
+    const Oid TSRANGEARRAYOID = 3909;
+    const Oid TSTZRANGEOID = 3910;
+    const Oid TSTZRANGEARRAYOID = 3911;
+    const Oid DATERANGEOID = 3912;
+    const Oid DATERANGEARRAYOID = 3913;
+    const Oid INT8RANGEOID = 3926;
+    const Oid INT8RANGEARRAYOID = 3927;
+    const Oid INT4MULTIRANGEOID = 4451;
+    const Oid NUMMULTIRANGEOID = 4532;
+    const Oid TSMULTIRANGEOID = 4533;
+    const Oid TSTZMULTIRANGEOID = 4534;
+    const Oid DATEMULTIRANGEOID = 4535;
+    const Oid INT8MULTIRANGEOID = 4536;
 
     /**
      * A `date` value.
@@ -218,6 +246,258 @@ namespace db {
       int32_t months; /**< Number of months. **/
     } interval_t;
 
+#if defined(__SIZEOF_INT128__)
+    __extension__ typedef __int128 numeric_int_t;           /**< Unscaled value of a fixed-point numeric_t. **/
+    __extension__ typedef unsigned __int128 numeric_uint_t;
+#else
+    typedef int64_t numeric_int_t;                          /**< Unscaled value of a fixed-point numeric_t. **/
+    typedef uint64_t numeric_uint_t;
+#endif
+
+    /**
+     * A `numeric` value.
+     *
+     * Values are held as fixed-point decimals (`unscaled` / 10^`scale`) when
+     * they fit in a numeric_int_t (128 bits integer when supported by the
+     * compiler, 64 bits otherwise). Larger values are kept in the
+     * arbitrary-precision form used by PostgreSQL: base 10000 `digits`, the
+     * first one having the weight 10000^`weight`.
+     *
+     * ```
+     * numeric_t price(1999, 2); // 19.99
+     * cnx.execute("UPDATE products SET price=$1 WHERE id=$2", price, 42);
+     * ```
+     **/
+    struct numeric_t {
+      numeric_int_t        unscaled; /**< Unscaled value of the fixed-point form. **/
+      int16_t              scale;    /**< Number of decimal digits after the decimal point. **/
+      int16_t              weight;   /**< Weight of the first digit of the arbitrary-precision form. **/
+      uint16_t             sign;     /**< Sign of the arbitrary-precision form, or special value (NaN, infinity). **/
+      std::vector<int16_t> digits;   /**< Base 10000 digits of the arbitrary-precision form. Empty for fixed-point values. **/
+
+      static const uint16_t POS  = 0x0000; /**< Positive value. **/
+      static const uint16_t NEG  = 0x4000; /**< Negative value. **/
+      static const uint16_t NaN  = 0xC000; /**< Not a number. **/
+      static const uint16_t PINF = 0xD000; /**< Infinity. **/
+      static const uint16_t NINF = 0xF000; /**< -Infinity. **/
+
+      /**
+       * Constructor of a fixed-point value.
+       *
+       * @param unscaled The unscaled value.
+       * @param scale    The number of decimal digits after the decimal point.
+       **/
+      numeric_t(numeric_int_t unscaled = 0, int16_t scale = 0)
+        : unscaled(unscaled), scale(scale), weight(0), sign(POS) {
+      }
+
+      /**
+       * Test if the value is held in the fixed-point form.
+       **/
+      bool isFixed() const {
+        return digits.empty() && (sign == POS || sign == NEG);
+      }
+
+      /**
+       * Test for the `NaN` value.
+       **/
+      bool isNaN() const {
+        return sign == NaN;
+      }
+
+      /**
+       * Test for the `Infinity` or `-Infinity` values.
+       **/
+      bool isInfinity() const {
+        return sign == PINF || sign == NINF;
+      }
+
+      /**
+       * Conversion to a floating point value (precision may be lost).
+       **/
+      double toDouble() const;
+
+      /**
+       * Text representation of the value, as PostgreSQL would print it.
+       **/
+      std::string str() const;
+
+      /**
+       * Numeric equality, as PostgreSQL compares values: the scale and the
+       * form do not matter (`1.5` equals `1.50`), and `NaN` equals `NaN`.
+       **/
+      bool operator==(const numeric_t &other) const;
+    };
+    /**
+     * A numeric_t in the arbitrary-precision form.
+     *
+     * length() and write() both convert fixed-point values: a value
+     * converted first is not converted twice when it is bound.
+     **/
+    numeric_t toArbitrary(const numeric_t &value);
+
+    /**
+     * A `uuid` value.
+     **/
+    struct uuid_t {
+      uint8_t bytes[16]; /**< The 128 bits of the UUID, most significant byte first. **/
+
+      /**
+       * Text representation (`a0eebc99-9c0b-4ef8-bb6d-6bb9bd380a11`).
+       **/
+      std::string str() const;
+
+      bool operator==(const uuid_t &other) const;
+    };
+
+    /**
+     * A `macaddr` value.
+     **/
+    struct macaddr_t {
+      uint8_t bytes[6]; /**< The 6 bytes of the MAC address. **/
+
+      bool operator==(const macaddr_t &other) const;
+    };
+
+    /**
+     * An `inet` or `cidr` value.
+     **/
+    struct inet_t {
+      static const uint8_t INET  = 2; /**< IPv4 address family. **/
+      static const uint8_t INET6 = 3; /**< IPv6 address family. **/
+
+      uint8_t family;     /**< inet_t::INET or inet_t::INET6. **/
+      uint8_t bits;       /**< Number of bits of the netmask. **/
+      bool    cidr;       /**< `true` for a `cidr` value. **/
+      uint8_t bytes[16];  /**< The address, 4 bytes for IPv4, 16 bytes for IPv6. **/
+
+      /**
+       * Number of bytes of the address.
+       **/
+      uint8_t size() const {
+        return family == INET6 ? 16 : 4;
+      }
+
+      bool operator==(const inet_t &other) const;
+    };
+
+    /**
+     * A `json` value.
+     *
+     * The value is a view on the JSON text: when read from a Row, it remains
+     * valid as long as the row; when used as a parameter, the text must
+     * remain valid until the execution of the query.
+     **/
+    struct json_t {
+      const char *data;   /**< The JSON text (not null-terminated). **/
+      size_t      length; /**< Length of the JSON text. **/
+
+      /**
+       * Copy of the JSON text.
+       **/
+      std::string str() const {
+        return std::string(data, length);
+      }
+    };
+
+    /**
+     * A `jsonb` value.
+     *
+     * Like json_t, the value is a view on the JSON text, the version byte of
+     * the binary format being skipped.
+     **/
+    struct jsonb_t {
+      const char *data;   /**< The JSON text (not null-terminated). **/
+      size_t      length; /**< Length of the JSON text. **/
+
+      /**
+       * Copy of the JSON text.
+       **/
+      std::string str() const {
+        return std::string(data, length);
+      }
+    };
+
+    /**
+     * A range value.
+     *
+     * ```
+     * // [2016-10-01 09:00, 2016-10-01 10:00)
+     * tstzrange_t slot(timestamptz_t { start }, timestamptz_t { end });
+     * cnx.execute("SELECT count(*) FROM bookings WHERE during && $1", slot);
+     *
+     * // [10, infinity)
+     * int4range_t from10(10, 0, int4range_t::LB_INC | int4range_t::UB_INF);
+     * ```
+     *
+     * The bounds flagged as infinite have no value, nor do the bounds of an
+     * empty range. Discrete ranges (`int4range`, `int8range` and `daterange`)
+     * are always returned by the server in the `[lower, upper)` form.
+     **/
+    template <typename T>
+    struct range {
+      enum : uint8_t {
+        EMPTY  = 0x01,  /**< The range is empty. **/
+        LB_INC = 0x02,  /**< The lower bound is inclusive. **/
+        UB_INC = 0x04,  /**< The upper bound is inclusive. **/
+        LB_INF = 0x08,  /**< The range has no lower bound. **/
+        UB_INF = 0x10   /**< The range has no upper bound. **/
+      };
+
+      T       lower;  /**< Lower bound. **/
+      T       upper;  /**< Upper bound. **/
+      uint8_t flags;  /**< Combination of the flags above. **/
+
+      /**
+       * Constructor of an empty range.
+       **/
+      range() : lower(), upper(), flags(EMPTY) {}
+
+      /**
+       * Constructor.
+       *
+       * @param lower Lower bound.
+       * @param upper Upper bound.
+       * @param flags Bound flags, `[lower, upper)` by default.
+       **/
+      range(T lower, T upper, uint8_t flags = LB_INC)
+        : lower(lower), upper(upper), flags(flags) {}
+
+      bool empty() const { return (flags & EMPTY) != 0; }     /**< `true` for an empty range. **/
+      bool lowerInc() const { return (flags & LB_INC) != 0; } /**< `true` if the lower bound is inclusive. **/
+      bool upperInc() const { return (flags & UB_INC) != 0; } /**< `true` if the upper bound is inclusive. **/
+      bool lowerInf() const { return (flags & LB_INF) != 0; } /**< `true` if there is no lower bound. **/
+      bool upperInf() const { return (flags & UB_INF) != 0; } /**< `true` if there is no upper bound. **/
+
+      bool operator==(const range<T> &other) const {
+        if (flags != other.flags) {
+          return false;
+        }
+        return empty()
+          || ((lowerInf() || lower == other.lower) && (upperInf() || upper == other.upper));
+      }
+    };
+
+    /**
+     * A multirange value (PostgreSQL 14 and later).
+     **/
+    template <typename T>
+    using multirange = std::vector<range<T>>;
+
+    typedef range<int32_t>       int4range_t;       /**< An `int4range` value. **/
+    typedef range<int64_t>       int8range_t;       /**< An `int8range` value. **/
+    typedef range<numeric_t>     numrange_t;        /**< A `numrange` value. **/
+    typedef range<date_t>        daterange_t;       /**< A `daterange` value. **/
+    typedef range<timestamp_t>   tsrange_t;         /**< A `tsrange` value. **/
+    typedef range<timestamptz_t> tstzrange_t;       /**< A `tstzrange` value. **/
+
+    typedef multirange<int32_t>       int4multirange_t; /**< An `int4multirange` value. **/
+    typedef multirange<int64_t>       int8multirange_t; /**< An `int8multirange` value. **/
+    typedef multirange<numeric_t>     nummultirange_t;  /**< A `nummultirange` value. **/
+    typedef multirange<date_t>        datemultirange_t; /**< A `datemultirange` value. **/
+    typedef multirange<timestamp_t>   tsmultirange_t;   /**< A `tsmultirange` value. **/
+    typedef multirange<timestamptz_t> tstzmultirange_t; /**< A `tstzmultirange` value. **/
+
     /**
      * A values in an array.
      **/
@@ -273,9 +553,258 @@ namespace db {
     typedef std::vector<array_item<timestamp_t>>   array_timestamp_t;   /**< Array of `timestamp without time zone` values. **/
     typedef std::vector<array_item<timestamptz_t>> array_timestamptz_t; /**< Array of `timestamp with time zone ` values. **/
     typedef std::vector<array_item<interval_t>>    array_interval_t;    /**< Array of `interval` values. **/
+    typedef std::vector<array_item<numeric_t>>     array_numeric_t;     /**< Array of `numeric` values. **/
+    typedef std::vector<array_item<uuid_t>>        array_uuid_t;        /**< Array of `uuid` values. **/
+    typedef std::vector<array_item<macaddr_t>>     array_macaddr_t;     /**< Array of `macaddr` values. **/
+    typedef std::vector<array_item<inet_t>>        array_inet_t;        /**< Array of `inet` values. **/
+    typedef std::vector<array_item<json_t>>        array_json_t;        /**< Array of `json` values. **/
+    typedef std::vector<array_item<jsonb_t>>       array_jsonb_t;       /**< Array of `jsonb` values. **/
+    typedef std::vector<array_item<int4range_t>>   array_int4range_t;   /**< Array of `int4range` values. **/
+    typedef std::vector<array_item<int8range_t>>   array_int8range_t;   /**< Array of `int8range` values. **/
+    typedef std::vector<array_item<numrange_t>>    array_numrange_t;    /**< Array of `numrange` values. **/
+    typedef std::vector<array_item<daterange_t>>   array_daterange_t;   /**< Array of `daterange` values. **/
+    typedef std::vector<array_item<tsrange_t>>     array_tsrange_t;     /**< Array of `tsrange` values. **/
+    typedef std::vector<array_item<tstzrange_t>>   array_tstzrange_t;   /**< Array of `tstzrange` values. **/
+
+    /**
+     * A compact array of values.
+     *
+     * Unlike a `std::vector<array_item<T>>`, values are stored contiguously
+     * and null values are tracked by a separate validity bitmap which is
+     * only allocated once the array contains a null value.
+     *
+     * ```
+     * compact_array<double> values;
+     * row.asArray(0, values);
+     * if (!values.hasNulls()) {
+     *   // values.values can be processed as a plain buffer.
+     * }
+     * ```
+     *
+     * Multi-dimensional arrays are stored flat in row-major order, their
+     * shape being given by `dims`. A 3x2 `float8[][]` has `dims` = { 3, 2 }
+     * and the value `[i][j]` is at the index `i * 2 + j`. An empty array has
+     * no dimension, as for the server.
+     *
+     * Booleans are stored as `uint8_t` (0 or 1), `std::vector<bool>` being
+     * a bitset rather than a buffer of values.
+     **/
+    template <typename T>
+    struct compact_array {
+      typedef typename std::conditional<std::is_same<T, bool>::value, uint8_t, T>::type value_type;
+
+      std::vector<value_type> values;   /**< The values. Null values are set to `T()`. **/
+      std::vector<uint8_t>    validity; /**< Bit `i` is set if the value `i` is not null. Empty if there is no null value. **/
+      std::vector<int32_t>    dims;     /**< Size of each dimension. Empty for a one dimension array of size(). **/
+
+      /**
+       * Number of values, including null values.
+       **/
+      size_t size() const {
+        return values.size();
+      }
+
+      /**
+       * Test if the array contains null values.
+       **/
+      bool hasNulls() const {
+        return !validity.empty();
+      }
+
+      /**
+       * Test a value for a null value.
+       *
+       * @param index Index of the value.
+       **/
+      bool isNull(size_t index) const {
+        return hasNulls() && !(validity[index >> 3] & (1 << (index & 7)));
+      }
+
+      /**
+       * Append a non null value.
+       **/
+      void push_back(const T &value) {
+        values.push_back(value);
+        if (hasNulls()) {
+          setValid(values.size() - 1, true);
+        }
+      }
+
+      /**
+       * Append a null value.
+       **/
+      void push_back(std::nullptr_t) {
+        values.push_back(T());
+        setValid(values.size() - 1, false);
+      }
+
+      /**
+       * Remove all the values.
+       *
+       * The memory allocated by the array is kept to be reused.
+       **/
+      void clear() {
+        values.clear();
+        validity.clear();
+        dims.clear();
+      }
+
+      /**
+       * Number of dimensions.
+       **/
+      size_t ndim() const {
+        return dims.empty() ? (values.empty() ? 0 : 1) : dims.size();
+      }
+
+    private:
+
+      void setValid(size_t index, bool valid) {
+        if (!valid && validity.empty()) {
+          // First null value: all the previous values are valid.
+          validity.assign(values.size() / 8 + 1, 0xFF);
+        }
+        if (validity.size() <= (index >> 3)) {
+          validity.resize((index >> 3) + 1, 0xFF);
+        }
+        if (valid) {
+          validity[index >> 3] |= uint8_t(1 << (index & 7));
+        }
+        else {
+          validity[index >> 3] &= uint8_t(~(1 << (index & 7)));
+        }
+      }
+    };
+
+    /**
+     * A compact array of strings.
+     *
+     * All the characters of the strings are stored in a single buffer, the
+     * string `i` being the characters of `data` from `offsets[i]` to
+     * `offsets[i + 1]`. Null values are tracked by a validity bitmap as for
+     * compact_array.
+     *
+     * ```
+     * string_array tags;
+     * row.asArray(0, tags);
+     * for (size_t i = 0; i < tags.size(); i++) {
+     *   std::cout.write(tags.value(i), tags.length(i));
+     * }
+     * ```
+     **/
+    struct string_array {
+      std::vector<char>    data;     /**< The characters of all the strings. **/
+      std::vector<int32_t> offsets;  /**< Start of each string in `data`, followed by the end of the last one. **/
+      std::vector<uint8_t> validity; /**< Bit `i` is set if the value `i` is not null. Empty if there is no null value. **/
+
+      /**
+       * Number of values, including null values.
+       **/
+      size_t size() const {
+        return offsets.empty() ? 0 : offsets.size() - 1;
+      }
+
+      /**
+       * Test if the array contains null values.
+       **/
+      bool hasNulls() const {
+        return !validity.empty();
+      }
+
+      /**
+       * Test a value for a null value.
+       *
+       * @param index Index of the value.
+       **/
+      bool isNull(size_t index) const {
+        return hasNulls() && !(validity[index >> 3] & (1 << (index & 7)));
+      }
+
+      /**
+       * Characters of a value (not null-terminated).
+       *
+       * @param index Index of the value.
+       **/
+      const char *value(size_t index) const {
+        return data.data() + offsets[index];
+      }
+
+      /**
+       * Length of a value. Null values have a length of 0.
+       *
+       * @param index Index of the value.
+       **/
+      size_t length(size_t index) const {
+        return size_t(offsets[index + 1] - offsets[index]);
+      }
+
+      /**
+       * Copy of a value.
+       *
+       * @param index Index of the value.
+       **/
+      std::string str(size_t index) const {
+        return std::string(value(index), length(index));
+      }
+
+      /**
+       * Append a non null value.
+       **/
+      void push_back(const char *value, size_t length) {
+        if (offsets.empty()) {
+          offsets.push_back(0);
+        }
+        data.insert(data.end(), value, value + length);
+        offsets.push_back(int32_t(data.size()));
+        if (hasNulls()) {
+          setValid(size() - 1, true);
+        }
+      }
+
+      void push_back(const std::string &value) {
+        push_back(value.data(), value.length());
+      }
+
+      /**
+       * Append a null value.
+       **/
+      void push_back(std::nullptr_t) {
+        push_back("", 0);
+        setValid(size() - 1, false);
+      }
+
+      /**
+       * Remove all the values.
+       *
+       * The memory allocated by the array is kept to be reused.
+       **/
+      void clear() {
+        data.clear();
+        offsets.clear();
+        validity.clear();
+      }
+
+    private:
+
+      void setValid(size_t index, bool valid) {
+        if (!valid && validity.empty()) {
+          // First null value: all the previous values are valid.
+          validity.assign(size() / 8 + 1, 0xFF);
+        }
+        if (validity.size() <= (index >> 3)) {
+          validity.resize((index >> 3) + 1, 0xFF);
+        }
+        if (valid) {
+          validity[index >> 3] |= uint8_t(1 << (index & 7));
+        }
+        else {
+          validity[index >> 3] &= uint8_t(~(1 << (index & 7)));
+        }
+      }
+    };
 
     const int32_t DAYS_UNIX_TO_J2000_EPOCH = int32_t(10957);
     const int64_t MICROSEC_UNIX_TO_J2000_EPOCH = int64_t(946684800) * 1000000;
+    const int64_t MICROSEC_PER_DAY = int64_t(86400) * 1000000;
 
     /**
      * Reading a value from a postgresql value buffer.
@@ -288,6 +817,68 @@ namespace db {
     template <typename T>
     T read(char **buf, size_t size = sizeof(T));
 
+    /**
+     * Parsing a value from its text representation.
+     *
+     * Used to read the results of a query executed with Format::TEXT. The
+     * text is expected as printed by the server with the default `DateStyle`
+     * (`ISO`), `IntervalStyle` (`postgres`) and `bytea_output` (`hex`).
+     * Date and time values are also parsed in ISO 8601 as written by
+     * format(). Scalar values are parsed without any allocation.
+     *
+     * @param text   The text of the value (not necessarily null-terminated).
+     * @param length Number of bytes of the text.
+     * @return The value parsed from the text.
+     **/
+    template <typename T>
+    T parse(const char *text, size_t length);
+
+    /**
+     * Maximum length of a date or time value formatted by format().
+     **/
+    const size_t FORMAT_MAX_LENGTH = 64;
+
+    /**
+     * Formatting a date or time value in ISO 8601.
+     *
+     * The text is written without any allocation and can be read back with
+     * parse(). Time stamps use the `T` separator, with `Z` for the UTC time
+     * stamps with time zone, fractional seconds are written without trailing
+     * zeros and intervals are written as durations the way the server does
+     * with `IntervalStyle` set to `iso_8601`.
+     *
+     * ```
+     * char buf[FORMAT_MAX_LENGTH];
+     * char *end = format(row.as<timestamptz_t>(0), buf); // 2016-10-01T07:00:00.5Z
+     * json.append(buf, end - buf);
+     * ```
+     *
+     * @param value The value to format.
+     * @param buf   Buffer receiving the text (not null-terminated), of at
+     *              least FORMAT_MAX_LENGTH bytes.
+     * @return The position next to the end of the text in `buf`.
+     **/
+    char *format(date_t value, char *buf);
+    char *format(time_t value, char *buf);
+    char *format(timetz_t value, char *buf);
+    char *format(timestamp_t value, char *buf);
+    char *format(timestamptz_t value, char *buf);
+    char *format(interval_t value, char *buf);
+
+    /**
+     * Walk through the elements of an array in text format.
+     *
+     * Multi-dimensional arrays are walked in row-major order.
+     *
+     * @param text    Text of the array (`{1,2,NULL}`).
+     * @param length  Number of bytes of the text.
+     * @param element Called for each element with the unquoted text of the
+     *                element and its length, or `nullptr` and -1 for null
+     *                elements.
+     **/
+    void parseElements(const char *text, size_t length,
+                       const std::function<void(const char *text, int32_t length)> &element);
+
     /**
      * Writing a value to a postgresql buffer.
      *
@@ -298,6 +889,11 @@ namespace db {
     template <typename T>
     char *write(T value, char *buf);
     char *write(const std::string &value, char *buf);
+    char *write(const numeric_t &value, char *buf);
+    template <typename T>
+    char *write(const range<T> &value, char *buf);
+    template <typename T>
+    char *write(const multirange<T> &value, char *buf);
 
     /**
      * Length of a value in PostgreSQL buffer.
@@ -311,6 +907,15 @@ namespace db {
     };
     int32_t length(const std::string &value);
     int32_t length(timetz_t value);
+    int32_t length(const numeric_t &value);
+
+    int32_t length(inet_t value);
+    int32_t length(json_t value);
+    int32_t length(jsonb_t value);
+    template <typename T>
+    int32_t length(const range<T> &value);
+    template <typename T>
+    int32_t length(const multirange<T> &value);
 
   } // namespace postgres
 }   // namespace db
@@ -0,0 +1,84 @@
+/**
+ * Copyright (c) 2016 Philippe FERDINAND
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ **/
+#pragma once
+
+#include "postgres-registry.h"
+
+#include <string>
+#include <vector>
+
+#if __cplusplus >= 202002L && defined(__has_include)
+  #if __has_include(<span>)
+    #include <span>
+    #define LIBPQMXX_HAS_SPAN 1
+  #endif
+#endif
+
+namespace db {
+  namespace postgres {
+
+    /**
+     * A `vector` value of the pgvector extension.
+     *
+     * The components are decoded into a contiguous buffer.
+     *
+     * ```
+     * registerVectorTypes();
+     *
+     * auto &result = cnx.execute("SELECT embedding FROM items ORDER BY embedding <-> $1 LIMIT 10", query);
+     * for (auto &row: result) {
+     *   vector_t embedding = row.as<vector_t>(0);
+     *   const float *values = embedding.values.data();
+     *   ...
+     * }
+     * ```
+     **/
+    struct vector_t {
+      std::vector<float> values; /**< The components of the vector. **/
+    };
+
+    /**
+     * A view on the components of a vector, to be used as a parameter
+     * without copying the components into a vector_t.
+     *
+     * The components must remain valid until the execution of the query. With
+     * C++20, a `std::span<const float>` can be used as well.
+     **/
+    struct vector_view_t {
+      const float *data;  /**< The components of the vector. **/
+      size_t       size;  /**< Number of components. **/
+    };
+
+    /**
+     * Register the pgvector types in the TypeRegistry.
+     *
+     * The OID of the `vector` type depends on the database, so the type is
+     * registered by name, the OID being resolved by each connection.
+     * Only the first call registers the types, later calls have no effect.
+     *
+     * @param name SQL name of the `vector` type. It must be schema-qualified
+     *             if the schema of the extension is not in the search path.
+     **/
+    void registerVectorTypes(const std::string &name = "vector");
+
+  } // namespace postgres
+}   // namespace db
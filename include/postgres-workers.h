@@ -0,0 +1,110 @@
+/**
+ * Copyright (c) 2016 Philippe FERDINAND
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ **/
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace db {
+  namespace postgres {
+
+    /**
+     * A pool of worker threads with work stealing.
+     *
+     * Each worker has its own queue of tasks. A task submitted from a worker
+     * is queued on that worker, other tasks are distributed in a round-robin
+     * fashion. An idle worker steals tasks from the other queues.
+     **/
+    class WorkerPool {
+    public:
+
+      /**
+       * Constructor.
+       *
+       * @param threads Number of worker threads. By default one per core.
+       **/
+      explicit WorkerPool(size_t threads = std::thread::hardware_concurrency());
+
+      /**
+       * Destructor.
+       *
+       * Tasks already submitted are run before the workers are stopped.
+       **/
+      ~WorkerPool();
+
+      /**
+       * Submit a task.
+       *
+       * @param task The task to run on one of the workers.
+       *
+       * @attention Tasks must not throw exceptions.
+       **/
+      void submit(std::function<void()> task);
+
+      /**
+       * Number of worker threads.
+       **/
+      size_t size() const noexcept;
+
+    private:
+
+      /**
+       * Queue of a worker.
+       **/
+      struct Queue {
+        std::mutex mutex;
+        std::deque<std::function<void()>> tasks;
+      };
+
+      std::vector<std::unique_ptr<Queue>> queues_;
+      std::vector<std::thread> threads_;
+      std::atomic<size_t> next_;    /**< Next queue for round-robin submissions. **/
+      std::atomic<size_t> queued_;  /**< Number of tasks waiting in queues. **/
+      bool stopped_;
+
+      std::mutex mutex_;            /**< Protects the sleep of idle workers. **/
+      std::condition_variable wakeup_;
+
+      /**
+       * Body of a worker thread.
+       **/
+      void run(size_t index);
+
+      /**
+       * Get a task from the worker's queue or steal one from another queue.
+       **/
+      bool pop(size_t index, std::function<void()> &task);
+
+      WorkerPool(const WorkerPool&) = delete;
+      WorkerPool(const WorkerPool&&) = delete;
+      WorkerPool& operator = (const WorkerPool&) = delete;
+      WorkerPool& operator = (const WorkerPool&&) = delete;
+    };
+
+  } // namespace postgres
+}   // namespace db
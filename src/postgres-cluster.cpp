@@ -0,0 +1,175 @@
+/**
+ * Copyright (c) 2016 Philippe FERDINAND
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ **/
+#include "postgres-cluster.h"
+#include "postgres-exceptions.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+
+namespace db {
+  namespace postgres {
+
+    // -------------------------------------------------------------------------
+    // Hash functions
+    // -------------------------------------------------------------------------
+
+    // Finalizer of MurmurHash3: all the bits of the key affect all the bits of
+    // the hash, consecutive keys are spread over the ring.
+    static inline uint64_t mix(uint64_t h) noexcept {
+      h ^= h >> 33;
+      h *= 0xff51afd7ed558ccdULL;
+      h ^= h >> 33;
+      h *= 0xc4ceb9fe1a85ec53ULL;
+      h ^= h >> 33;
+      return h;
+    }
+
+    // FNV-1a
+    static inline uint64_t hashBytes(const char *data, size_t size) noexcept {
+      uint64_t h = 0xcbf29ce484222325ULL;
+      for (size_t i = 0; i < size; i++) {
+        h ^= uint8_t(data[i]);
+        h *= 0x100000001b3ULL;
+      }
+      return mix(h);
+    }
+
+    uint64_t ShardedCluster::hash(int64_t key) noexcept {
+      return mix(uint64_t(key));
+    }
+
+    uint64_t ShardedCluster::hash(const std::string &key) noexcept {
+      return hashBytes(key.data(), key.size());
+    }
+
+    uint64_t ShardedCluster::hash(const char *key) noexcept {
+      return hashBytes(key, std::strlen(key));
+    }
+
+    // -------------------------------------------------------------------------
+    // Constructor
+    // -------------------------------------------------------------------------
+    ShardedCluster::ShardedCluster(size_t vnodes)
+      : vnodes_(vnodes > 0 ? vnodes : 1), ring_(std::make_shared<Ring>()) {
+    }
+
+    std::shared_ptr<const ShardedCluster::Ring> ShardedCluster::snapshot() const {
+      auto ring = std::atomic_load(&ring_);
+      if (ring->nodes.empty()) {
+        throw ExecutionException("no shard in the cluster");
+      }
+      return ring;
+    }
+
+    size_t ShardedCluster::size() const {
+      return std::atomic_load(&ring_)->nodes.size();
+    }
+
+    // -------------------------------------------------------------------------
+    // Add or remove a shard
+    // -------------------------------------------------------------------------
+    void ShardedCluster::add(const std::string &name, std::shared_ptr<ConnectionPool> pool, size_t weight) {
+      assert(pool && weight > 0);
+      std::lock_guard<std::mutex> lock(mutex_);
+      std::vector<Node> nodes = std::atomic_load(&ring_)->nodes;
+      for (auto &node: nodes) {
+        if (node.name == name) {
+          throw ExecutionException("shard already in the cluster: " + name);
+        }
+      }
+      nodes.push_back({ name, pool, weight });
+      rebuild(std::move(nodes));
+    }
+
+    void ShardedCluster::remove(const std::string &name) {
+      std::lock_guard<std::mutex> lock(mutex_);
+      std::vector<Node> nodes = std::atomic_load(&ring_)->nodes;
+      auto it = std::find_if(nodes.begin(), nodes.end(), [&name](const Node &node) {
+        return node.name == name;
+      });
+      if (it == nodes.end()) {
+        throw ExecutionException("unknown shard: " + name);
+      }
+      nodes.erase(it);
+      rebuild(std::move(nodes));
+    }
+
+    void ShardedCluster::rebuild(std::vector<Node> nodes) {
+      std::shared_ptr<Ring> ring = std::make_shared<Ring>();
+      for (size_t n = 0; n < nodes.size(); n++) {
+        // The points of a node depend only on its name, so the other nodes
+        // keep their points.
+        std::string point = nodes[n].name + '#';
+        size_t prefix = point.size();
+        for (size_t i = 0; i < vnodes_ * nodes[n].weight; i++) {
+          point.resize(prefix);
+          point += std::to_string(i);
+          ring->points.emplace_back(hash(point), n);
+        }
+      }
+      std::sort(ring->points.begin(), ring->points.end());
+      ring->nodes = std::move(nodes);
+      std::atomic_store(&ring_, std::shared_ptr<const Ring>(ring));
+    }
+
+    // -------------------------------------------------------------------------
+    // Shard of a hash
+    // -------------------------------------------------------------------------
+    size_t ShardedCluster::Ring::find(uint64_t hash) const {
+      assert(!points.empty());
+      auto it = std::lower_bound(points.begin(), points.end(), std::make_pair(hash, size_t(0)));
+      if (it == points.end()) {
+        it = points.begin();
+      }
+      return it->second;
+    }
+
+    // -------------------------------------------------------------------------
+    // Receive the results of all the shards
+    // -------------------------------------------------------------------------
+    std::vector<ResultSet> ShardedCluster::gather(std::vector<ConnectionPool::Lease> &leases,
+                                                  const std::vector<bool> &sent,
+                                                  std::exception_ptr error) {
+      // Results are received from all the shards even after an error, so the
+      // connections are given back to their pool with no command in progress.
+      std::vector<ResultSet> sets(leases.size());
+      for (size_t i = 0; i < leases.size(); i++) {
+        if (sent[i]) {
+          try {
+            sets[i] = leases[i]->receive().detach();
+          }
+          catch (...) {
+            if (!error) {
+              error = std::current_exception();
+            }
+          }
+        }
+      }
+      if (error) {
+        std::rethrow_exception(error);
+      }
+      return sets;
+    }
+
+  } // namespace postgres
+}   // namespace db
@@ -268,6 +268,7 @@ namespace db {
     // Open a connection to the database.
     // -------------------------------------------------------------------------
     Connection &Connection::connect(const char *connInfo) {
+      types_.clear();
       pgconn_ = PQconnectdb(connInfo == nullptr ? "" : connInfo);
       
       if( PQstatus(pgconn_) != CONNECTION_OK ) {
@@ -276,6 +277,55 @@ namespace db {
         throw ConnectionException(std::string(PQerrorMessage(pgconn_)));
       }
 
+      resolveTypes();
+      return *this;
+    }
+
+    // -------------------------------------------------------------------------
+    // Resolve the OIDs of the registered types.
+    // -------------------------------------------------------------------------
+    Connection &Connection::resolveTypes() {
+      std::vector<std::string> names = TypeRegistry::names();
+      std::vector<std::pair<Oid, Oid>> types(names.size(), std::make_pair(InvalidOid, InvalidOid));
+
+      if (!names.empty()) {
+        // Several C++ types may share the same SQL name, which is looked up once.
+        std::vector<array_item<std::string>> unresolved;
+        std::vector<size_t> slots(names.size());
+        for (size_t id = 0; id < names.size(); id++) {
+          size_t slot = 0;
+          while (slot < unresolved.size() && unresolved[slot].value != names[id]) {
+            slot++;
+          }
+          if (slot == unresolved.size()) {
+            unresolved.emplace_back(names[id]);
+          }
+          slots[id] = slot;
+        }
+
+        auto &result = execute(R"SQL(
+          SELECT t.oid::int8, t.typarray::int8
+            FROM unnest($1::text[]) WITH ORDINALITY AS n(name, i)
+            LEFT JOIN pg_type t ON t.oid = to_regtype(n.name)
+           ORDER BY n.i
+        )SQL", unresolved);
+
+        std::vector<std::pair<Oid, Oid>> found(unresolved.size(), std::make_pair(InvalidOid, InvalidOid));
+        for (auto &row: result) {
+          if (!row.isNull(0)) {
+            found[size_t(row.num() - 1)] = std::make_pair(Oid(row.as<int64_t>(0)), Oid(row.as<int64_t>(1)));
+          }
+        }
+
+        for (size_t id = 0; id < names.size(); id++) {
+          types[id] = found[slots[id]];
+          if (types[id].first != InvalidOid) {
+            TypeRegistry::resolved(id, types[id].first, types[id].second);
+          }
+        }
+      }
+
+      types_.swap(types);
       return *this;
     }
     
@@ -297,9 +347,9 @@ namespace db {
     }
 
     // -------------------------------------------------------------------------
-    // Execute an SQL statement.
+    // Send SQL commands.
     // -------------------------------------------------------------------------
-    void Connection::execute(const char *sql, const Params &params) {
+    void Connection::send(const char *sql, const Params &params, Format format) {
 
       result_.clear();
 
@@ -310,7 +360,7 @@ namespace db {
                                       params.values_.data(),
                                       params.lengths_.data(),
                                       params.formats_.data(),
-                                      1 /* binary results */);
+                                      int(format));
       }
       else {
         assert(!params.values_.size()); // parameters are allowed only for single commands
@@ -321,7 +371,6 @@ namespace db {
         // Switch to the single row mode to avoid loading the all result in memory.
         success = PQsetSingleRowMode(pgconn_);
         assert(success);
-        result_.first();
       }
 
       if (!success) {
@@ -329,6 +378,14 @@ namespace db {
       }
     }
 
+    // -------------------------------------------------------------------------
+    // Wait for the results.
+    // -------------------------------------------------------------------------
+    Result &Connection::receive() {
+      result_.first();
+      return result_;
+    }
+
     // -------------------------------------------------------------------------
     // Start a transaction.
     // -------------------------------------------------------------------------
@@ -359,6 +416,20 @@ namespace db {
       return *this;
     }
     
+    // -------------------------------------------------------------------------
+    // OID of a registered type.
+    // -------------------------------------------------------------------------
+    Oid Connection::typeOid(size_t id, bool array) const {
+      Oid oid = InvalidOid;
+      if (id < types_.size()) {
+        oid = array ? types_[id].second : types_[id].first;
+      }
+      if (oid == InvalidOid) {
+        throw ExecutionException("type \"" + TypeRegistry::names()[id] + "\" does not exist or is not resolved (see Connection::resolveTypes())");
+      }
+      return oid;
+    }
+
     // -------------------------------------------------------------------------
     // Cancel queries in progress.
     // -------------------------------------------------------------------------
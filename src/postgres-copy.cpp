@@ -0,0 +1,601 @@
+/**
+ * Copyright (c) 2016 Philippe FERDINAND
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ **/
+#include "postgres-copy.h"
+#include "postgres-exceptions.h"
+
+#ifndef _WIN32
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <thread>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace db {
+  namespace postgres {
+
+    // Header of a file in binary format, without the flags and the extension.
+    static const char BINARY_SIGNATURE[] = "PGCOPY\n\377\r\n";
+    static const size_t BINARY_SIGNATURE_LENGTH = 11;
+
+    static inline uint32_t readUint32(const char *p) {
+      const uint8_t *u = reinterpret_cast<const uint8_t *>(p);
+      return uint32_t(u[0]) << 24 | uint32_t(u[1]) << 16 | uint32_t(u[2]) << 8 | uint32_t(u[3]);
+    }
+
+    static inline uint16_t readUint16(const char *p) {
+      const uint8_t *u = reinterpret_cast<const uint8_t *>(p);
+      return uint16_t(u[0] << 8 | u[1]);
+    }
+
+    /**
+     * A file mapped in memory.
+     **/
+    class MappedFile {
+    public:
+      MappedFile(const char *path) : data_(nullptr), size_(0) {
+        int fd = open(path, O_RDONLY | O_CLOEXEC);
+        if (fd == -1) {
+          throw ExecutionException(std::string(path) + ": " + std::strerror(errno));
+        }
+        struct stat st;
+        if (fstat(fd, &st) == -1) {
+          int err = errno;
+          close(fd);
+          throw ExecutionException(std::string(path) + ": " + std::strerror(err));
+        }
+        size_ = size_t(st.st_size);
+        if (size_ > 0) {
+          void *data = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+          if (data == MAP_FAILED) {
+            int err = errno;
+            close(fd);
+            throw ExecutionException(std::string(path) + ": " + std::strerror(err));
+          }
+          // Chunks are read from start to end by each thread.
+          madvise(data, size_, MADV_SEQUENTIAL);
+          data_ = static_cast<const char *>(data);
+        }
+        close(fd);
+      }
+
+      ~MappedFile() {
+        if (data_ != nullptr) {
+          munmap(const_cast<char *>(data_), size_);
+        }
+      }
+
+      const char *data() const { return data_; }
+      size_t size() const { return size_; }
+
+    private:
+      const char *data_;
+      size_t size_;
+    };
+
+    // -------------------------------------------------------------------------
+    // Constructor
+    // -------------------------------------------------------------------------
+    CopyLoader::CopyLoader(std::vector<Connection *> connections)
+      : connections_(connections), format_(FileFormat::CSV), header_(false), delimiter_(0),
+        fields_(0), chunkSize_(1 << 20), rejects_(0), twoPhase_(false) {
+      assert(!connections_.empty());
+    }
+
+    CopyLoader &CopyLoader::format(FileFormat format) {
+      format_ = format;
+      return *this;
+    }
+
+    CopyLoader &CopyLoader::header(bool header) {
+      header_ = header;
+      return *this;
+    }
+
+    CopyLoader &CopyLoader::delimiter(char delimiter) {
+      delimiter_ = delimiter;
+      return *this;
+    }
+
+    CopyLoader &CopyLoader::fields(size_t count) {
+      fields_ = count;
+      return *this;
+    }
+
+    CopyLoader &CopyLoader::chunkSize(size_t size) {
+      chunkSize_ = std::max<size_t>(size, 1);
+      return *this;
+    }
+
+    CopyLoader &CopyLoader::rejects(size_t max) {
+      rejects_ = max;
+      return *this;
+    }
+
+    CopyLoader &CopyLoader::twoPhase(bool enabled) {
+      twoPhase_ = enabled;
+      return *this;
+    }
+
+    const std::vector<size_t> &CopyLoader::committed() const noexcept {
+      return committed_;
+    }
+
+    const std::vector<CopyLoader::Error> &CopyLoader::errors() const noexcept {
+      return errors_;
+    }
+
+    // -------------------------------------------------------------------------
+    // Parse a record
+    // -------------------------------------------------------------------------
+    const char *CopyLoader::record(const char *p, const char *end, size_t &fields) const noexcept {
+      char delimiter = delimiter_ ? delimiter_ : (format_ == FileFormat::CSV ? ',' : '\t');
+      switch (format_) {
+        case FileFormat::CSV: {
+          bool quoted = false;
+          fields = 1;
+          for (; p < end; p++) {
+            char c = *p;
+            if (c == '"') {
+              quoted = !quoted;
+            }
+            else if (!quoted) {
+              if (c == delimiter) {
+                fields++;
+              }
+              else if (c == '\n') {
+                return p + 1;
+              }
+            }
+          }
+          if (quoted) {
+            fields = 0;
+          }
+          return end;
+        }
+
+        case FileFormat::TEXT:
+          fields = 1;
+          for (; p < end; p++) {
+            char c = *p;
+            if (c == '\\') {
+              p++;
+            }
+            else if (c == delimiter) {
+              fields++;
+            }
+            else if (c == '\n') {
+              return p + 1;
+            }
+          }
+          return end;
+
+        case FileFormat::BINARY: {
+          fields = 0;
+          if (end - p < 2) {
+            return end;
+          }
+          int16_t count = int16_t(readUint16(p));
+          p += 2;
+          if (count < 0) {
+            // Trailer: nothing else is read.
+            fields = SIZE_MAX;
+            return end;
+          }
+          for (int16_t i = 0; i < count; i++) {
+            if (end - p < 4) {
+              return end;
+            }
+            int32_t length = int32_t(readUint32(p));
+            p += 4;
+            if (length > 0) {
+              if (end - p < length) {
+                return end;
+              }
+              p += length;
+            }
+          }
+          fields = size_t(count);
+          return p;
+        }
+      }
+      return end;
+    }
+
+    // -------------------------------------------------------------------------
+    // Split a file into chunks
+    // -------------------------------------------------------------------------
+    std::vector<size_t> CopyLoader::split(const char *data, size_t begin, size_t end) {
+      std::vector<size_t> bounds(1, begin);
+
+      if (format_ == FileFormat::BINARY) {
+        // Records are found by following their lengths from the beginning.
+        const char *p = data + begin;
+        const char *last = data + begin;
+        while (p < data + end) {
+          size_t fields;
+          const char *next = record(p, data + end, fields);
+          if (fields == 0) {
+            throw ExecutionException("malformed binary record at offset " + std::to_string(p - data));
+          }
+          if (fields == SIZE_MAX) {
+            end = p - data;
+            break;
+          }
+          p = next;
+          if (size_t(p - last) >= chunkSize_) {
+            bounds.push_back(p - data);
+            last = p;
+          }
+        }
+        if (bounds.back() != end) {
+          bounds.push_back(end);
+        }
+        return bounds;
+      }
+
+      // A chunk starts at the first record starting in a block of the file.
+      size_t blocks = (end - begin + chunkSize_ - 1) / chunkSize_;
+      std::vector<char> quoted(blocks, 0);
+      if (format_ == FileFormat::CSV && blocks > 1) {
+        // A block starts inside quotes if the number of quotes before it is
+        // odd: the quotes of the blocks are counted concurrently.
+        std::vector<size_t> quotes(blocks, 0);
+        std::atomic<size_t> next(0);
+        auto count = [&]() {
+          for (size_t i; (i = next++) < blocks; ) {
+            const char *first = data + begin + i * chunkSize_;
+            const char *last = data + std::min(end, begin + (i + 1) * chunkSize_);
+            quotes[i] = size_t(std::count(first, last, '"'));
+          }
+        };
+        std::vector<std::thread> threads;
+        for (size_t i = 1; i < connections_.size(); i++) {
+          threads.emplace_back(count);
+        }
+        count();
+        for (auto &thread: threads) {
+          thread.join();
+        }
+
+        size_t total = 0;
+        for (size_t i = 0; i < blocks; i++) {
+          quoted[i] = total % 2;
+          total += quotes[i];
+        }
+      }
+
+      for (size_t i = 1; i < blocks; i++) {
+        size_t offset = begin + i * chunkSize_;
+        const char *p = data + offset;
+        const char *last = data + end;
+        if (format_ == FileFormat::CSV) {
+          bool inside = quoted[i] != 0;
+          for (; p < last; p++) {
+            if (*p == '"') {
+              inside = !inside;
+            }
+            else if (*p == '\n' && !inside) {
+              break;
+            }
+          }
+        }
+        else {
+          // A new line preceded by an odd number of backslashes is escaped.
+          for (; p < last; p++) {
+            if (*p == '\n') {
+              const char *b = p;
+              while (b > data + begin && b[-1] == '\\') {
+                b--;
+              }
+              if ((p - b) % 2 == 0) {
+                break;
+              }
+            }
+          }
+        }
+        if (p < last) {
+          size_t bound = size_t(p + 1 - data);
+          if (bound > bounds.back() && bound < end) {
+            bounds.push_back(bound);
+          }
+        }
+      }
+      bounds.push_back(end);
+      return bounds;
+    }
+
+    // -------------------------------------------------------------------------
+    // Load a file
+    // -------------------------------------------------------------------------
+    size_t CopyLoader::load(const char *path, const char *table, const char *columns) {
+      errors_.clear();
+      committed_.clear();
+      MappedFile file(path);
+      const char *data = file.data();
+      size_t begin = 0;
+      size_t end = file.size();
+
+      if (format_ == FileFormat::BINARY) {
+        if (end < BINARY_SIGNATURE_LENGTH + 8 || std::memcmp(data, BINARY_SIGNATURE, BINARY_SIGNATURE_LENGTH) != 0) {
+          throw ExecutionException(std::string(path) + ": not a COPY binary file");
+        }
+        uint32_t flags = readUint32(data + BINARY_SIGNATURE_LENGTH);
+        if (flags & (1 << 16)) {
+          throw ExecutionException(std::string(path) + ": OIDs are not supported");
+        }
+        begin = BINARY_SIGNATURE_LENGTH + 8 + readUint32(data + BINARY_SIGNATURE_LENGTH + 4);
+        begin = std::min(begin, end);
+      }
+      else if (header_) {
+        size_t fields;
+        begin = size_t(record(data, data + end, fields) - data);
+      }
+
+      size_t expected = fields_;
+      if (expected == 0 && begin < end) {
+        record(data + begin, data + end, expected);
+      }
+
+      std::vector<size_t> bounds = split(data, begin, end);
+
+      // COPY command.
+      std::string sql = std::string("COPY ") + table;
+      if (columns != nullptr) {
+        sql += std::string(" (") + columns + ")";
+      }
+      sql += " FROM STDIN (FORMAT ";
+      sql += format_ == FileFormat::CSV ? "csv" : format_ == FileFormat::TEXT ? "text" : "binary";
+      if (delimiter_ != 0 && format_ != FileFormat::BINARY) {
+        sql += ", DELIMITER '";
+        sql += delimiter_ == '\'' ? std::string("''") : std::string(1, delimiter_);
+        sql += "'";
+      }
+      sql += ")";
+
+      std::atomic<size_t> next(0);
+      std::atomic<bool> failed(false);
+      std::atomic<size_t> rejected(0);
+      std::atomic<size_t> rows(0);
+      std::mutex mutex;   // Protects errors_.
+
+      auto worker = [&](size_t index) {
+        Connection &cnx = *connections_[index];
+        PGconn *pgconn = cnx.pgconn_;
+
+        auto report = [&](size_t offset, const std::string &message) {
+          std::lock_guard<std::mutex> lock(mutex);
+          errors_.push_back({ index, offset, message });
+        };
+
+        auto put = [&](const char *p, size_t length) {
+          // Blocks while the server is not reading fast enough.
+          while (length > 0) {
+            int size = int(std::min<size_t>(length, 1 << 30));
+            if (PQputCopyData(pgconn, p, size) != 1) {
+              throw ConnectionException(cnx.lastError());
+            }
+            p += size;
+            length -= size;
+          }
+        };
+
+        try {
+          cnx.execute("BEGIN");
+          PGresult *pgresult = PQexec(pgconn, sql.c_str());
+          ExecStatusType status = PQresultStatus(pgresult);
+          PQclear(pgresult);
+          if (status != PGRES_COPY_IN) {
+            throw ExecutionException(cnx.lastError());
+          }
+        }
+        catch (std::exception &e) {
+          failed = true;
+          report(SIZE_MAX, e.what());
+          return;
+        }
+
+        std::string abort;
+        try {
+          if (format_ == FileFormat::BINARY) {
+            static const char header[19] = { 'P', 'G', 'C', 'O', 'P', 'Y', '\n', '\377', '\r', '\n', 0 };
+            put(header, sizeof(header));
+          }
+
+          for (size_t chunk; !failed && (chunk = next++) + 1 < bounds.size(); ) {
+            const char *p = data + bounds[chunk];
+            const char *last = data + bounds[chunk + 1];
+
+            // Valid records are sent by spans of consecutive records.
+            const char *span = p;
+            while (p < last) {
+              size_t fields;
+              const char *next = record(p, last, fields);
+              if (fields != expected) {
+                put(span, p - span);
+                report(p - data, fields == 0 ? "malformed record"
+                                             : "expected " + std::to_string(expected) + " fields, got " + std::to_string(fields));
+                if (++rejected > rejects_) {
+                  failed = true;
+                  abort = "too many records rejected";
+                  break;
+                }
+                span = next;
+              }
+              p = next;
+            }
+            if (!abort.empty()) {
+              break;
+            }
+            put(span, p - span);
+          }
+
+          if (format_ == FileFormat::BINARY && abort.empty()) {
+            put("\377\377", 2);
+          }
+        }
+        catch (std::exception &e) {
+          failed = true;
+          abort = e.what();
+          report(SIZE_MAX, abort);
+        }
+        if (abort.empty() && failed) {
+          abort = "load failed on another connection";
+        }
+
+        // End of the COPY: the server reports the rows rejected.
+        PQputCopyEnd(pgconn, abort.empty() ? nullptr : abort.c_str());
+        while (PGresult *pgresult = PQgetResult(pgconn)) {
+          ExecStatusType status = PQresultStatus(pgresult);
+          if (status == PGRES_COMMAND_OK) {
+            rows += std::strtoull(PQcmdTuples(pgresult), nullptr, 10);
+          }
+          else if (abort.empty()) {
+            failed = true;
+            report(SIZE_MAX, PQresultErrorMessage(pgresult));
+          }
+          PQclear(pgresult);
+        }
+      };
+
+      std::vector<std::thread> threads;
+      for (size_t i = 1; i < connections_.size(); i++) {
+        threads.emplace_back(worker, i);
+      }
+      worker(0);
+      for (auto &thread: threads) {
+        thread.join();
+      }
+
+      // All or nothing.
+      std::string error;
+      for (auto &e: errors_) {
+        if (e.offset == SIZE_MAX) {
+          error = e.message;
+          break;
+        }
+      }
+      if (error.empty() && failed) {
+        error = "too many records rejected";
+      }
+      if (!failed && twoPhase_) {
+        failed = !commitPrepared(error);
+      }
+      else {
+        for (size_t i = 0; i < connections_.size(); i++) {
+          try {
+            connections_[i]->execute(failed ? "ROLLBACK" : "COMMIT");
+            if (!failed) {
+              committed_.push_back(i);
+            }
+          }
+          catch (std::exception &e) {
+            // The connections not yet committed are rolled back.
+            errors_.push_back({ i, SIZE_MAX, e.what() });
+            if (!failed) {
+              error = e.what();
+            }
+            failed = true;
+          }
+        }
+      }
+      if (failed) {
+        if (!committed_.empty()) {
+          error += " (committed on " + std::to_string(committed_.size()) + " of " + std::to_string(connections_.size()) + " connections)";
+        }
+        throw ExecutionException(error);
+      }
+      return rows;
+    }
+
+    // -------------------------------------------------------------------------
+    // Two-phase commit
+    // -------------------------------------------------------------------------
+    bool CopyLoader::commitPrepared(std::string &error) {
+      static std::atomic<uint64_t> sequence(0);
+      std::string prefix = "libpqmxx_copy_" + std::to_string(getpid()) + "_" + std::to_string(sequence++) + "_";
+
+      // Prepared transactions survive a failure of their connection.
+      std::vector<std::string> prepared;
+      for (size_t i = 0; i < connections_.size(); i++) {
+        if (prepared.size() < i) {
+          // A transaction could not be prepared.
+          try {
+            connections_[i]->execute("ROLLBACK");
+          }
+          catch (std::exception &) {
+          }
+          continue;
+        }
+        std::string gid = prefix + std::to_string(i);
+        try {
+          connections_[i]->execute(("PREPARE TRANSACTION '" + gid + "'").c_str());
+          prepared.push_back(gid);
+        }
+        catch (std::exception &e) {
+          // The transaction is rolled back by the failure of PREPARE.
+          errors_.push_back({ i, SIZE_MAX, e.what() });
+          error = e.what();
+        }
+      }
+
+      // Once all prepared, a transaction is committed from any connection.
+      bool commit = prepared.size() == connections_.size();
+      for (size_t i = 0; i < prepared.size(); i++) {
+        std::string sql = (commit ? "COMMIT PREPARED '" : "ROLLBACK PREPARED '") + prepared[i] + "'";
+        std::string message;
+        size_t j = 0;
+        for (; j < connections_.size(); j++) {
+          try {
+            connections_[(i + j) % connections_.size()]->execute(sql.c_str());
+            break;
+          }
+          catch (std::exception &e) {
+            if (message.empty()) {
+              message = e.what();
+            }
+          }
+        }
+        if (j == connections_.size()) {
+          message = "transaction '" + prepared[i] + "' left prepared: " + message;
+          errors_.push_back({ i, SIZE_MAX, message });
+          error = message;
+        }
+        else if (commit) {
+          committed_.push_back(i);
+        }
+      }
+      return committed_.size() == connections_.size();
+    }
+
+  } // namespace postgres
+}   // namespace db
+
+#endif
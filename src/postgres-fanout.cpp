@@ -0,0 +1,222 @@
+/**
+ * Copyright (c) 2016 Philippe FERDINAND
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ **/
+#include "postgres-fanout.h"
+#include "postgres-exceptions.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+
+#ifdef _WIN32
+  #include <winsock2.h>
+  #define poll WSAPoll
+#else
+  #include <poll.h>
+#endif
+
+namespace db {
+  namespace postgres {
+
+    // -------------------------------------------------------------------------
+    // Constructor
+    // -------------------------------------------------------------------------
+    FanOut::FanOut()
+      : limit_(SIZE_MAX), count_(0), last_(SIZE_MAX), started_(false) {
+    }
+
+    // -------------------------------------------------------------------------
+    // Destructor
+    // -------------------------------------------------------------------------
+    FanOut::~FanOut() {
+      stop();
+    }
+
+    FanOut &FanOut::orderBy(comparator_t less) {
+      assert(!started_);
+      less_ = std::move(less);
+      return *this;
+    }
+
+    FanOut &FanOut::limit(size_t rows) {
+      limit_ = rows;
+      return *this;
+    }
+
+    size_t FanOut::source() const noexcept {
+      return last_;
+    }
+
+    // -------------------------------------------------------------------------
+    // Next row
+    // -------------------------------------------------------------------------
+    const Row *FanOut::next() {
+      if (count_ >= limit_) {
+        // Early termination: the rows left are not needed.
+        stop();
+        return nullptr;
+      }
+
+      try {
+        if (less_) {
+          // k-way merge, the heap gives the stream with the lowest row first.
+          auto greater = [this](size_t a, size_t b) {
+            const Row &ra = streams_[a].cnx->result_;
+            const Row &rb = streams_[b].cnx->result_;
+            return less_(rb, ra) || (!less_(ra, rb) && a > b);
+          };
+
+          if (!started_) {
+            started_ = true;
+            for (size_t i = 0; i < streams_.size(); i++) {
+              if (advance(i)) {
+                ready_.push_back(i);
+              }
+            }
+            std::make_heap(ready_.begin(), ready_.end(), greater);
+          }
+          else if (last_ != SIZE_MAX && advance(last_)) {
+            ready_.push_back(last_);
+            std::push_heap(ready_.begin(), ready_.end(), greater);
+          }
+
+          if (ready_.empty()) {
+            last_ = SIZE_MAX;
+            return nullptr;
+          }
+          std::pop_heap(ready_.begin(), ready_.end(), greater);
+          last_ = ready_.back();
+          ready_.pop_back();
+          count_++;
+          return &streams_[last_].cnx->result_;
+        }
+
+        // Rows in the order they arrive, taking the streams in turn.
+        started_ = true;
+        size_t first = last_ == SIZE_MAX ? 0 : last_ + 1;
+        for (;;) {
+          bool pending = false;
+          for (size_t k = 0; k < streams_.size(); k++) {
+            size_t i = (first + k) % streams_.size();
+            if (streams_[i].done) {
+              continue;
+            }
+            if (PQisBusy(streams_[i].cnx->pgconn_)) {
+              pending = true;
+            }
+            else if (advance(i)) {
+              last_ = i;
+              count_++;
+              return &streams_[i].cnx->result_;
+            }
+          }
+
+          if (!pending) {
+            last_ = SIZE_MAX;
+            return nullptr;
+          }
+          wait();
+        }
+      }
+      catch (...) {
+        stop();
+        throw;
+      }
+    }
+
+    // -------------------------------------------------------------------------
+    // Next row of a stream
+    // -------------------------------------------------------------------------
+    bool FanOut::advance(size_t index) {
+      Stream &stream = streams_[index];
+      Result &result = stream.cnx->result_;
+      stream.done = true;
+      if (!stream.started) {
+        stream.started = true;
+        result.first();
+      }
+      else {
+        result.next();
+      }
+      if (result.status_ == PGRES_SINGLE_TUPLE) {
+        stream.done = false;
+        return true;
+      }
+      return false;
+    }
+
+    // -------------------------------------------------------------------------
+    // Wait for data on the connections
+    // -------------------------------------------------------------------------
+    void FanOut::wait() {
+      std::vector<pollfd> fds;
+      for (auto &stream: streams_) {
+        if (!stream.done) {
+          pollfd fd;
+          fd.fd = PQsocket(stream.cnx->pgconn_);
+          fd.events = POLLIN;
+          fd.revents = 0;
+          fds.push_back(fd);
+        }
+      }
+
+      if (poll(fds.data(), fds.size(), -1) == -1 && errno != EINTR) {
+        throw ConnectionException(std::strerror(errno));
+      }
+
+      for (auto &stream: streams_) {
+        if (!stream.done && !PQconsumeInput(stream.cnx->pgconn_)) {
+          throw ConnectionException(stream.cnx->lastError());
+        }
+      }
+    }
+
+    // -------------------------------------------------------------------------
+    // Cancel the queries in progress
+    // -------------------------------------------------------------------------
+    void FanOut::stop() noexcept {
+      for (auto &stream: streams_) {
+        if (stream.done) {
+          continue;
+        }
+        stream.done = true;
+        try {
+          if (stream.started) {
+            // The rows left are discarded and the query cancelled.
+            stream.cnx->result_.clear();
+          }
+          else {
+            stream.cnx->cancel();
+            while (PGresult *pgresult = PQgetResult(stream.cnx->pgconn_)) {
+              PQclear(pgresult);
+            }
+          }
+        }
+        catch (...) {
+          // The connection is cleaned up by its next query.
+        }
+      }
+      ready_.clear();
+    }
+
+  } // namespace postgres
+}   // namespace db
@@ -0,0 +1,316 @@
+/**
+ * Copyright (c) 2016 Philippe FERDINAND
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ **/
+#include "postgres-multiplexer.h"
+#include "postgres-exceptions.h"
+
+#if defined(LIBPQ_HAS_PIPELINING) && !defined(_WIN32)
+
+#include <cassert>
+#include <cerrno>
+#include <cstring>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+
+namespace db {
+  namespace postgres {
+
+    // -------------------------------------------------------------------------
+    // Constructor
+    // -------------------------------------------------------------------------
+    Multiplexer::Multiplexer(std::shared_ptr<Connection> cnx, size_t batch)
+      : cnx_(cnx), batch_(batch > 0 ? batch : 1), head_(&stub_), tail_(&stub_),
+        sleeping_(false), stopped_(false) {
+      assert(cnx && cnx->pgconn_ != nullptr);
+      assert(!PQisBusy(cnx->pgconn_)); // a query is in progress on the connection.
+      stub_.next.store(nullptr, std::memory_order_relaxed);
+
+      // Parameters are bound by the I/O thread with the OIDs known by the
+      // connection: no query can be executed to resolve them once pipelined.
+      cnx->resolveTypes();
+
+      if (pipe(wakeup_) == -1) {
+        throw ExecutionException(std::strerror(errno));
+      }
+      fcntl(wakeup_[0], F_SETFL, fcntl(wakeup_[0], F_GETFL) | O_NONBLOCK);
+      fcntl(wakeup_[1], F_SETFL, fcntl(wakeup_[1], F_GETFL) | O_NONBLOCK);
+
+      PGconn *pgconn = cnx->pgconn_;
+      if (PQsetnonblocking(pgconn, 1) != 0 || !PQenterPipelineMode(pgconn)) {
+        PQsetnonblocking(pgconn, 0);
+        close(wakeup_[0]);
+        close(wakeup_[1]);
+        throw ConnectionException(cnx->lastError());
+      }
+
+      thread_ = std::thread(&Multiplexer::run, this);
+    }
+
+    // -------------------------------------------------------------------------
+    // Destructor
+    // -------------------------------------------------------------------------
+    Multiplexer::~Multiplexer() {
+      stopped_ = true;
+      notify();
+      thread_.join();
+
+      PGconn *pgconn = cnx_->pgconn_;
+      PQexitPipelineMode(pgconn);
+      PQsetnonblocking(pgconn, 0);
+      close(wakeup_[0]);
+      close(wakeup_[1]);
+    }
+
+    // -------------------------------------------------------------------------
+    // Lock-free queue
+    // -------------------------------------------------------------------------
+    void Multiplexer::push(Query *query) {
+      query->next.store(nullptr, std::memory_order_relaxed);
+      Node *prev = head_.exchange(query, std::memory_order_acq_rel);
+      prev->next.store(query, std::memory_order_release);
+      notify();
+    }
+
+    Multiplexer::Query *Multiplexer::pop() {
+      Node *tail = tail_;
+      Node *next = tail->next.load(std::memory_order_acquire);
+      if (tail == &stub_) {
+        if (next == nullptr) {
+          return nullptr;
+        }
+        tail_ = tail = next;
+        next = next->next.load(std::memory_order_acquire);
+      }
+
+      if (next != nullptr) {
+        tail_ = next;
+        return static_cast<Query *>(tail);
+      }
+
+      if (tail != head_.load(std::memory_order_acquire)) {
+        // A producer is linking a new query: it will be popped next time.
+        return nullptr;
+      }
+
+      // Put the stub back to pop the last query.
+      stub_.next.store(nullptr, std::memory_order_relaxed);
+      Node *prev = head_.exchange(&stub_, std::memory_order_acq_rel);
+      prev->next.store(&stub_, std::memory_order_release);
+      next = tail->next.load(std::memory_order_acquire);
+      if (next != nullptr) {
+        tail_ = next;
+        return static_cast<Query *>(tail);
+      }
+      return nullptr;
+    }
+
+    void Multiplexer::notify() {
+      if (sleeping_.exchange(false)) {
+        char c = 0;
+        while (::write(wakeup_[1], &c, 1) == -1 && errno == EINTR) {
+        }
+      }
+    }
+
+    // -------------------------------------------------------------------------
+    // I/O thread
+    // -------------------------------------------------------------------------
+    void Multiplexer::run() {
+      PGconn *pgconn = cnx_->pgconn_;
+      std::exception_ptr broken;   // Set once the connection is lost.
+      bool flushing = false;
+
+      for (;;) {
+        bool progress = false;
+
+        if (broken) {
+          while (Query *query = pop()) {
+            query->promise.set_exception(broken);
+            delete query;
+          }
+        }
+        else {
+          try {
+            progress = send() > 0;
+            int res = PQflush(pgconn);
+            if (res == -1) {
+              throw ConnectionException(cnx_->lastError());
+            }
+            flushing = res == 1;
+
+            size_t waiting = sent_.size();
+            if (waiting > 0) {
+              if (!receive()) {
+                throw ConnectionException(cnx_->lastError());
+              }
+              progress = progress || sent_.size() < waiting;
+            }
+          }
+          catch (ConnectionException &) {
+            broken = std::current_exception();
+            fail(broken);
+            continue;
+          }
+        }
+
+        if (stopped_ && sent_.empty() && tail_ == &stub_ && stub_.next.load() == nullptr) {
+          return;
+        }
+        if (progress) {
+          continue;
+        }
+
+        // Nothing to do: wait for the results or for new queries.
+        sleeping_ = true;
+        if (tail_ != &stub_ || stub_.next.load() != nullptr || (stopped_ && sent_.empty())) {
+          sleeping_ = false;
+          continue;
+        }
+
+        pollfd fds[2];
+        fds[0].fd = wakeup_[0];
+        fds[0].events = POLLIN;
+        fds[1].fd = PQsocket(pgconn);
+        fds[1].events = POLLIN | (flushing ? POLLOUT : 0);
+        bool waiting = !broken && (!sent_.empty() || flushing);
+        ::poll(fds, waiting ? 2 : 1, -1);
+        sleeping_ = false;
+
+        char buffer[64];
+        while (::read(wakeup_[0], buffer, sizeof(buffer)) > 0) {
+        }
+      }
+    }
+
+    // -------------------------------------------------------------------------
+    // Send the queued queries
+    // -------------------------------------------------------------------------
+    size_t Multiplexer::send() {
+      PGconn *pgconn = cnx_->pgconn_;
+      size_t count = 0;
+      while (count < batch_) {
+        std::unique_ptr<Query> query(pop());
+        if (!query) {
+          break;
+        }
+
+        try {
+          // The parameters are copied by libpq when the query is sent.
+          Params params(*cnx_, query->size);
+          query->bind(params);
+          if (!PQsendQueryParams(pgconn, query->sql.c_str(), int(params.values_.size()),
+                                 params.types_.data(),
+                                 params.values_.data(),
+                                 params.lengths_.data(),
+                                 params.formats_.data(),
+                                 1 /* binary results */)) {
+            ConnectionException e(cnx_->lastError());
+            query->promise.set_exception(std::make_exception_ptr(e));
+            throw e;
+          }
+        }
+        catch (ConnectionException &) {
+          throw;
+        }
+        catch (...) {
+          // Parameters that cannot be bound.
+          query->promise.set_exception(std::current_exception());
+          continue;
+        }
+
+        // A synchronization point after each query: its own implicit transaction.
+#ifdef LIBPQ_HAS_SEND_PIPELINE_SYNC
+        int synced = PQsendPipelineSync(pgconn);
+#else
+        int synced = PQpipelineSync(pgconn);
+#endif
+        sent_.push_back(std::move(query));
+        if (!synced) {
+          throw ConnectionException(cnx_->lastError());
+        }
+        count++;
+      }
+      return count;
+    }
+
+    // -------------------------------------------------------------------------
+    // Read the results
+    // -------------------------------------------------------------------------
+    bool Multiplexer::receive() {
+      PGconn *pgconn = cnx_->pgconn_;
+      if (!PQconsumeInput(pgconn)) {
+        return false;
+      }
+
+      while (!sent_.empty() && !PQisBusy(pgconn)) {
+        PGresult *pgresult = PQgetResult(pgconn);
+        if (pgresult == nullptr) {
+          // End of the results of the query, the synchronization point follows.
+          continue;
+        }
+
+        Query &query = *sent_.front();
+        switch (PQresultStatus(pgresult)) {
+          case PGRES_PIPELINE_SYNC:
+            PQclear(pgresult);
+            if (query.error) {
+              query.promise.set_exception(query.error);
+            }
+            else {
+              query.promise.set_value(std::move(query.rows));
+            }
+            sent_.pop_front();
+            break;
+
+          case PGRES_TUPLES_OK:
+            query.rows.add(pgresult);
+            break;
+
+          case PGRES_BAD_RESPONSE:
+          case PGRES_FATAL_ERROR:
+          case PGRES_PIPELINE_ABORTED:
+            if (!query.error) {
+              query.error = std::make_exception_ptr(ExecutionException(PQresultErrorMessage(pgresult)));
+            }
+            PQclear(pgresult);
+            break;
+
+          default:
+            PQclear(pgresult);
+            break;
+        }
+      }
+      return true;
+    }
+
+    void Multiplexer::fail(std::exception_ptr error) {
+      for (auto &query: sent_) {
+        query->promise.set_exception(error);
+      }
+      sent_.clear();
+    }
+
+  } // namespace postgres
+}   // namespace db
+
+#endif
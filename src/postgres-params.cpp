@@ -32,8 +32,8 @@ namespace db {
     //--------------------------------------------------------------------------
     // Constructor
     //--------------------------------------------------------------------------
-    Params::Params(const Settings &settings, int size)
-    : settings_(settings) {
+    Params::Params(Connection &conn, int size)
+    : settings_(conn.settings_), conn_(conn) {
       types_.reserve(size);
       values_.reserve(size);
       lengths_.reserve(size);
@@ -49,6 +49,10 @@ namespace db {
     template <typename T>
     char *write(T value, char *buf);
 
+    Oid Params::typeOid(size_t id, bool array) const {
+      return conn_.typeOid(id, array);
+    }
+
     char *Params::bind(Oid type, size_t length) {
       char *buf = new char[length];
       buffers_.push_back(buf);
@@ -217,6 +221,124 @@ namespace db {
       write(t, bind(INTERVALOID, sizeof(t)));
     }
 
+    //--------------------------------------------------------------------------
+    // numeric
+    //--------------------------------------------------------------------------
+    template<>
+    void Params::bind(numeric_t n) {
+      n = toArbitrary(n);
+      write(n, bind(NUMERICOID, length(n)));
+    }
+
+    //--------------------------------------------------------------------------
+    // uuid
+    //--------------------------------------------------------------------------
+    template<>
+    void Params::bind(uuid_t u) {
+      write(u, bind(UUIDOID, sizeof(u)));
+    }
+
+    //--------------------------------------------------------------------------
+    // macaddr
+    //--------------------------------------------------------------------------
+    template<>
+    void Params::bind(macaddr_t m) {
+      write(m, bind(MACADDROID, sizeof(m)));
+    }
+
+    //--------------------------------------------------------------------------
+    // inet, cidr
+    //--------------------------------------------------------------------------
+    template<>
+    void Params::bind(inet_t i) {
+      write(i, bind(i.cidr ? CIDROID : INETOID, length(i)));
+    }
+
+    //--------------------------------------------------------------------------
+    // json
+    //--------------------------------------------------------------------------
+    template<>
+    void Params::bind(json_t j) {
+      bind(JSONOID, (char *)j.data, j.length);
+    }
+
+    //--------------------------------------------------------------------------
+    // jsonb
+    //--------------------------------------------------------------------------
+    template<>
+    void Params::bind(jsonb_t j) {
+      write(j, bind(JSONBOID, length(j)));
+    }
+
+    //--------------------------------------------------------------------------
+    // Ranges
+    //--------------------------------------------------------------------------
+    template<>
+    void Params::bind(range<int32_t> r) {
+      write(r, bind(INT4RANGEOID, length(r)));
+    }
+
+    template<>
+    void Params::bind(range<int64_t> r) {
+      write(r, bind(INT8RANGEOID, length(r)));
+    }
+
+    template<>
+    void Params::bind(range<numeric_t> r) {
+      r.lower = toArbitrary(r.lower);
+      r.upper = toArbitrary(r.upper);
+      write(r, bind(NUMRANGEOID, length(r)));
+    }
+
+    template<>
+    void Params::bind(range<date_t> r) {
+      write(r, bind(DATERANGEOID, length(r)));
+    }
+
+    template<>
+    void Params::bind(range<timestamp_t> r) {
+      write(r, bind(TSRANGEOID, length(r)));
+    }
+
+    template<>
+    void Params::bind(range<timestamptz_t> r) {
+      write(r, bind(TSTZRANGEOID, length(r)));
+    }
+
+    template<>
+    void Params::bind(multirange<int32_t> r) {
+      write(r, bind(INT4MULTIRANGEOID, length(r)));
+    }
+
+    template<>
+    void Params::bind(multirange<int64_t> r) {
+      write(r, bind(INT8MULTIRANGEOID, length(r)));
+    }
+
+    template<>
+    void Params::bind(multirange<numeric_t> r) {
+      for (auto &range: r) {
+        range.lower = toArbitrary(range.lower);
+        range.upper = toArbitrary(range.upper);
+      }
+      write(r, bind(NUMMULTIRANGEOID, length(r)));
+    }
+
+    template<>
+    void Params::bind(multirange<date_t> r) {
+      write(r, bind(DATEMULTIRANGEOID, length(r)));
+    }
+
+    template<>
+    void Params::bind(multirange<timestamp_t> r) {
+      write(r, bind(TSMULTIRANGEOID, length(r)));
+    }
+
+    template<>
+    void Params::bind(multirange<timestamptz_t> r) {
+      write(r, bind(TSTZMULTIRANGEOID, length(r)));
+    }
+
     //--------------------------------------------------------------------------
     // Arrays
     //--------------------------------------------------------------------------
@@ -330,5 +452,220 @@ namespace db {
       bind(INTERVALARRAYOID, INTERVALOID, array);
     }
 
+    template<>
+    void Params::bind(const std::vector<array_item<numeric_t>> &array) {
+      std::vector<array_item<numeric_t>> converted(array);
+      for (auto &item: converted) {
+        item.value = toArbitrary(item.value);
+      }
+      bind(NUMERICARRAYOID, NUMERICOID, converted);
+    }
+
+    template<>
+    void Params::bind(const std::vector<array_item<uuid_t>> &array) {
+      bind(UUIDARRAYOID, UUIDOID, array);
+    }
+
+    template<>
+    void Params::bind(const std::vector<array_item<macaddr_t>> &array) {
+      bind(MACADDRARRAYOID, MACADDROID, array);
+    }
+
+    template<>
+    void Params::bind(const std::vector<array_item<inet_t>> &array) {
+      bind(INETARRAYOID, INETOID, array);
+    }
+
+    template<>
+    void Params::bind(const std::vector<array_item<json_t>> &array) {
+      bind(JSONARRAYOID, JSONOID, array);
+    }
+
+    template<>
+    void Params::bind(const std::vector<array_item<jsonb_t>> &array) {
+      bind(JSONBARRAYOID, JSONBOID, array);
+    }
+
+    template<>
+    void Params::bind(const std::vector<array_item<range<int32_t>>> &array) {
+      bind(INT4RANGEARRAYOID, INT4RANGEOID, array);
+    }
+
+    template<>
+    void Params::bind(const std::vector<array_item<range<int64_t>>> &array) {
+      bind(INT8RANGEARRAYOID, INT8RANGEOID, array);
+    }
+
+    template<>
+    void Params::bind(const std::vector<array_item<range<numeric_t>>> &array) {
+      bind(NUMRANGEARRAYOID, NUMRANGEOID, array);
+    }
+
+    template<>
+    void Params::bind(const std::vector<array_item<range<date_t>>> &array) {
+      bind(DATERANGEARRAYOID, DATERANGEOID, array);
+    }
+
+    template<>
+    void Params::bind(const std::vector<array_item<range<timestamp_t>>> &array) {
+      bind(TSRANGEARRAYOID, TSRANGEOID, array);
+    }
+
+    template<>
+    void Params::bind(const std::vector<array_item<range<timestamptz_t>>> &array) {
+      bind(TSTZRANGEARRAYOID, TSTZRANGEOID, array);
+    }
+
+    //--------------------------------------------------------------------------
+    // Compact arrays
+    //--------------------------------------------------------------------------
+
+    template<typename T>
+    void Params::bind(Oid arrayType, Oid elemType, const compact_array<T> &array) {
+
+      // Same layout as arrays of array_item<T> (see above) except for
+      // multi-dimensional arrays. Values of the supported types have a fixed
+      // length.
+      size_t size = array.size();
+      size_t nulls = 0;
+      if (array.hasNulls()) {
+        for (size_t i = 0; i < size; i++) {
+          nulls += array.isNull(i) ? 1 : 0;
+        }
+      }
+
+      // Each dimension has its own size and lower bound, an empty array has
+      // no dimension.
+      int32_t ndim = int32_t(array.ndim());
+#ifndef NDEBUG
+      size_t total = 1;
+      for (int32_t dim: array.dims) {
+        total *= dim;
+      }
+      assert(array.dims.empty() || total == size);
+#endif
+
+      int32_t elemSize = size ? length(T(array.values[0])) : 0;
+      size_t bufferSize = (3 + 2 * ndim) * sizeof(int32_t) // array headers
+                        + size * sizeof(int32_t)           // length of values
+                        + (size - nulls) * elemSize;       // values
+
+      char *buf = bind(arrayType, bufferSize);
+      buf = write(ndim, buf);              /* Number of dimensions */
+      buf = write(int32_t(0), buf);        /* ignored */
+      buf = write(int32_t(elemType), buf); /* type of elements in the array */
+      if (array.dims.empty()) {
+        if (size > 0) {
+          buf = write(int32_t(size), buf); /* Number of elements */
+          buf = write(int32_t(1), buf);    /* Index of first element */
+        }
+      }
+      else {
+        for (int32_t dim: array.dims) {
+          buf = write(dim, buf);           /* Number of elements of the dimension */
+          buf = write(int32_t(1), buf);    /* Lower bound of the dimension */
+        }
+      }
+      for (size_t i = 0; i < size; i++) {
+        if (nulls && array.isNull(i)) {
+          buf = write(int32_t(-1), buf);
+        }
+        else {
+          buf = write(elemSize, buf);
+          buf = write(T(array.values[i]), buf);
+        }
+      }
+    }
+
+    template<>
+    void Params::bind(const compact_array<bool> &array) {
+      bind(BOOLARRAYOID, BOOLOID, array);
+    }
+
+    template<>
+    void Params::bind(const compact_array<int16_t> &array) {
+      bind(INT2ARRAYOID, INT2OID, array);
+    }
+
+    template<>
+    void Params::bind(const compact_array<int32_t> &array) {
+      bind(INT4ARRAYOID, INT4OID, array);
+    }
+
+    template<>
+    void Params::bind(const compact_array<int64_t> &array) {
+      bind(INT8ARRAYOID, INT8OID, array);
+    }
+
+    template<>
+    void Params::bind(const compact_array<float> &array) {
+      bind(FLOAT4ARRAYOID, FLOAT4OID, array);
+    }
+
+    template<>
+    void Params::bind(const compact_array<double> &array) {
+      bind(FLOAT8ARRAYOID, FLOAT8OID, array);
+    }
+
+    template<>
+    void Params::bind(const compact_array<date_t> &array) {
+      bind(DATEARRAYOID, DATEOID, array);
+    }
+
+    template<>
+    void Params::bind(const compact_array<time_t> &array) {
+      bind(TIMEARRAYOID, TIMEOID, array);
+    }
+
+    template<>
+    void Params::bind(const compact_array<timetz_t> &array) {
+      bind(TIMETZARRAYOID, TIMETZOID, array);
+    }
+
+    template<>
+    void Params::bind(const compact_array<timestamp_t> &array) {
+      bind(TIMESTAMPARRAYOID, TIMESTAMPOID, array);
+    }
+
+    template<>
+    void Params::bind(const compact_array<timestamptz_t> &array) {
+      bind(TIMESTAMPTZARRAYOID, TIMESTAMPTZOID, array);
+    }
+
+    template<>
+    void Params::bind(const compact_array<interval_t> &array) {
+      bind(INTERVALARRAYOID, INTERVALOID, array);
+    }
+
+    //--------------------------------------------------------------------------
+    // String arrays
+    //--------------------------------------------------------------------------
+
+    void Params::bind(const string_array &array) {
+
+      // Same layout as arrays of array_item<std::string>.
+      size_t size = array.size();
+      char *buf = bind(VARCHARARRAYOID, 5 * sizeof(int32_t)         // array headers
+                                        + size * sizeof(int32_t)    // length of values
+                                        + array.data.size());       // values
+
+      buf = write(int32_t(1), buf);          /* Number of dimensions */
+      buf = write(int32_t(0), buf);          /* ignored */
+      buf = write(int32_t(VARCHAROID), buf); /* type of elements in the array */
+      buf = write(int32_t(size), buf);       /* Number of elements */
+      buf = write(int32_t(1), buf);          /* Index of first element */
+      for (size_t i = 0; i < size; i++) {
+        int32_t length = int32_t(array.length(i));
+        if (array.isNull(i) || (length == 0 && settings_.emptyStringAsNull)) {
+          buf = write(int32_t(-1), buf);
+        }
+        else {
+          buf = write(length, buf);
+          std::memcpy(buf, array.value(i), length);
+          buf += length;
+        }
+      }
+    }
+
   } // namespace postgres
 }   // namespace db
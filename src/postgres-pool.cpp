@@ -0,0 +1,190 @@
+/**
+ * Copyright (c) 2016 Philippe FERDINAND
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ **/
+#include "postgres-pool.h"
+
+#include <algorithm>
+#include <cassert>
+
+#ifdef __linux__
+#include <sched.h>
+#endif
+
+namespace db {
+  namespace postgres {
+
+    // -------------------------------------------------------------------------
+    // Lease
+    // -------------------------------------------------------------------------
+    ConnectionPool::Lease::Lease() noexcept
+      : pool_(nullptr), cnx_(nullptr) {
+    }
+
+    ConnectionPool::Lease::Lease(ConnectionPool *pool, Connection *cnx) noexcept
+      : pool_(pool), cnx_(cnx) {
+    }
+
+    ConnectionPool::Lease::Lease(Lease &&other) noexcept
+      : pool_(other.pool_), cnx_(other.cnx_) {
+      other.cnx_ = nullptr;
+    }
+
+    ConnectionPool::Lease &ConnectionPool::Lease::operator = (Lease &&other) noexcept {
+      if (this != &other) {
+        release();
+        pool_ = other.pool_;
+        cnx_ = other.cnx_;
+        other.cnx_ = nullptr;
+      }
+      return *this;
+    }
+
+    ConnectionPool::Lease::~Lease() {
+      release();
+    }
+
+    void ConnectionPool::Lease::release() noexcept {
+      if (cnx_ != nullptr) {
+        pool_->push(cnx_);
+        cnx_ = nullptr;
+      }
+    }
+
+    // -------------------------------------------------------------------------
+    // Constructor
+    // -------------------------------------------------------------------------
+    ConnectionPool::ConnectionPool(size_t size, const char *connInfo, Settings settings, size_t shards)
+      : shards_(shards > 0 ? shards : std::max<size_t>(1, std::min<size_t>(size, std::thread::hardware_concurrency()))),
+        waiters_(0) {
+      for (auto &shard: shards_) {
+        // Giving a connection back never allocates.
+        shard.idle.reserve(size);
+        shard.available = 0;
+      }
+      for (size_t i = 0; i < size; i++) {
+        auto cnx = std::make_shared<Connection>(settings);
+        cnx->connect(connInfo);
+        connections_.push_back(cnx);
+
+        Shard &shard = shards_[i % shards_.size()];
+        shard.idle.push_back(cnx.get());
+        shard.available++;
+      }
+    }
+
+    // -------------------------------------------------------------------------
+    // Destructor
+    // -------------------------------------------------------------------------
+    ConnectionPool::~ConnectionPool() {
+      assert(idle() == connections_.size()); // connections still in use.
+    }
+
+    size_t ConnectionPool::size() const noexcept {
+      return connections_.size();
+    }
+
+    size_t ConnectionPool::shards() const noexcept {
+      return shards_.size();
+    }
+
+    size_t ConnectionPool::idle() const noexcept {
+      size_t idle = 0;
+      for (auto &shard: shards_) {
+        idle += shard.available;
+      }
+      return idle;
+    }
+
+    // -------------------------------------------------------------------------
+    // Local shard
+    // -------------------------------------------------------------------------
+    size_t ConnectionPool::local() const noexcept {
+#ifdef __linux__
+      int cpu = sched_getcpu();
+      if (cpu >= 0) {
+        return size_t(cpu) % shards_.size();
+      }
+#endif
+      // One shard per thread in a round-robin fashion.
+      static std::atomic<size_t> next(0);
+      static thread_local size_t index = next.fetch_add(1, std::memory_order_relaxed);
+      return index % shards_.size();
+    }
+
+    // -------------------------------------------------------------------------
+    // Acquire a connection
+    // -------------------------------------------------------------------------
+    ConnectionPool::Lease ConnectionPool::tryAcquire() {
+      return Lease(this, pop(local()));
+    }
+
+    ConnectionPool::Lease ConnectionPool::acquire() {
+      size_t index = local();
+      Connection *cnx = pop(index);
+      if (cnx == nullptr) {
+        // The counter is incremented before looking again at the shards, so
+        // that a connection given back meanwhile is either found or notified.
+        std::unique_lock<std::mutex> lock(mutex_);
+        waiters_++;
+        while ((cnx = pop(index)) == nullptr) {
+          released_.wait(lock);
+        }
+        waiters_--;
+      }
+      return Lease(this, cnx);
+    }
+
+    Connection *ConnectionPool::pop(size_t index) noexcept {
+      for (size_t i = 0; i < shards_.size(); i++) {
+        // Local shard first, then steal from the others.
+        Shard &shard = shards_[(index + i) % shards_.size()];
+        if (shard.available == 0) {
+          continue;
+        }
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        if (!shard.idle.empty()) {
+          Connection *cnx = shard.idle.back();
+          shard.idle.pop_back();
+          shard.available--;
+          return cnx;
+        }
+      }
+      return nullptr;
+    }
+
+    // -------------------------------------------------------------------------
+    // Give a connection back
+    // -------------------------------------------------------------------------
+    void ConnectionPool::push(Connection *cnx) noexcept {
+      Shard &shard = shards_[local()];
+      {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        shard.idle.push_back(cnx);
+        shard.available++;
+      }
+      if (waiters_ > 0) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        released_.notify_one();
+      }
+    }
+
+  } // namespace postgres
+}   // namespace db
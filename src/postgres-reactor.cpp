@@ -0,0 +1,803 @@
+/**
+ * Copyright (c) 2016 Philippe FERDINAND
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ **/
+
+#ifdef __linux__
+
+#include "postgres-reactor.h"
+#include "postgres-exceptions.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cerrno>
+#include <cstring>
+#include <unordered_map>
+
+#include <poll.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#if defined(__has_include)
+  #if __has_include(<linux/io_uring.h>) && defined(__NR_io_uring_setup)
+    #include <linux/io_uring.h>
+    #define LIBPQMXX_HAS_IO_URING 1
+  #endif
+#endif
+
+namespace db {
+  namespace postgres {
+
+    /**
+     * Readiness notifications of the file descriptors watched by the reactor.
+     * The reading interest is permanent, the writing interest is set by
+     * watch().
+     **/
+    class Reactor::Poller {
+    public:
+      struct Event {
+        void *data;
+        bool readable;      /**< Readable, or an error occurred. **/
+      };
+
+      virtual ~Poller() {}
+      virtual void add(int fd, void *data) = 0;
+      virtual void watch(int fd, void *data, bool writing) = 0;
+
+      /**
+       * Stop watching a file descriptor, which may be closed already.
+       **/
+      virtual void remove(int fd) = 0;
+
+      /**
+       * Wait for events.
+       *
+       * @return The number of events, 0 on timeout or interruption.
+       **/
+      virtual int wait(Event *events, int max, int timeout) = 0;
+    };
+
+    // -------------------------------------------------------------------------
+    // epoll backend
+    // -------------------------------------------------------------------------
+    class Reactor::EpollPoller : public Reactor::Poller {
+    public:
+      EpollPoller()
+        : epoll_(epoll_create1(EPOLL_CLOEXEC)) {
+        if (epoll_ == -1) {
+          throw ExecutionException(std::strerror(errno));
+        }
+      }
+
+      ~EpollPoller() {
+        close(epoll_);
+      }
+
+      void add(int fd, void *data) override {
+        control(EPOLL_CTL_ADD, fd, data, false);
+      }
+
+      void watch(int fd, void *data, bool writing) override {
+        control(EPOLL_CTL_MOD, fd, data, writing);
+      }
+
+      void remove(int fd) override {
+        // A closed file descriptor is removed from the set by the kernel.
+        epoll_ctl(epoll_, EPOLL_CTL_DEL, fd, nullptr);
+      }
+
+      int wait(Event *events, int max, int timeout) override {
+        const int MAX_EVENTS = 64;
+        epoll_event ready[MAX_EVENTS];
+        int count = epoll_wait(epoll_, ready, std::min(max, MAX_EVENTS), timeout);
+        if (count == -1) {
+          if (errno != EINTR) {
+            throw ExecutionException(std::strerror(errno));
+          }
+          return 0;
+        }
+        for (int i = 0; i < count; i++) {
+          events[i].data = ready[i].data.ptr;
+          events[i].readable = (ready[i].events & (EPOLLIN | EPOLLERR | EPOLLHUP)) != 0;
+        }
+        return count;
+      }
+
+    private:
+      int epoll_;
+
+      void control(int op, int fd, void *data, bool writing) {
+        epoll_event event;
+        event.events = uint32_t(EPOLLIN) | (writing ? uint32_t(EPOLLOUT) : 0u);
+        event.data.ptr = data;
+        if (epoll_ctl(epoll_, op, fd, &event) == -1) {
+          throw ExecutionException(std::strerror(errno));
+        }
+      }
+    };
+
+#if LIBPQMXX_HAS_IO_URING
+
+    // -------------------------------------------------------------------------
+    // io_uring backend
+    //
+    // Sockets are watched with one-shot IORING_OP_POLL_ADD requests. The
+    // requests re-arming the sockets that became ready are queued in the
+    // submission ring and submitted along with the wait for the next
+    // completions: a single io_uring_enter() per wakeup whatever the number of
+    // ready sockets.
+    // -------------------------------------------------------------------------
+    class Reactor::UringPoller : public Reactor::Poller {
+    public:
+      UringPoller() {
+        io_uring_params params;
+        std::memset(&params, 0, sizeof(params));
+        ring_ = int(syscall(__NR_io_uring_setup, ENTRIES, &params));
+        if (ring_ == -1) {
+          throw ExecutionException(std::strerror(errno));
+        }
+
+        // IORING_FEAT_NODROP comes with Linux 5.5, as IORING_OP_TIMEOUT.
+        sqSize_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        cqSize_ = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        if (!(params.features & IORING_FEAT_NODROP) || !(params.features & IORING_FEAT_SINGLE_MMAP)) {
+          close(ring_);
+          throw ExecutionException("io_uring: kernel not supported");
+        }
+
+        sqSize_ = cqSize_ = std::max(sqSize_, cqSize_);
+        rings_ = mmap(nullptr, sqSize_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_, IORING_OFF_SQ_RING);
+        if (rings_ == MAP_FAILED) {
+          close(ring_);
+          throw ExecutionException(std::strerror(errno));
+        }
+        sqesSize_ = params.sq_entries * sizeof(io_uring_sqe);
+        void *sqes = mmap(nullptr, sqesSize_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_, IORING_OFF_SQES);
+        if (sqes == MAP_FAILED) {
+          munmap(rings_, sqSize_);
+          close(ring_);
+          throw ExecutionException(std::strerror(errno));
+        }
+
+        char *rings = static_cast<char *>(rings_);
+        sqHead_ = reinterpret_cast<unsigned *>(rings + params.sq_off.head);
+        sqTail_ = reinterpret_cast<unsigned *>(rings + params.sq_off.tail);
+        sqMask_ = *reinterpret_cast<unsigned *>(rings + params.sq_off.ring_mask);
+        sqArray_ = reinterpret_cast<unsigned *>(rings + params.sq_off.array);
+        sqEntries_ = params.sq_entries;
+        sqes_ = static_cast<io_uring_sqe *>(sqes);
+        cqHead_ = reinterpret_cast<unsigned *>(rings + params.cq_off.head);
+        cqTail_ = reinterpret_cast<unsigned *>(rings + params.cq_off.tail);
+        cqMask_ = *reinterpret_cast<unsigned *>(rings + params.cq_off.ring_mask);
+        cqes_ = reinterpret_cast<io_uring_cqe *>(rings + params.cq_off.cqes);
+        unsubmitted_ = 0;
+        timer_ = 0;
+      }
+
+      ~UringPoller() {
+        munmap(sqes_, sqesSize_);
+        munmap(rings_, sqSize_);
+        close(ring_);
+      }
+
+      void add(int fd, void *data) override {
+        std::unique_ptr<Watch> &w = watches_[fd];
+        assert(!w); // already watched.
+        w.reset(new Watch());
+        w->fd = fd;
+        w->data = data;
+        w->writing = false;
+        w->removed = false;
+        w->armed = 0;
+        arm(*w, READ);
+      }
+
+      void watch(int fd, void *data, bool writing) override {
+        auto it = watches_.find(fd);
+        assert(it != watches_.end() && it->second->data == data);
+        Watch &w = *it->second;
+        w.writing = writing;
+        if (writing && !(w.armed & WRITE)) {
+          arm(w, WRITE);
+        }
+        // A write request still armed is ignored when completed.
+      }
+
+      void remove(int fd) override {
+        auto it = watches_.find(fd);
+        assert(it != watches_.end());
+        Watch &w = *it->second;
+        w.removed = true;
+        for (uint64_t interest: { READ, WRITE }) {
+          if (w.armed & interest) {
+            io_uring_sqe &sqe = next();
+            sqe.opcode = IORING_OP_POLL_REMOVE;
+            sqe.fd = -1;
+            sqe.addr = reinterpret_cast<uint64_t>(&w) | interest;
+            sqe.user_data = IGNORED;
+          }
+        }
+        // Released once its poll requests are completed, the descriptor may
+        // be reused meanwhile.
+        removed_.push_back(std::move(it->second));
+        watches_.erase(it);
+      }
+
+      int wait(Event *events, int max, int timeout) override {
+        // Re-arm the sockets before waiting.
+        for (Watch *w: ready_) {
+          if (w->removed) {
+            continue;
+          }
+          if (!(w->armed & READ)) {
+            arm(*w, READ);
+          }
+          if (w->writing && !(w->armed & WRITE)) {
+            arm(*w, WRITE);
+          }
+        }
+        ready_.clear();
+
+        // Free the sockets removed once their poll requests are completed.
+        removed_.erase(std::remove_if(removed_.begin(), removed_.end(), [](const std::unique_ptr<Watch> &w) {
+          return w->armed == 0;
+        }), removed_.end());
+
+        bool expired = false;
+        int count = reap(events, max, expired);
+        if (count > 0) {
+          return count;
+        }
+
+        if (timeout == 0) {
+          // Sockets already ready complete their poll request on submission.
+          enter(0, 0);
+          return reap(events, max, expired);
+        }
+
+        if (timeout > 0) {
+          // The completion of a timer from a previous wait is ignored.
+          timer_++;
+          timespec_.tv_sec = timeout / 1000;
+          timespec_.tv_nsec = (timeout % 1000) * 1000000L;
+          io_uring_sqe &sqe = next();
+          sqe.opcode = IORING_OP_TIMEOUT;
+          sqe.fd = -1;
+          sqe.addr = reinterpret_cast<uint64_t>(&timespec_);
+          sqe.len = 1;
+          sqe.user_data = (timer_ << 2) | TIMER;
+        }
+
+        while (count == 0 && !expired) {
+          if (!enter(1, IORING_ENTER_GETEVENTS)) {
+            return 0; // interrupted.
+          }
+          count = reap(events, max, expired);
+        }
+        return count;
+      }
+
+    private:
+      static const unsigned ENTRIES = 1024;
+      static const uint64_t IGNORED = 0;
+      static const uint64_t READ = 1;
+      static const uint64_t WRITE = 2;
+      static const uint64_t TIMER = 3;
+
+      struct Watch {
+        int fd;
+        void *data;
+        bool writing;         /**< Watch the socket for writing. **/
+        bool removed;         /**< No longer watched, poll requests still in progress. **/
+        uint64_t armed;       /**< READ and/or WRITE requests in progress. **/
+      };
+
+      int ring_;
+      void *rings_;
+      size_t sqSize_;
+      size_t cqSize_;
+      size_t sqesSize_;
+      unsigned *sqHead_;
+      unsigned *sqTail_;
+      unsigned sqMask_;
+      unsigned *sqArray_;
+      unsigned sqEntries_;
+      io_uring_sqe *sqes_;
+      unsigned *cqHead_;
+      unsigned *cqTail_;
+      unsigned cqMask_;
+      io_uring_cqe *cqes_;
+      unsigned unsubmitted_;
+
+      uint64_t timer_;                                          /**< Sequence of the current timer. **/
+      __kernel_timespec timespec_;
+      std::unordered_map<int, std::unique_ptr<Watch>> watches_;
+      std::vector<Watch *> ready_;                              /**< Sockets to re-arm. **/
+      std::vector<std::unique_ptr<Watch>> removed_;             /**< Sockets removed, poll requests in progress. **/
+
+      /**
+       * Get a submission queue entry, submitting the queued ones if the queue
+       * is full.
+       **/
+      io_uring_sqe &next() {
+        unsigned tail = *sqTail_;
+        while (tail - __atomic_load_n(sqHead_, __ATOMIC_ACQUIRE) == sqEntries_) {
+          // Entries are released once consumed by the kernel: an interrupted
+          // submission is retried, an entry is never reused before.
+          enter(0, 0);
+        }
+        unsigned index = tail & sqMask_;
+        io_uring_sqe &sqe = sqes_[index];
+        std::memset(&sqe, 0, sizeof(sqe));
+        sqArray_[index] = index;
+        __atomic_store_n(sqTail_, tail + 1, __ATOMIC_RELEASE);
+        unsubmitted_++;
+        return sqe;
+      }
+
+      void arm(Watch &w, uint64_t interest) {
+        io_uring_sqe &sqe = next();
+        sqe.opcode = IORING_OP_POLL_ADD;
+        sqe.fd = w.fd;
+        sqe.poll_events = interest == READ ? POLLIN : POLLOUT;
+        sqe.user_data = reinterpret_cast<uint64_t>(&w) | interest;
+        w.armed |= interest;
+      }
+
+      /**
+       * Submit the queued requests and wait for completions.
+       *
+       * @return false if interrupted.
+       **/
+      bool enter(unsigned min, unsigned flags) {
+        for (;;) {
+          int res = int(syscall(__NR_io_uring_enter, ring_, unsubmitted_, min, flags, nullptr, 0));
+          if (res >= 0) {
+            unsubmitted_ -= unsigned(res);
+            if (unsubmitted_ == 0 || min > 0) {
+              return true;
+            }
+          }
+          else if (errno == EINTR) {
+            return false;
+          }
+          else if (errno != EAGAIN && errno != EBUSY) {
+            throw ExecutionException(std::strerror(errno));
+          }
+        }
+      }
+
+      /**
+       * Read the completions.
+       **/
+      int reap(Event *events, int max, bool &expired) {
+        int count = 0;
+        unsigned head = *cqHead_;
+        unsigned tail = __atomic_load_n(cqTail_, __ATOMIC_ACQUIRE);
+        for (; head != tail && count < max; head++) {
+          const io_uring_cqe &cqe = cqes_[head & cqMask_];
+          uint64_t tag = cqe.user_data & 3;
+          if (tag == TIMER) {
+            expired = expired || (cqe.user_data >> 2) == timer_;
+            continue;
+          }
+          if (tag == IGNORED) {
+            continue;
+          }
+
+          Watch &w = *reinterpret_cast<Watch *>(cqe.user_data & ~uint64_t(3));
+          w.armed &= ~tag;
+          if (w.removed) {
+            continue;
+          }
+          ready_.push_back(&w);
+
+          if (tag == READ || cqe.res < 0 || (cqe.res & (POLLERR | POLLHUP))) {
+            events[count].data = w.data;
+            events[count].readable = true;
+            count++;
+          }
+          else if (w.writing) {
+            events[count].data = w.data;
+            events[count].readable = false;
+            count++;
+          }
+        }
+        __atomic_store_n(cqHead_, head, __ATOMIC_RELEASE);
+        return count;
+      }
+    };
+
+#endif
+
+    // -------------------------------------------------------------------------
+    // Constructor
+    // -------------------------------------------------------------------------
+    Reactor::Reactor(Backend backend)
+      : backend_(Backend::EPOLL), running_(0) {
+#if LIBPQMXX_HAS_IO_URING
+      if (backend != Backend::EPOLL) {
+        try {
+          poller_.reset(new UringPoller());
+          backend_ = Backend::IO_URING;
+        }
+        catch (ExecutionException &) {
+          if (backend == Backend::IO_URING) {
+            throw;
+          }
+        }
+      }
+#else
+      if (backend == Backend::IO_URING) {
+        throw ExecutionException("io_uring: not supported");
+      }
+#endif
+      if (!poller_) {
+        poller_.reset(new EpollPoller());
+      }
+
+      wakeup_ = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+      if (wakeup_ == -1) {
+        throw ExecutionException(std::strerror(errno));
+      }
+      poller_->add(wakeup_, nullptr);
+    }
+
+    // -------------------------------------------------------------------------
+    // Destructor
+    // -------------------------------------------------------------------------
+    Reactor::~Reactor() {
+      for (auto &channel: channels_) {
+        PGconn *pgconn = channel->cnx->pgconn_;
+        PQsetnonblocking(pgconn, 0);
+        if (channel->busy && !channel->done) {
+          // Wait for the end of the query in progress.
+          while (PGresult *pgresult = PQgetResult(pgconn)) {
+            PQclear(pgresult);
+          }
+        }
+      }
+      poller_.reset();
+      close(wakeup_);
+    }
+
+    // -------------------------------------------------------------------------
+    // Add a connection
+    // -------------------------------------------------------------------------
+    void Reactor::add(std::shared_ptr<Connection> cnx) {
+      assert(cnx && cnx->pgconn_ != nullptr);
+      assert(!PQisBusy(cnx->pgconn_)); // a query is in progress on the connection.
+
+      std::unique_ptr<Channel> channel(new Channel());
+      channel->cnx = cnx;
+      channel->socket = PQsocket(cnx->pgconn_);
+      channel->busy = false;
+      channel->done = false;
+      channel->writing = false;
+      channel->broken = false;
+
+      if (PQsetnonblocking(cnx->pgconn_, 1) != 0) {
+        throw ConnectionException(cnx->lastError());
+      }
+
+      poller_->add(channel->socket, channel.get());
+      channels_.push_back(std::move(channel));
+      if (!queue_.empty()) {
+        Query query = std::move(queue_.front());
+        queue_.pop_front();
+        send(*channels_.back(), std::move(query));
+      }
+    }
+
+    size_t Reactor::pending() const noexcept {
+      return queue_.size() + running_;
+    }
+
+    Reactor::Backend Reactor::backend() const noexcept {
+      return backend_;
+    }
+
+    // -------------------------------------------------------------------------
+    // Post a task from any thread
+    // -------------------------------------------------------------------------
+    void Reactor::post(std::function<void()> task) {
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        tasks_.push_back(std::move(task));
+      }
+      notify();
+    }
+
+    void Reactor::notify() {
+      uint64_t one = 1;
+      while (::write(wakeup_, &one, sizeof(one)) == -1 && errno == EINTR) {
+      }
+    }
+
+    // -------------------------------------------------------------------------
+    // Execute a query on the first idle connection
+    // -------------------------------------------------------------------------
+    void Reactor::execute(Query &&query) {
+      for (auto &channel: channels_) {
+        if (!channel->busy && !channel->broken) {
+          send(*channel, std::move(query));
+          return;
+        }
+      }
+      queue_.push_back(std::move(query));
+    }
+
+    // -------------------------------------------------------------------------
+    // Send a query
+    // -------------------------------------------------------------------------
+    void Reactor::send(Channel &channel, Query &&query) {
+      assert(!channel.busy);
+      channel.busy = true;
+      channel.done = false;
+      channel.query = std::move(query);
+      running_++;
+
+      try {
+        // The parameters are copied by libpq when the query is sent.
+        Connection &cnx = *channel.cnx;
+        Params params(cnx, channel.query.size);
+        channel.query.bind(params);
+        if (!PQsendQueryParams(cnx.pgconn_, channel.query.sql.c_str(), int(params.values_.size()),
+                               params.types_.data(),
+                               params.values_.data(),
+                               params.lengths_.data(),
+                               params.formats_.data(),
+                               1 /* binary results */)) {
+          throw ExecutionException(cnx.lastError());
+        }
+      }
+      catch (...) {
+        if (PQstatus(channel.cnx->pgconn_) == CONNECTION_BAD) {
+          lost(channel);
+        }
+        channel.error = std::current_exception();
+        done(channel);
+        return;
+      }
+
+      flush(channel);
+    }
+
+    // -------------------------------------------------------------------------
+    // Flush the data to be sent
+    // -------------------------------------------------------------------------
+    void Reactor::flush(Channel &channel) {
+      int res = PQflush(channel.cnx->pgconn_);
+      if (res == -1) {
+        lost(channel);
+        if (channel.busy && !channel.done) {
+          channel.error = std::make_exception_ptr(ConnectionException(channel.cnx->lastError()));
+          done(channel);
+        }
+        return;
+      }
+      watch(channel, res == 1);
+    }
+
+    // -------------------------------------------------------------------------
+    // Read the data available on the socket
+    // -------------------------------------------------------------------------
+    void Reactor::receive(Channel &channel) {
+      PGconn *pgconn = channel.cnx->pgconn_;
+      if (!PQconsumeInput(pgconn)) {
+        lost(channel);
+        if (channel.busy && !channel.done) {
+          channel.error = std::make_exception_ptr(ConnectionException(channel.cnx->lastError()));
+          done(channel);
+        }
+        return;
+      }
+
+      while (channel.busy && !channel.done && !PQisBusy(pgconn)) {
+        PGresult *pgresult = PQgetResult(pgconn);
+        if (pgresult == nullptr) {
+          done(channel);
+          break;
+        }
+
+        switch (PQresultStatus(pgresult)) {
+          case PGRES_TUPLES_OK:
+            channel.rows.add(pgresult);
+            break;
+
+          case PGRES_BAD_RESPONSE:
+          case PGRES_FATAL_ERROR:
+            if (!channel.error) {
+              channel.error = std::make_exception_ptr(ExecutionException(PQresultErrorMessage(pgresult)));
+            }
+            PQclear(pgresult);
+            break;
+
+          default:
+            PQclear(pgresult);
+            break;
+        }
+      }
+    }
+
+    // -------------------------------------------------------------------------
+    // Connection lost
+    // -------------------------------------------------------------------------
+    void Reactor::lost(Channel &channel) {
+      // The socket would remain readable (e.g. EPOLLHUP): the connection is
+      // no longer watched nor used.
+      if (!channel.broken) {
+        channel.broken = true;
+        poller_->remove(channel.socket);
+      }
+    }
+
+    size_t Reactor::abandon() {
+      if (queue_.empty() || channels_.empty()) {
+        return 0;
+      }
+      for (auto &channel: channels_) {
+        if (!channel->broken) {
+          return 0;
+        }
+      }
+
+      // Removed from the queue before calling back: the queries left are
+      // failed by the next call if a callback throws.
+      size_t count = 0;
+      while (!queue_.empty()) {
+        Query query = std::move(queue_.front());
+        queue_.pop_front();
+        ResultSet rows;
+        query.callback(rows, std::make_exception_ptr(ConnectionException("all the connections are lost")));
+        count++;
+      }
+      return count;
+    }
+
+    // -------------------------------------------------------------------------
+    // Query completion
+    // -------------------------------------------------------------------------
+    void Reactor::done(Channel &channel) {
+      assert(channel.busy && !channel.done);
+      channel.done = true;
+      done_.push_back(&channel);
+    }
+
+    void Reactor::complete(Channel &channel) {
+      assert(channel.done);
+      Query query = std::move(channel.query);
+      ResultSet rows = std::move(channel.rows);
+      std::exception_ptr error = channel.error;
+      channel.error = nullptr;
+      channel.busy = false;
+      channel.done = false;
+      running_--;
+
+      // Keep the connection busy before calling back.
+      if (!queue_.empty() && !channel.broken) {
+        Query next = std::move(queue_.front());
+        queue_.pop_front();
+        send(channel, std::move(next));
+      }
+
+      query.callback(rows, error);
+    }
+
+    // -------------------------------------------------------------------------
+    // Events watched on a socket
+    // -------------------------------------------------------------------------
+    void Reactor::watch(Channel &channel, bool writing) {
+      if (channel.writing == writing) {
+        return;
+      }
+      poller_->watch(channel.socket, &channel, writing);
+      channel.writing = writing;
+    }
+
+    // -------------------------------------------------------------------------
+    // Process the events
+    // -------------------------------------------------------------------------
+    size_t Reactor::poll(int timeout) {
+      const int MAX_EVENTS = 64;
+      Poller::Event events[MAX_EVENTS];
+
+      // Queries left without a connection fail.
+      size_t completed = abandon();
+
+      // Do not wait if queries have been completed when sent.
+      int count = poller_->wait(events, MAX_EVENTS, done_.empty() && completed == 0 ? timeout : 0);
+
+      bool wakeup = false;
+      for (int i = 0; i < count; i++) {
+        if (events[i].data == nullptr) {
+          wakeup = true;
+          continue;
+        }
+        Channel &channel = *static_cast<Channel *>(events[i].data);
+        if (channel.broken) {
+          continue; // reported before being removed.
+        }
+        if (events[i].readable) {
+          receive(channel);
+        }
+        if (channel.writing && !channel.broken) {
+          // libpq may need to read before being able to send more data.
+          flush(channel);
+        }
+      }
+
+      if (wakeup) {
+        uint64_t value;
+        while (::read(wakeup_, &value, sizeof(value)) == -1 && errno == EINTR) {
+        }
+        std::vector<std::function<void()>> tasks;
+        {
+          std::lock_guard<std::mutex> lock(mutex_);
+          tasks.swap(tasks_);
+        }
+        for (size_t i = 0; i < tasks.size(); i++) {
+          try {
+            tasks[i]();
+          }
+          catch (...) {
+            // Keep the other tasks for the next call.
+            {
+              std::lock_guard<std::mutex> lock(mutex_);
+              tasks_.insert(tasks_.begin(), tasks.begin() + i + 1, tasks.end());
+            }
+            notify();
+            throw;
+          }
+        }
+      }
+
+      while (!done_.empty()) {
+        std::vector<Channel *> done;
+        done.swap(done_);
+        for (size_t i = 0; i < done.size(); i++) {
+          try {
+            complete(*done[i]);
+          }
+          catch (...) {
+            // Keep the other completions for the next call.
+            done_.insert(done_.end(), done.begin() + i + 1, done.end());
+            throw;
+          }
+          completed++;
+        }
+      }
+      return completed;
+    }
+
+    void Reactor::run() {
+      assert(!channels_.empty() || pending() == 0); // no connection to run the queries.
+      while (pending() > 0) {
+        poll();
+      }
+    }
+
+  } // namespace postgres
+}   // namespace db
+
+#endif
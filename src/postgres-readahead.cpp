@@ -0,0 +1,109 @@
+/**
+ * Copyright (c) 2016 Philippe FERDINAND
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ **/
+#include "postgres-readahead.h"
+
+#include <cassert>
+
+namespace db {
+  namespace postgres {
+
+    // -------------------------------------------------------------------------
+    // Constructor
+    // -------------------------------------------------------------------------
+    ReadAhead::ReadAhead(Result &result, size_t chunkSize, size_t depth)
+      : result_(result), chunkSize_(chunkSize), ring_(depth), head_(0),
+        count_(0), done_(false), stopped_(false) {
+      assert(chunkSize > 0 && depth > 0);
+      producer_ = std::thread(&ReadAhead::run, this);
+    }
+
+    // -------------------------------------------------------------------------
+    // Destructor
+    // -------------------------------------------------------------------------
+    ReadAhead::~ReadAhead() {
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopped_ = true;
+      }
+      notFull_.notify_one();
+      producer_.join();
+    }
+
+    // -------------------------------------------------------------------------
+    // Get the next chunk of rows.
+    // -------------------------------------------------------------------------
+    bool ReadAhead::next(ResultSet &chunk) {
+      std::unique_lock<std::mutex> lock(mutex_);
+      notEmpty_.wait(lock, [this] { return count_ > 0 || done_; });
+      if (count_ == 0) {
+        if (error_) {
+          std::rethrow_exception(error_);
+        }
+        return false;
+      }
+
+      chunk = std::move(ring_[head_]);
+      head_ = (head_ + 1) % ring_.size();
+      count_--;
+      lock.unlock();
+      notFull_.notify_one();
+      return true;
+    }
+
+    // -------------------------------------------------------------------------
+    // Producer thread.
+    // -------------------------------------------------------------------------
+    void ReadAhead::run() {
+      try {
+        for (;;) {
+          // Rows are detached from the result without holding the lock: this
+          // is where the producer waits on the network.
+          ResultSet chunk = result_.detach(chunkSize_);
+
+          std::unique_lock<std::mutex> lock(mutex_);
+          notFull_.wait(lock, [this] { return stopped_ || count_ < ring_.size(); });
+          if (stopped_) {
+            return;
+          }
+          if (chunk.empty()) {
+            done_ = true;
+            lock.unlock();
+            notEmpty_.notify_one();
+            return;
+          }
+
+          ring_[(head_ + count_) % ring_.size()] = std::move(chunk);
+          count_++;
+          lock.unlock();
+          notEmpty_.notify_one();
+        }
+      }
+      catch (...) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        error_ = std::current_exception();
+        done_ = true;
+        notEmpty_.notify_one();
+      }
+    }
+
+  } // namespace postgres
+}   // namespace db
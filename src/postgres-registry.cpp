@@ -0,0 +1,105 @@
+/**
+ * Copyright (c) 2016 Philippe FERDINAND
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ **/
+#include "postgres-registry.h"
+#include "postgres-exceptions.h"
+
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+
+namespace db {
+  namespace postgres {
+
+    // Names of the registered types. Types may be registered by static
+    // initializers, so the names are created on first use.
+    struct Names {
+      std::mutex mutex;
+      std::vector<std::string> names;
+      std::vector<std::vector<std::pair<Oid, Oid>>> oids; /**< OIDs resolved for each type. **/
+    };
+
+    // Last OID checked successfully for the types, indexed by the type id:
+    // values of a column are checked without locking the names.
+    static std::atomic<uint64_t> checked[64];
+
+    static Names &registered() {
+      static Names names;
+      return names;
+    }
+
+    // -------------------------------------------------------------------------
+    // Register the name of a type
+    // -------------------------------------------------------------------------
+    size_t TypeRegistry::add(const std::string &name) {
+      Names &names = registered();
+      std::lock_guard<std::mutex> lock(names.mutex);
+      names.names.push_back(name);
+      names.oids.emplace_back();
+      return names.names.size() - 1;
+    }
+
+    // -------------------------------------------------------------------------
+    // Record the OIDs resolved by a connection
+    // -------------------------------------------------------------------------
+    void TypeRegistry::resolved(size_t id, Oid oid, Oid array) {
+      Names &names = registered();
+      std::lock_guard<std::mutex> lock(names.mutex);
+      assert(id < names.oids.size());
+      auto &oids = names.oids[id];
+      if (std::find(oids.begin(), oids.end(), std::make_pair(oid, array)) == oids.end()) {
+        oids.push_back(std::make_pair(oid, array));
+      }
+    }
+
+    // -------------------------------------------------------------------------
+    // Check the type of a value
+    // -------------------------------------------------------------------------
+    void TypeRegistry::check(size_t id, Oid oid, bool array) {
+      uint64_t key = uint64_t(id + 1) << 33 | uint64_t(array) << 32 | oid;
+      std::atomic<uint64_t> &last = checked[id % 64];
+      if (last.load(std::memory_order_relaxed) == key) {
+        return;
+      }
+
+      Names &names = registered();
+      std::lock_guard<std::mutex> lock(names.mutex);
+      assert(id < names.oids.size());
+      for (auto &oids: names.oids[id]) {
+        if ((array ? oids.second : oids.first) == oid) {
+          last.store(key, std::memory_order_relaxed);
+          return;
+        }
+      }
+      throw ExecutionException("a value of type " + std::to_string(oid) + " cannot be read as \"" + names.names[id] + (array ? "[]\"" : "\""));
+    }
+
+    // -------------------------------------------------------------------------
+    // Names of the registered types
+    // -------------------------------------------------------------------------
+    std::vector<std::string> TypeRegistry::names() {
+      Names &names = registered();
+      std::lock_guard<std::mutex> lock(names.mutex);
+      return names.names;
+    }
+
+  } // namespace postgres
+}   // namespace db
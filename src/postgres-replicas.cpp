@@ -0,0 +1,121 @@
+/**
+ * Copyright (c) 2016 Philippe FERDINAND
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ **/
+#include "postgres-replicas.h"
+
+#include <cassert>
+
+namespace db {
+  namespace postgres {
+
+    // -------------------------------------------------------------------------
+    // Constructor
+    // -------------------------------------------------------------------------
+    ReplicaRouter::ReplicaRouter(std::shared_ptr<ConnectionPool> primary,
+                                 std::vector<std::shared_ptr<ConnectionPool>> replicas,
+                                 Policy policy,
+                                 bool standalone)
+      : primary_(primary), policy_(policy), standalone_(standalone), next_(0) {
+      assert(primary_);
+      for (auto &pool: replicas) {
+        assert(pool);
+        std::unique_ptr<Replica> replica(new Replica());
+        replica->pool = pool;
+        replica->replayed = 0;
+        replicas_.push_back(std::move(replica));
+      }
+    }
+
+    ConnectionPool::Lease ReplicaRouter::primary() {
+      return primary_->acquire();
+    }
+
+    // -------------------------------------------------------------------------
+    // Positions in the write-ahead log
+    // -------------------------------------------------------------------------
+    lsn_t ReplicaRouter::position(Connection &primary) {
+      return lsn_t(primary.execute("SELECT (pg_current_wal_lsn() - '0/0'::pg_lsn)::int8").as<int64_t>(0));
+    }
+
+    bool ReplicaRouter::replayed(Connection &replica, lsn_t &lsn) {
+      auto &result = replica.execute("SELECT (pg_last_wal_replay_lsn() - '0/0'::pg_lsn)::int8");
+      if (result.isNull(0)) {
+        return false; // not a standby server.
+      }
+      lsn = lsn_t(result.as<int64_t>(0));
+      return true;
+    }
+
+    // -------------------------------------------------------------------------
+    // Acquire a connection to a replica
+    // -------------------------------------------------------------------------
+    ConnectionPool::Lease ReplicaRouter::replica(lsn_t lsn) {
+      size_t count = replicas_.size();
+      if (count == 0) {
+        return primary();
+      }
+
+      // Order in which the replicas are tried.
+      size_t first = 0;
+      if (policy_ == Policy::ROUND_ROBIN) {
+        first = next_.fetch_add(1, std::memory_order_relaxed) % count;
+      }
+      else {
+        size_t most = 0;
+        for (size_t i = 0; i < count; i++) {
+          size_t idle = replicas_[i]->pool->idle();
+          if (idle > most) {
+            most = idle;
+            first = i;
+          }
+        }
+      }
+
+      for (size_t i = 0; i < count; i++) {
+        Replica &replica = *replicas_[(first + i) % count];
+        if (replica.replayed >= lsn) {
+          return replica.pool->acquire();
+        }
+
+        // The cached position is behind: query the current one.
+        auto cnx = replica.pool->acquire();
+        lsn_t replayed = 0;
+        if (!this->replayed(*cnx, replayed)) {
+          // Not cached: the server may become a standby again.
+          if (standalone_) {
+            return cnx;
+          }
+          continue;
+        }
+        lsn_t cached = replica.replayed;
+        while (cached < replayed && !replica.replayed.compare_exchange_weak(cached, replayed)) {
+        }
+        if (replayed >= lsn) {
+          return cnx;
+        }
+      }
+
+      // No replica has caught up.
+      return primary();
+    }
+
+  } // namespace postgres
+}   // namespace db
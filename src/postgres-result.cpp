@@ -59,6 +59,25 @@ namespace db {
           case TIMESTAMPTZOID: _expected = "db::postgres::timestamptz_t"; break;
           case INTERVALOID: _expected = "db::postgres::interval_t"; break;
           case TIMETZOID: _expected = "db::postgres::timetz_t"; break;
+          case NUMERICOID: _expected = "db::postgres::numeric_t"; break;
+          case UUIDOID: _expected = "db::postgres::uuid_t"; break;
+          case MACADDROID: _expected = "db::postgres::macaddr_t"; break;
+          case INETOID: _expected = "db::postgres::inet_t"; break;
+          case CIDROID: _expected = "db::postgres::inet_t"; break;
+          case JSONOID: _expected = "db::postgres::json_t"; break;
+          case JSONBOID: _expected = "db::postgres::jsonb_t"; break;
+          case INT4RANGEOID: _expected = "db::postgres::range<int32_t>"; break;
+          case INT8RANGEOID: _expected = "db::postgres::range<int64_t>"; break;
+          case NUMRANGEOID: _expected = "db::postgres::range<numeric_t>"; break;
+          case DATERANGEOID: _expected = "db::postgres::range<date_t>"; break;
+          case TSRANGEOID: _expected = "db::postgres::range<timestamp_t>"; break;
+          case TSTZRANGEOID: _expected = "db::postgres::range<timestamptz_t>"; break;
+          case INT4MULTIRANGEOID: _expected = "db::postgres::multirange<int32_t>"; break;
+          case INT8MULTIRANGEOID: _expected = "db::postgres::multirange<int64_t>"; break;
+          case NUMMULTIRANGEOID: _expected = "db::postgres::multirange<numeric_t>"; break;
+          case DATEMULTIRANGEOID: _expected = "db::postgres::multirange<date_t>"; break;
+          case TSMULTIRANGEOID: _expected = "db::postgres::multirange<timestamp_t>"; break;
+          case TSTZMULTIRANGEOID: _expected = "db::postgres::multirange<timestamptz_t>"; break;
           default:
             assert(false); // unsupported type. try std::string
         }
@@ -74,268 +93,1336 @@ namespace db {
     // Reading a value from a PGresult
     // -------------------------------------------------------------------------
     template <typename T>
-    T read(const PGresult *pgresult, int column) {
-      char *buf = PQgetvalue(pgresult, 0, column);
-      return read<T>(&buf);
+    T read(const PGresult *pgresult, int row, int column) {
+      char *buf = PQgetvalue(pgresult, row, column);
+      if (PQfformat(pgresult, column) == 0) {
+        return parse<T>(buf, PQgetlength(pgresult, row, column));
+      }
+      return read<T>(&buf, PQgetlength(pgresult, row, column));
+    }
+
+    template <typename T>
+    T read(const PGresult *pgresult, int oid, int row, int column, T defVal) {
+      assert(pgresult != nullptr);
+      assert_oid(PQftype(pgresult, column), oid);
+      return PQgetisnull(pgresult, row, column) ? defVal : read<T>(pgresult, row, column);
+    }
+
+    template<>
+    Record read<Record>(char **buf, size_t size) {
+      Record record(*buf, size);
+      *buf += size;
+      return record;
+    }
+
+    template<typename T>
+    std::vector<array_item<T>> readArray(char *buf, int oid, T defVal) {
+      std::vector<array_item<T>> array;
+
+      if (buf != nullptr) {
+        // The data should look like this:
+        //
+        // struct pg_array {
+        //   int32_t ndim; /* Number of dimensions */
+        //   int32_t ign;  /* offset for data, removed by libpq */
+        //   Oid elemtype; /* type of element in the array */
+        //
+        //   /* First dimension */
+        //   int32_t size;  /* Number of elements */
+        //   int32_t index; /* Index of first element */
+        //   T first_value; /* Beginning of the data */
+        // }
+        int32_t ndim = read<int32_t>(&buf);
+        read<int32_t>(&buf); // skip
+        int32_t elemType = read<int32_t>(&buf);
+        assert_oid(oid, elemType);
+
+        // Multi-dimensional arrays are flattened in row-major order.
+        int32_t size = ndim > 0 ? 1 : 0;
+        for (int32_t dim = 0; dim < ndim; dim++) {
+          size *= read<int32_t>(&buf);
+          read<int32_t>(&buf); // skip the lower bound of the dimension.
+        }
+
+        int32_t elemSize;
+        array.reserve(size);
+        for (int32_t i=0; i < size; i++) {
+          elemSize = read<int32_t>(&buf);
+          array_item<T> elem;
+          if (elemSize == -1) {
+            // null value
+            elem.isNull = true;
+            elem.value = defVal;
+          }
+          else {
+            elem.isNull = false;
+            elem.value = read<T>(&buf, elemSize);
+          }
+
+          array.push_back(std::move(elem));
+        }
+      }
+
+      return array;
+    }
+
+    template<typename T>
+    std::vector<array_item<T>> parseArray(const char *text, size_t length, T defVal) {
+      std::vector<array_item<T>> array;
+      parseElements(text, length, [&](const char *value, int32_t size) {
+        array_item<T> elem;
+        elem.isNull = size == -1;
+        elem.value = elem.isNull ? defVal : parse<T>(value, size);
+        array.push_back(std::move(elem));
+      });
+      return array;
+    }
+
+    template<typename T>
+    std::vector<array_item<T>> readArray(const PGresult *pgresult, int oid, int row, int column, T defVal) {
+      assert(pgresult != nullptr);
+      char *buf = PQgetisnull(pgresult, row, column) ? nullptr : PQgetvalue(pgresult, row, column);
+      if (buf != nullptr && PQfformat(pgresult, column) == 0) {
+        return parseArray<T>(buf, PQgetlength(pgresult, row, column), defVal);
+      }
+      return readArray<T>(buf, oid, defVal);
+    }
+
+    void readElements(char *array, const std::function<void(char *buf, int32_t length)> &element) {
+      if (array == nullptr) {
+        return;
+      }
+
+      char *buf = array;
+      int32_t ndim = read<int32_t>(&buf);
+      read<int32_t>(&buf); // skip
+      read<int32_t>(&buf); // type of elements
+
+      int32_t size = ndim > 0 ? 1 : 0;
+      for (int32_t dim = 0; dim < ndim; dim++) {
+        size *= read<int32_t>(&buf);
+        read<int32_t>(&buf); // skip the lower bound of the dimension.
+      }
+
+      for (int32_t i=0; i < size; i++) {
+        int32_t elemSize = read<int32_t>(&buf);
+        if (elemSize == -1) {
+          element(nullptr, -1);
+        }
+        else {
+          element(buf, elemSize);
+          buf += elemSize;
+        }
+      }
+    }
+
+    template<typename T>
+    void readArray(const PGresult *pgresult, int oid, int row, int column, compact_array<T> &array) {
+      array.clear();
+
+      if (PQgetisnull(pgresult, row, column)) {
+        return;
+      }
+
+      char *buf = PQgetvalue(pgresult, row, column);
+      if (PQfformat(pgresult, column) == 0) {
+        // The text format gives no dimensions: the array is read flattened.
+        parseElements(buf, PQgetlength(pgresult, row, column), [&](const char *value, int32_t size) {
+          if (size == -1) {
+            array.push_back(nullptr);
+          }
+          else {
+            array.push_back(parse<T>(value, size));
+          }
+        });
+        return;
+      }
+
+      int32_t ndim = read<int32_t>(&buf);
+      read<int32_t>(&buf); // skip
+      int32_t elemType = read<int32_t>(&buf);
+      assert_oid(oid, elemType);
+      if (ndim == 0) {
+        return; // empty array
+      }
+
+      int32_t size = 1;
+      if (ndim > 1) {
+        array.dims.resize(ndim);
+      }
+      for (int32_t dim = 0; dim < ndim; dim++) {
+        int32_t length = read<int32_t>(&buf);
+        read<int32_t>(&buf); // skip the lower bound of the dimension.
+        if (ndim > 1) {
+          array.dims[dim] = length;
+        }
+        size *= length;
+      }
+
+      array.values.resize(size);
+      for (int32_t i=0; i < size; i++) {
+        int32_t elemSize = read<int32_t>(&buf);
+        if (elemSize == -1) {
+          if (array.validity.empty()) {
+            // First null value: all the previous values are valid.
+            array.validity.assign((size + 7) / 8, 0xFF);
+          }
+          array.validity[i >> 3] &= uint8_t(~(1 << (i & 7)));
+        }
+        else {
+          array.values[i] = read<T>(&buf, elemSize);
+        }
+      }
+    }
+
+    // -------------------------------------------------------------------------
+    // Row contructor
+    // -------------------------------------------------------------------------
+    Row::Row(PGresult *pgresult, int row, int num)
+    : pgresult_(pgresult), row_(row), num_(num) {
+    }
+
+    int Row::num() const noexcept {
+      return num_;
+    }
+
+    // -------------------------------------------------------------------------
+    // Tests a column for a null value.
+    // -------------------------------------------------------------------------
+    bool Row::isNull(int column) const {
+      assert(pgresult_ != nullptr);
+      return PQgetisnull(pgresult_, row_, column) == 1;
+    }
+
+    // -------------------------------------------------------------------------
+    // Get a column name.
+    // -------------------------------------------------------------------------
+    const char *Row::columnName(int column) const {
+      assert(pgresult_ != nullptr);
+      const char *res = PQfname(pgresult_, column);
+      assert(res);
+      return res;
+    }
+
+    template<>
+    bool Row::as<bool>(int column) const {
+      return read<bool>(pgresult_, BOOLOID, row_, column, false);
+    }
+
+    template<>
+    int16_t Row::as<int16_t>(int column) const {
+      return read<int16_t>(pgresult_, INT2OID, row_, column, 0);
+    }
+
+    template<>
+    int32_t Row::as<int32_t>(int column) const {
+      return read<int32_t>(pgresult_, INT4OID, row_, column, 0);
+    }
+
+    template<>
+    int64_t Row::as<int64_t>(int column) const {
+      return read<int64_t>(pgresult_, INT8OID, row_, column, 0);
+    }
+
+    template<>
+    float Row::as<float>(int column) const {
+      return read<float>(pgresult_, FLOAT4OID, row_, column, 0.f);
+    }
+
+    template<>
+    double Row::as<double>(int column) const {
+      return read<double>(pgresult_, FLOAT8OID, row_, column, 0.);
+    }
+
+    template<>
+    std::string Row::as<std::string>(int column) const {
+      assert(pgresult_ != nullptr);
+      if (PQgetisnull(pgresult_, row_, column)) {
+        return std::string();
+      }
+      int length = PQgetlength(pgresult_, row_, column);
+      char *buf  = PQgetvalue(pgresult_, row_, column);
+      return read<std::string>(&buf, length);
+    }
+
+    // -------------------------------------------------------------------------
+    // "char"
+    // -------------------------------------------------------------------------
+    template<>
+    char Row::as<char>(int column) const {
+      assert(pgresult_ != nullptr);
+      if (PQgetisnull(pgresult_, row_, column)) {
+        return '\0';
+      }
+      assert(PQgetlength(pgresult_, row_, column) == 1);
+      return *PQgetvalue(pgresult_, row_, column);
+    }
+
+    // -------------------------------------------------------------------------
+    // bytea
+    // -------------------------------------------------------------------------
+    template<>
+    std::vector<uint8_t> Row::as<std::vector<uint8_t>>(int column) const {
+      assert(pgresult_ != nullptr);
+      assert_oid(PQftype(pgresult_, column), BYTEAOID);
+      int length = PQgetlength(pgresult_, row_, column);
+      if (isText(column)) {
+        return parse<std::vector<uint8_t>>(PQgetvalue(pgresult_, row_, column), length);
+      }
+      uint8_t *data = reinterpret_cast<uint8_t *>(PQgetvalue(pgresult_, row_, column));
+      return std::vector<uint8_t>(data, data + length);
+    }
+
+    template<>
+    date_t Row::as<date_t>(int column) const {
+      return read<date_t>(pgresult_, DATEOID, row_, column, date_t { 0 });
+    }
+
+    template<>
+    timestamptz_t Row::as<timestamptz_t>(int column) const {
+      return read<timestamptz_t>(pgresult_, TIMESTAMPTZOID, row_, column, timestamptz_t { 0 });
+    }
+
+    template<>
+    timestamp_t Row::as<timestamp_t>(int column) const {
+      return read<timestamp_t>(pgresult_, TIMESTAMPOID, row_, column, timestamp_t { 0 });
+    }
+
+    template<>
+    timetz_t Row::as<timetz_t>(int column) const {
+      return read<timetz_t>(pgresult_, TIMETZOID, row_, column, timetz_t { 0, 0 });
+    }
+
+    template<>
+    time_t Row::as<time_t>(int column) const {
+      return read<time_t>(pgresult_, TIMEOID, row_, column, time_t { 0 });
+    }
+
+    template<>
+    interval_t Row::as<interval_t>(int column) const {
+      return read<interval_t>(pgresult_, INTERVALOID, row_, column, interval_t { 0, 0, 0 });
+    }
+
+    template<>
+    numeric_t Row::as<numeric_t>(int column) const {
+      return read<numeric_t>(pgresult_, NUMERICOID, row_, column, numeric_t());
+    }
+
+    template<>
+    uuid_t Row::as<uuid_t>(int column) const {
+      return read<uuid_t>(pgresult_, UUIDOID, row_, column, uuid_t {{ 0 }});
+    }
+
+    template<>
+    macaddr_t Row::as<macaddr_t>(int column) const {
+      return read<macaddr_t>(pgresult_, MACADDROID, row_, column, macaddr_t {{ 0 }});
+    }
+
+    // -------------------------------------------------------------------------
+    // inet, cidr
+    // -------------------------------------------------------------------------
+    template<>
+    inet_t Row::as<inet_t>(int column) const {
+      assert(pgresult_ != nullptr);
+      assert(PQftype(pgresult_, column) == INETOID || PQftype(pgresult_, column) == CIDROID);
+      inet_t v = read<inet_t>(pgresult_, PQftype(pgresult_, column), row_, column, inet_t { 0, 0, false, { 0 } });
+      if (isText(column)) {
+        v.cidr = PQftype(pgresult_, column) == CIDROID;
+      }
+      return v;
+    }
+
+    template<>
+    json_t Row::as<json_t>(int column) const {
+      return read<json_t>(pgresult_, JSONOID, row_, column, json_t { "", 0 });
+    }
+
+    template<>
+    jsonb_t Row::as<jsonb_t>(int column) const {
+      return read<jsonb_t>(pgresult_, JSONBOID, row_, column, jsonb_t { "", 0 });
+    }
+
+    // -------------------------------------------------------------------------
+    // Values known not to be null (see std::optional)
+    // -------------------------------------------------------------------------
+    template <typename T>
+    static T readValue(const PGresult *pgresult, int oid, int row, int column) {
+      assert(pgresult != nullptr);
+      assert_oid(PQftype(pgresult, column), oid);
+      return read<T>(pgresult, row, column);
+    }
+
+    template<>
+    bool Row::valueOf<bool>(int column) const {
+      return readValue<bool>(pgresult_, BOOLOID, row_, column);
+    }
+
+    template<>
+    int16_t Row::valueOf<int16_t>(int column) const {
+      return readValue<int16_t>(pgresult_, INT2OID, row_, column);
+    }
+
+    template<>
+    int32_t Row::valueOf<int32_t>(int column) const {
+      return readValue<int32_t>(pgresult_, INT4OID, row_, column);
+    }
+
+    template<>
+    int64_t Row::valueOf<int64_t>(int column) const {
+      return readValue<int64_t>(pgresult_, INT8OID, row_, column);
+    }
+
+    template<>
+    float Row::valueOf<float>(int column) const {
+      return readValue<float>(pgresult_, FLOAT4OID, row_, column);
+    }
+
+    template<>
+    double Row::valueOf<double>(int column) const {
+      return readValue<double>(pgresult_, FLOAT8OID, row_, column);
+    }
+
+    template<>
+    std::string Row::valueOf<std::string>(int column) const {
+      return readValue<std::string>(pgresult_, PQftype(pgresult_, column), row_, column);
+    }
+
+    template<>
+    date_t Row::valueOf<date_t>(int column) const {
+      return readValue<date_t>(pgresult_, DATEOID, row_, column);
+    }
+
+    template<>
+    timestamptz_t Row::valueOf<timestamptz_t>(int column) const {
+      return readValue<timestamptz_t>(pgresult_, TIMESTAMPTZOID, row_, column);
+    }
+
+    template<>
+    timestamp_t Row::valueOf<timestamp_t>(int column) const {
+      return readValue<timestamp_t>(pgresult_, TIMESTAMPOID, row_, column);
+    }
+
+    template<>
+    timetz_t Row::valueOf<timetz_t>(int column) const {
+      return readValue<timetz_t>(pgresult_, TIMETZOID, row_, column);
+    }
+
+    template<>
+    time_t Row::valueOf<time_t>(int column) const {
+      return readValue<time_t>(pgresult_, TIMEOID, row_, column);
+    }
+
+    template<>
+    interval_t Row::valueOf<interval_t>(int column) const {
+      return readValue<interval_t>(pgresult_, INTERVALOID, row_, column);
+    }
+
+    template<>
+    numeric_t Row::valueOf<numeric_t>(int column) const {
+      return readValue<numeric_t>(pgresult_, NUMERICOID, row_, column);
+    }
+
+    template<>
+    uuid_t Row::valueOf<uuid_t>(int column) const {
+      return readValue<uuid_t>(pgresult_, UUIDOID, row_, column);
+    }
+
+    template<>
+    macaddr_t Row::valueOf<macaddr_t>(int column) const {
+      return readValue<macaddr_t>(pgresult_, MACADDROID, row_, column);
+    }
+
+    template<>
+    json_t Row::valueOf<json_t>(int column) const {
+      return readValue<json_t>(pgresult_, JSONOID, row_, column);
+    }
+
+    template<>
+    jsonb_t Row::valueOf<jsonb_t>(int column) const {
+      return readValue<jsonb_t>(pgresult_, JSONBOID, row_, column);
+    }
+
+    // -------------------------------------------------------------------------
+    // Arrays
+    // -------------------------------------------------------------------------
+
+    template<>
+    std::vector<array_item<bool>> Row::asArray(int column) const {
+      return readArray<bool>(pgresult_, BOOLOID, row_, column, 0);
+    }
+
+    template<>
+    std::vector<array_item<int16_t>> Row::asArray<int16_t>(int column) const {
+      return readArray<int16_t>(pgresult_, INT2OID, row_, column, 0);
+    }
+
+    template<>
+    std::vector<array_item<int32_t>> Row::asArray<int32_t>(int column) const {
+      return readArray<int32_t>(pgresult_, INT4OID, row_, column, 0);
+    }
+
+    template<>
+    std::vector<array_item<int64_t>> Row::asArray<int64_t>(int column) const {
+      return readArray<int64_t>(pgresult_, INT8OID, row_, column, 0);
+    }
+
+    template<>
+    std::vector<array_item<float>> Row::asArray<float>(int column) const {
+      return readArray<float>(pgresult_, FLOAT4OID, row_, column, 0.f);
+    }
+
+    template<>
+    std::vector<array_item<double>> Row::asArray<double>(int column) const {
+      return readArray<double>(pgresult_, FLOAT8OID, row_, column, 0.);
+    }
+
+    template<>
+    std::vector<array_item<date_t>> Row::asArray<date_t>(int column) const {
+      return readArray<date_t>(pgresult_, DATEOID, row_, column, date_t { 0 });
+    }
+
+    template<>
+    std::vector<array_item<timestamptz_t>> Row::asArray<timestamptz_t>(int column) const {
+      return readArray<timestamptz_t>(pgresult_, TIMESTAMPTZOID, row_, column, timestamptz_t { 0 });
+    }
+
+    template<>
+    std::vector<array_item<timestamp_t>> Row::asArray<timestamp_t>(int column) const {
+      return readArray<timestamp_t>(pgresult_, TIMESTAMPOID, row_, column, timestamp_t { 0 });
+    }
+
+    template<>
+    std::vector<array_item<timetz_t>> Row::asArray<timetz_t>(int column) const {
+      return readArray<timetz_t>(pgresult_, TIMETZOID, row_, column, timetz_t { 0, 0 });
+    }
+
+    template<>
+    std::vector<array_item<time_t>> Row::asArray<time_t>(int column) const {
+      return readArray<time_t>(pgresult_, TIMEOID, row_, column, time_t { 0 });
+    }
+
+    template<>
+    std::vector<array_item<interval_t>> Row::asArray<interval_t>(int column) const {
+      return readArray<interval_t>(pgresult_, INTERVALOID, row_, column, interval_t { 0, 0, 0 });
+    }
+
+    template<>
+    std::vector<array_item<numeric_t>> Row::asArray<numeric_t>(int column) const {
+      return readArray<numeric_t>(pgresult_, NUMERICOID, row_, column, numeric_t());
+    }
+
+    template<>
+    std::vector<array_item<uuid_t>> Row::asArray<uuid_t>(int column) const {
+      return readArray<uuid_t>(pgresult_, UUIDOID, row_, column, uuid_t {{ 0 }});
+    }
+
+    template<>
+    std::vector<array_item<macaddr_t>> Row::asArray<macaddr_t>(int column) const {
+      return readArray<macaddr_t>(pgresult_, MACADDROID, row_, column, macaddr_t {{ 0 }});
+    }
+
+    template<>
+    std::vector<array_item<inet_t>> Row::asArray<inet_t>(int column) const {
+      return readArray<inet_t>(pgresult_, UNKNOWNOID, row_, column, inet_t { 0, 0, false, { 0 } });
+    }
+
+    template<>
+    std::vector<array_item<json_t>> Row::asArray<json_t>(int column) const {
+      return readArray<json_t>(pgresult_, JSONOID, row_, column, json_t { "", 0 });
+    }
+
+    template<>
+    std::vector<array_item<jsonb_t>> Row::asArray<jsonb_t>(int column) const {
+      return readArray<jsonb_t>(pgresult_, JSONBOID, row_, column, jsonb_t { "", 0 });
+    }
+
+    template<>
+    std::vector<array_item<std::string>> Row::asArray<std::string>(int column) const {
+      return readArray<std::string>(pgresult_, UNKNOWNOID, row_, column, std::string());
+    }
+
+    // -------------------------------------------------------------------------
+    // Compact arrays
+    // -------------------------------------------------------------------------
+
+    template<>
+    void Row::asArray<bool>(int column, compact_array<bool> &array) const {
+      readArray<bool>(pgresult_, BOOLOID, row_, column, array);
+    }
+
+    template<>
+    void Row::asArray<int16_t>(int column, compact_array<int16_t> &array) const {
+      readArray<int16_t>(pgresult_, INT2OID, row_, column, array);
+    }
+
+    template<>
+    void Row::asArray<int32_t>(int column, compact_array<int32_t> &array) const {
+      readArray<int32_t>(pgresult_, INT4OID, row_, column, array);
+    }
+
+    template<>
+    void Row::asArray<int64_t>(int column, compact_array<int64_t> &array) const {
+      readArray<int64_t>(pgresult_, INT8OID, row_, column, array);
+    }
+
+    template<>
+    void Row::asArray<float>(int column, compact_array<float> &array) const {
+      readArray<float>(pgresult_, FLOAT4OID, row_, column, array);
+    }
+
+    template<>
+    void Row::asArray<double>(int column, compact_array<double> &array) const {
+      readArray<double>(pgresult_, FLOAT8OID, row_, column, array);
+    }
+
+    template<>
+    void Row::asArray<date_t>(int column, compact_array<date_t> &array) const {
+      readArray<date_t>(pgresult_, DATEOID, row_, column, array);
+    }
+
+    template<>
+    void Row::asArray<timestamptz_t>(int column, compact_array<timestamptz_t> &array) const {
+      readArray<timestamptz_t>(pgresult_, TIMESTAMPTZOID, row_, column, array);
+    }
+
+    template<>
+    void Row::asArray<timestamp_t>(int column, compact_array<timestamp_t> &array) const {
+      readArray<timestamp_t>(pgresult_, TIMESTAMPOID, row_, column, array);
+    }
+
+    template<>
+    void Row::asArray<timetz_t>(int column, compact_array<timetz_t> &array) const {
+      readArray<timetz_t>(pgresult_, TIMETZOID, row_, column, array);
+    }
+
+    template<>
+    void Row::asArray<time_t>(int column, compact_array<time_t> &array) const {
+      readArray<time_t>(pgresult_, TIMEOID, row_, column, array);
+    }
+
+    template<>
+    void Row::asArray<interval_t>(int column, compact_array<interval_t> &array) const {
+      readArray<interval_t>(pgresult_, INTERVALOID, row_, column, array);
+    }
+
+    void Row::asArray(int column, string_array &array) const {
+      array.clear();
+
+      if (PQgetisnull(pgresult_, row_, column)) {
+        return;
+      }
+
+      char *buf = PQgetvalue(pgresult_, row_, column);
+      if (isText(column)) {
+        parseElements(buf, PQgetlength(pgresult_, row_, column), [&](const char *value, int32_t size) {
+          if (size == -1) {
+            array.push_back(nullptr);
+          }
+          else {
+            array.push_back(value, size_t(size));
+          }
+        });
+        return;
+      }
+
+      int32_t ndim = read<int32_t>(&buf);
+      read<int32_t>(&buf); // skip
+      read<int32_t>(&buf); // any type of string
+
+      // Multi-dimensional arrays are flattened in row-major order.
+      int32_t size = ndim > 0 ? 1 : 0;
+      for (int32_t dim = 0; dim < ndim; dim++) {
+        size *= read<int32_t>(&buf);
+        read<int32_t>(&buf); // skip the lower bound of the dimension.
+      }
+
+      // The strings are smaller than the array value: reserving its length
+      // avoids any reallocation of the buffer.
+      array.data.reserve(PQgetlength(pgresult_, row_, column));
+      array.offsets.resize(size + 1);
+      array.offsets[0] = 0;
+      for (int32_t i=0; i < size; i++) {
+        int32_t elemSize = read<int32_t>(&buf);
+        if (elemSize == -1) {
+          if (array.validity.empty()) {
+            // First null value: all the previous values are valid.
+            array.validity.assign((size + 7) / 8, 0xFF);
+          }
+          array.validity[i >> 3] &= uint8_t(~(1 << (i & 7)));
+        }
+        else {
+          array.data.insert(array.data.end(), buf, buf + elemSize);
+          buf += elemSize;
+        }
+        array.offsets[i + 1] = int32_t(array.data.size());
+      }
+    }
+
+    // -------------------------------------------------------------------------
+    // Records
+    // -------------------------------------------------------------------------
+    Record::Record() noexcept
+    : buf_(nullptr), size_(0) {
+    }
+
+    Record::Record(char *buf, size_t length) {
+      // The value should look like this:
+      //
+      // struct pg_record {
+      //   int32_t nfields; /* Number of fields */
+      //
+      //   /* First field */
+      //   Oid type;        /* Type of the field */
+      //   int32_t length;  /* Length of the value, -1 for null values */
+      //   T first_value;   /* Value of the field */
+      // }
+      char *end = buf + length;
+      if (length < sizeof(int32_t)) {
+        throw ExecutionException("invalid record");
+      }
+      size_ = read<int32_t>(&buf);
+      buf_ = buf;
+      if (size_ < 0) {
+        throw ExecutionException("invalid record");
+      }
+
+      // The fields are located once for all.
+      offsets_.reserve(size_t(size_));
+      for (int32_t i = 0; i < size_; i++) {
+        if (end - buf < 2 * int(sizeof(int32_t))) {
+          throw ExecutionException("invalid record");
+        }
+        offsets_.push_back(int32_t(buf - buf_));
+        buf += sizeof(Oid);
+        int32_t length = read<int32_t>(&buf);
+        if (length > end - buf) {
+          throw ExecutionException("invalid record");
+        }
+        if (length > 0) {
+          buf += length;
+        }
+      }
+    }
+
+    int Record::size() const noexcept {
+      return size_;
+    }
+
+    char *Record::field(int field, Oid &type, int32_t &length) const {
+      if (field < 0 || field >= size_) {
+        throw ExecutionException("record field " + std::to_string(field) + " out of range");
+      }
+      char *buf = buf_ + offsets_[size_t(field)];
+      type = Oid(read<int32_t>(&buf));
+      length = read<int32_t>(&buf);
+      return length == -1 ? nullptr : buf;
+    }
+
+    Oid Record::type(int field) const {
+      Oid type;
+      int32_t length;
+      this->field(field, type, length);
+      return type;
+    }
+
+    bool Record::isNull(int field) const {
+      Oid type;
+      int32_t length;
+      return this->field(field, type, length) == nullptr;
+    }
+
+    template<typename T>
+    T Record::value(int field, Oid oid, T defVal) const {
+      Oid type;
+      int32_t length;
+      char *buf = this->field(field, type, length);
+      assert_oid(type, oid);
+      return buf == nullptr ? defVal : read<T>(&buf, length);
+    }
+
+    template<>
+    bool Record::as<bool>(int field) const {
+      return value<bool>(field, BOOLOID, false);
+    }
+
+    template<>
+    int16_t Record::as<int16_t>(int field) const {
+      return value<int16_t>(field, INT2OID, 0);
+    }
+
+    template<>
+    int32_t Record::as<int32_t>(int field) const {
+      return value<int32_t>(field, INT4OID, 0);
+    }
+
+    template<>
+    int64_t Record::as<int64_t>(int field) const {
+      return value<int64_t>(field, INT8OID, 0);
+    }
+
+    template<>
+    float Record::as<float>(int field) const {
+      return value<float>(field, FLOAT4OID, 0.f);
+    }
+
+    template<>
+    double Record::as<double>(int field) const {
+      return value<double>(field, FLOAT8OID, 0.);
+    }
+
+    template<>
+    std::string Record::as<std::string>(int field) const {
+      Oid type;
+      int32_t length;
+      char *buf = this->field(field, type, length);
+      return buf == nullptr ? std::string() : read<std::string>(&buf, length);
+    }
+
+    template<>
+    char Record::as<char>(int field) const {
+      Oid type;
+      int32_t length;
+      char *buf = this->field(field, type, length);
+      if (buf == nullptr) {
+        return '\0';
+      }
+      assert(length == 1);
+      return *buf;
+    }
+
+    template<>
+    std::vector<uint8_t> Record::as<std::vector<uint8_t>>(int field) const {
+      Oid type;
+      int32_t length;
+      uint8_t *data = reinterpret_cast<uint8_t *>(this->field(field, type, length));
+      assert_oid(type, BYTEAOID);
+      return data == nullptr ? std::vector<uint8_t>() : std::vector<uint8_t>(data, data + length);
+    }
+
+    template<>
+    date_t Record::as<date_t>(int field) const {
+      return value<date_t>(field, DATEOID, date_t { 0 });
+    }
+
+    template<>
+    timestamptz_t Record::as<timestamptz_t>(int field) const {
+      return value<timestamptz_t>(field, TIMESTAMPTZOID, timestamptz_t { 0 });
+    }
+
+    template<>
+    timestamp_t Record::as<timestamp_t>(int field) const {
+      return value<timestamp_t>(field, TIMESTAMPOID, timestamp_t { 0 });
+    }
+
+    template<>
+    timetz_t Record::as<timetz_t>(int field) const {
+      return value<timetz_t>(field, TIMETZOID, timetz_t { 0, 0 });
+    }
+
+    template<>
+    time_t Record::as<time_t>(int field) const {
+      return value<time_t>(field, TIMEOID, time_t { 0 });
+    }
+
+    template<>
+    interval_t Record::as<interval_t>(int field) const {
+      return value<interval_t>(field, INTERVALOID, interval_t { 0, 0, 0 });
+    }
+
+    template<>
+    numeric_t Record::as<numeric_t>(int field) const {
+      return value<numeric_t>(field, NUMERICOID, numeric_t());
+    }
+
+    template<>
+    uuid_t Record::as<uuid_t>(int field) const {
+      return value<uuid_t>(field, UUIDOID, uuid_t {{ 0 }});
+    }
+
+    template<>
+    macaddr_t Record::as<macaddr_t>(int field) const {
+      return value<macaddr_t>(field, MACADDROID, macaddr_t {{ 0 }});
+    }
+
+    template<>
+    inet_t Record::as<inet_t>(int field) const {
+      assert(type(field) == INETOID || type(field) == CIDROID);
+      return value<inet_t>(field, type(field), inet_t { 0, 0, false, { 0 } });
+    }
+
+    template<>
+    json_t Record::as<json_t>(int field) const {
+      return value<json_t>(field, JSONOID, json_t { "", 0 });
+    }
+
+    template<>
+    jsonb_t Record::as<jsonb_t>(int field) const {
+      return value<jsonb_t>(field, JSONBOID, jsonb_t { "", 0 });
+    }
+
+    // -------------------------------------------------------------------------
+    // Fields known not to be null (see std::optional)
+    // -------------------------------------------------------------------------
+    template <typename T>
+    static T readField(char *buf, Oid type, Oid oid, int32_t length) {
+      assert_oid(type, oid);
+      return read<T>(&buf, length);
+    }
+
+    template<>
+    bool Record::valueOf<bool>(int, char *buf, Oid type, int32_t length) const {
+      return readField<bool>(buf, type, BOOLOID, length);
+    }
+
+    template<>
+    int16_t Record::valueOf<int16_t>(int, char *buf, Oid type, int32_t length) const {
+      return readField<int16_t>(buf, type, INT2OID, length);
+    }
+
+    template<>
+    int32_t Record::valueOf<int32_t>(int, char *buf, Oid type, int32_t length) const {
+      return readField<int32_t>(buf, type, INT4OID, length);
+    }
+
+    template<>
+    int64_t Record::valueOf<int64_t>(int, char *buf, Oid type, int32_t length) const {
+      return readField<int64_t>(buf, type, INT8OID, length);
+    }
+
+    template<>
+    float Record::valueOf<float>(int, char *buf, Oid type, int32_t length) const {
+      return readField<float>(buf, type, FLOAT4OID, length);
+    }
+
+    template<>
+    double Record::valueOf<double>(int, char *buf, Oid type, int32_t length) const {
+      return readField<double>(buf, type, FLOAT8OID, length);
+    }
+
+    template<>
+    std::string Record::valueOf<std::string>(int, char *buf, Oid type, int32_t length) const {
+      return readField<std::string>(buf, type, type, length);
     }
 
-    template <typename T>
-    T read(const PGresult *pgresult, int oid, int column, T defVal) {
-      assert(pgresult != nullptr);
-      assert_oid(PQftype(pgresult, column), oid);
-      return PQgetisnull(pgresult, 0, column) ? defVal : read<T>(pgresult, column);
+    template<>
+    date_t Record::valueOf<date_t>(int, char *buf, Oid type, int32_t length) const {
+      return readField<date_t>(buf, type, DATEOID, length);
     }
 
-    template<typename T>
-    std::vector<array_item<T>> readArray(const PGresult *pgresult, int oid, int column, T defVal) {
-      std::vector<array_item<T>> array;
+    template<>
+    timestamptz_t Record::valueOf<timestamptz_t>(int, char *buf, Oid type, int32_t length) const {
+      return readField<timestamptz_t>(buf, type, TIMESTAMPTZOID, length);
+    }
 
-      if (!PQgetisnull(pgresult, 0, column)) {
-        // The data should look like this:
-        //
-        // struct pg_array {
-        //   int32_t ndim; /* Number of dimensions */
-        //   int32_t ign;  /* offset for data, removed by libpq */
-        //   Oid elemtype; /* type of element in the array */
-        //
-        //   /* First dimension */
-        //   int32_t size;  /* Number of elements */
-        //   int32_t index; /* Index of first element */
-        //   T first_value; /* Beginning of the data */
-        // }
-        char *buf = PQgetvalue(pgresult, 0, column);
-        int32_t ndim = read<int32_t>(&buf);
-        read<int32_t>(&buf); // skip
-        int32_t elemType = read<int32_t>(&buf);
-        assert_oid(oid, elemType);
-        assert(ndim == 1); // only array of 1 dimmension are supported so far.
+    template<>
+    timestamp_t Record::valueOf<timestamp_t>(int, char *buf, Oid type, int32_t length) const {
+      return readField<timestamp_t>(buf, type, TIMESTAMPOID, length);
+    }
 
-        // First dimension
-        int32_t size = read<int32_t>(&buf);
-        read<int32_t>(&buf); // skip the index of first element.
+    template<>
+    timetz_t Record::valueOf<timetz_t>(int, char *buf, Oid type, int32_t length) const {
+      return readField<timetz_t>(buf, type, TIMETZOID, length);
+    }
 
-        int32_t elemSize;
-        array.reserve(size);
-        for (int32_t i=0; i < size; i++) {
-          elemSize = read<int32_t>(&buf);
-          array_item<T> elem;
-          if (elemSize == -1) {
-            // null value
-            elem.isNull = true;
-            elem.value = defVal;
-          }
-          else {
-            elem.isNull = false;
-            elem.value = read<T>(&buf, elemSize);
-          }
+    template<>
+    time_t Record::valueOf<time_t>(int, char *buf, Oid type, int32_t length) const {
+      return readField<time_t>(buf, type, TIMEOID, length);
+    }
 
-          array.push_back(std::move(elem));
-        }
-      }
+    template<>
+    interval_t Record::valueOf<interval_t>(int, char *buf, Oid type, int32_t length) const {
+      return readField<interval_t>(buf, type, INTERVALOID, length);
+    }
 
-      return array;
+    template<>
+    numeric_t Record::valueOf<numeric_t>(int, char *buf, Oid type, int32_t length) const {
+      return readField<numeric_t>(buf, type, NUMERICOID, length);
     }
 
-    // -------------------------------------------------------------------------
-    // Row contructor
-    // -------------------------------------------------------------------------
-    Row::Row(Result &result)
-    : result_(result) {
+    template<>
+    uuid_t Record::valueOf<uuid_t>(int, char *buf, Oid type, int32_t length) const {
+      return readField<uuid_t>(buf, type, UUIDOID, length);
     }
 
-    int Row::num() const noexcept {
-      return result_.num_;
+    template<>
+    macaddr_t Record::valueOf<macaddr_t>(int, char *buf, Oid type, int32_t length) const {
+      return readField<macaddr_t>(buf, type, MACADDROID, length);
     }
 
-    // -------------------------------------------------------------------------
-    // Tests a column for a null value.
-    // -------------------------------------------------------------------------
-    bool Row::isNull(int column) const {
-      assert(result_.pgresult_ != nullptr);
-      return PQgetisnull(result_, 0, column) == 1;
+    template<>
+    json_t Record::valueOf<json_t>(int, char *buf, Oid type, int32_t length) const {
+      return readField<json_t>(buf, type, JSONOID, length);
     }
 
-    // -------------------------------------------------------------------------
-    // Get a column name.
-    // -------------------------------------------------------------------------
-    const char *Row::columnName(int column) const {
-      assert(result_.pgresult_ != nullptr);
-      const char *res = PQfname(result_, column);
-      assert(res);
-      return res;
+    template<>
+    jsonb_t Record::valueOf<jsonb_t>(int, char *buf, Oid type, int32_t length) const {
+      return readField<jsonb_t>(buf, type, JSONBOID, length);
     }
 
     template<>
-    bool Row::as<bool>(int column) const {
-      return read<bool>(result_, BOOLOID, column, false);
+    Record Record::as<Record>(int field) const {
+      Oid type;
+      int32_t length;
+      char *buf = this->field(field, type, length);
+      return buf == nullptr ? Record() : Record(buf, length);
     }
 
     template<>
-    int16_t Row::as<int16_t>(int column) const {
-      return read<int16_t>(result_, INT2OID, column, 0);
+    std::vector<array_item<bool>> Record::asArray<bool>(int field) const {
+      Oid type;
+      int32_t length;
+      return readArray<bool>(this->field(field, type, length), BOOLOID, false);
     }
 
     template<>
-    int32_t Row::as<int32_t>(int column) const {
-      return read<int32_t>(result_, INT4OID, column, 0);
+    std::vector<array_item<int16_t>> Record::asArray<int16_t>(int field) const {
+      Oid type;
+      int32_t length;
+      return readArray<int16_t>(this->field(field, type, length), INT2OID, 0);
     }
 
     template<>
-    int64_t Row::as<int64_t>(int column) const {
-      return read<int64_t>(result_, INT8OID, column, 0);
+    std::vector<array_item<int32_t>> Record::asArray<int32_t>(int field) const {
+      Oid type;
+      int32_t length;
+      return readArray<int32_t>(this->field(field, type, length), INT4OID, 0);
     }
 
     template<>
-    float Row::as<float>(int column) const {
-      return read<float>(result_, FLOAT4OID, column, 0.f);
+    std::vector<array_item<int64_t>> Record::asArray<int64_t>(int field) const {
+      Oid type;
+      int32_t length;
+      return readArray<int64_t>(this->field(field, type, length), INT8OID, 0);
     }
 
     template<>
-    double Row::as<double>(int column) const {
-      return read<double>(result_, FLOAT8OID, column, 0.);
+    std::vector<array_item<float>> Record::asArray<float>(int field) const {
+      Oid type;
+      int32_t length;
+      return readArray<float>(this->field(field, type, length), FLOAT4OID, 0.f);
     }
 
     template<>
-    std::string Row::as<std::string>(int column) const {
-      assert(result_.pgresult_ != nullptr);
-      if (PQgetisnull(result_, 0, column)) {
-        return std::string();
-      }
-      int length = PQgetlength(result_, 0, column);
-      char *buf  = PQgetvalue(result_, 0, column);
-      return read<std::string>(&buf, length);
+    std::vector<array_item<double>> Record::asArray<double>(int field) const {
+      Oid type;
+      int32_t length;
+      return readArray<double>(this->field(field, type, length), FLOAT8OID, 0.);
     }
 
-    // -------------------------------------------------------------------------
-    // "char"
-    // -------------------------------------------------------------------------
     template<>
-    char Row::as<char>(int column) const {
-      assert(result_.pgresult_ != nullptr);
-      if (PQgetisnull(result_, 0, column)) {
-        return '\0';
+    std::vector<array_item<date_t>> Record::asArray<date_t>(int field) const {
+      Oid type;
+      int32_t length;
+      return readArray<date_t>(this->field(field, type, length), DATEOID, date_t { 0 });
+    }
+
+    template<>
+    std::vector<array_item<timestamptz_t>> Record::asArray<timestamptz_t>(int field) const {
+      Oid type;
+      int32_t length;
+      return readArray<timestamptz_t>(this->field(field, type, length), TIMESTAMPTZOID, timestamptz_t { 0 });
+    }
+
+    template<>
+    std::vector<array_item<timestamp_t>> Record::asArray<timestamp_t>(int field) const {
+      Oid type;
+      int32_t length;
+      return readArray<timestamp_t>(this->field(field, type, length), TIMESTAMPOID, timestamp_t { 0 });
+    }
+
+    template<>
+    std::vector<array_item<timetz_t>> Record::asArray<timetz_t>(int field) const {
+      Oid type;
+      int32_t length;
+      return readArray<timetz_t>(this->field(field, type, length), TIMETZOID, timetz_t { 0, 0 });
+    }
+
+    template<>
+    std::vector<array_item<time_t>> Record::asArray<time_t>(int field) const {
+      Oid type;
+      int32_t length;
+      return readArray<time_t>(this->field(field, type, length), TIMEOID, time_t { 0 });
+    }
+
+    template<>
+    std::vector<array_item<interval_t>> Record::asArray<interval_t>(int field) const {
+      Oid type;
+      int32_t length;
+      return readArray<interval_t>(this->field(field, type, length), INTERVALOID, interval_t { 0, 0, 0 });
+    }
+
+    template<>
+    std::vector<array_item<numeric_t>> Record::asArray<numeric_t>(int field) const {
+      Oid type;
+      int32_t length;
+      return readArray<numeric_t>(this->field(field, type, length), NUMERICOID, numeric_t());
+    }
+
+    template<>
+    std::vector<array_item<uuid_t>> Record::asArray<uuid_t>(int field) const {
+      Oid type;
+      int32_t length;
+      return readArray<uuid_t>(this->field(field, type, length), UUIDOID, uuid_t {{ 0 }});
+    }
+
+    template<>
+    std::vector<array_item<macaddr_t>> Record::asArray<macaddr_t>(int field) const {
+      Oid type;
+      int32_t length;
+      return readArray<macaddr_t>(this->field(field, type, length), MACADDROID, macaddr_t {{ 0 }});
+    }
+
+    template<>
+    std::vector<array_item<inet_t>> Record::asArray<inet_t>(int field) const {
+      Oid type;
+      int32_t length;
+      return readArray<inet_t>(this->field(field, type, length), UNKNOWNOID, inet_t { 0, 0, false, { 0 } });
+    }
+
+    template<>
+    std::vector<array_item<json_t>> Record::asArray<json_t>(int field) const {
+      Oid type;
+      int32_t length;
+      return readArray<json_t>(this->field(field, type, length), JSONOID, json_t { "", 0 });
+    }
+
+    template<>
+    std::vector<array_item<jsonb_t>> Record::asArray<jsonb_t>(int field) const {
+      Oid type;
+      int32_t length;
+      return readArray<jsonb_t>(this->field(field, type, length), JSONBOID, jsonb_t { "", 0 });
+    }
+
+    template<>
+    std::vector<array_item<std::string>> Record::asArray<std::string>(int field) const {
+      Oid type;
+      int32_t length;
+      return readArray<std::string>(this->field(field, type, length), UNKNOWNOID, std::string());
+    }
+
+    template<>
+    std::vector<array_item<Record>> Record::asArray<Record>(int field) const {
+      Oid type;
+      int32_t length;
+      return readArray<Record>(this->field(field, type, length), UNKNOWNOID, Record());
+    }
+
+    template<>
+    Record Row::as<Record>(int column) const {
+      assert(pgresult_ != nullptr);
+      assert(!isText(column)); // records are read in binary format.
+      if (PQgetisnull(pgresult_, row_, column)) {
+        return Record();
       }
-      assert(PQgetlength(result_, 0, column) == 1);
-      return *PQgetvalue(result_, 0, column);
+      return Record(PQgetvalue(pgresult_, row_, column), PQgetlength(pgresult_, row_, column));
+    }
+
+    template<>
+    std::vector<array_item<Record>> Row::asArray<Record>(int column) const {
+      assert(!isText(column)); // records are read in binary format.
+      return readArray<Record>(value(column), UNKNOWNOID, Record());
     }
 
     // -------------------------------------------------------------------------
-    // bytea
+    // Ranges
     // -------------------------------------------------------------------------
     template<>
-    std::vector<uint8_t> Row::as<std::vector<uint8_t>>(int column) const {
-      assert(result_.pgresult_ != nullptr);
-      assert_oid(PQftype(result_, column), BYTEAOID);
-      int length = PQgetlength(result_, 0, column);
-      uint8_t *data = reinterpret_cast<uint8_t *>(PQgetvalue(result_, 0, column));
-      return std::vector<uint8_t>(data, data + length);
+    range<int32_t> Row::as<range<int32_t>>(int column) const {
+      return read<range<int32_t>>(pgresult_, INT4RANGEOID, row_, column, range<int32_t>());
     }
 
     template<>
-    date_t Row::as<date_t>(int column) const {
-      return read<date_t>(result_, DATEOID, column, date_t { 0 });
+    range<int64_t> Row::as<range<int64_t>>(int column) const {
+      return read<range<int64_t>>(pgresult_, INT8RANGEOID, row_, column, range<int64_t>());
     }
 
     template<>
-    timestamptz_t Row::as<timestamptz_t>(int column) const {
-      return read<timestamptz_t>(result_, TIMESTAMPTZOID, column, timestamptz_t { 0 });
+    range<numeric_t> Row::as<range<numeric_t>>(int column) const {
+      return read<range<numeric_t>>(pgresult_, NUMRANGEOID, row_, column, range<numeric_t>());
     }
 
     template<>
-    timestamp_t Row::as<timestamp_t>(int column) const {
-      return read<timestamp_t>(result_, TIMESTAMPOID, column, timestamp_t { 0 });
+    range<date_t> Row::as<range<date_t>>(int column) const {
+      return read<range<date_t>>(pgresult_, DATERANGEOID, row_, column, range<date_t>());
     }
 
     template<>
-    timetz_t Row::as<timetz_t>(int column) const {
-      return read<timetz_t>(result_, TIMETZOID, column, timetz_t { 0, 0 });
+    range<timestamp_t> Row::as<range<timestamp_t>>(int column) const {
+      return read<range<timestamp_t>>(pgresult_, TSRANGEOID, row_, column, range<timestamp_t>());
     }
 
     template<>
-    time_t Row::as<time_t>(int column) const {
-      return read<time_t>(result_, TIMEOID, column, time_t { 0 });
+    range<timestamptz_t> Row::as<range<timestamptz_t>>(int column) const {
+      return read<range<timestamptz_t>>(pgresult_, TSTZRANGEOID, row_, column, range<timestamptz_t>());
     }
 
     template<>
-    interval_t Row::as<interval_t>(int column) const {
-      return read<interval_t>(result_, INTERVALOID, column, interval_t { 0, 0, 0 });
+    multirange<int32_t> Row::as<multirange<int32_t>>(int column) const {
+      return read<multirange<int32_t>>(pgresult_, INT4MULTIRANGEOID, row_, column, multirange<int32_t>());
     }
 
-    // -------------------------------------------------------------------------
-    // Arrays
-    // -------------------------------------------------------------------------
+    template<>
+    multirange<int64_t> Row::as<multirange<int64_t>>(int column) const {
+      return read<multirange<int64_t>>(pgresult_, INT8MULTIRANGEOID, row_, column, multirange<int64_t>());
+    }
 
     template<>
-    std::vector<array_item<bool>> Row::asArray(int column) const {
-      return readArray<bool>(result_, BOOLOID, column, 0);
+    multirange<numeric_t> Row::as<multirange<numeric_t>>(int column) const {
+      return read<multirange<numeric_t>>(pgresult_, NUMMULTIRANGEOID, row_, column, multirange<numeric_t>());
     }
 
     template<>
-    std::vector<array_item<int16_t>> Row::asArray<int16_t>(int column) const {
-      return readArray<int16_t>(result_, INT2OID, column, 0);
+    multirange<date_t> Row::as<multirange<date_t>>(int column) const {
+      return read<multirange<date_t>>(pgresult_, DATEMULTIRANGEOID, row_, column, multirange<date_t>());
     }
 
     template<>
-    std::vector<array_item<int32_t>> Row::asArray<int32_t>(int column) const {
-      return readArray<int32_t>(result_, INT4OID, column, 0);
+    multirange<timestamp_t> Row::as<multirange<timestamp_t>>(int column) const {
+      return read<multirange<timestamp_t>>(pgresult_, TSMULTIRANGEOID, row_, column, multirange<timestamp_t>());
     }
 
     template<>
-    std::vector<array_item<int64_t>> Row::asArray<int64_t>(int column) const {
-      return readArray<int64_t>(result_, INT8OID, column, 0);
+    multirange<timestamptz_t> Row::as<multirange<timestamptz_t>>(int column) const {
+      return read<multirange<timestamptz_t>>(pgresult_, TSTZMULTIRANGEOID, row_, column, multirange<timestamptz_t>());
     }
 
     template<>
-    std::vector<array_item<float>> Row::asArray<float>(int column) const {
-      return readArray<float>(result_, FLOAT4OID, column, 0.f);
+    std::vector<array_item<range<int32_t>>> Row::asArray<range<int32_t>>(int column) const {
+      return readArray<range<int32_t>>(pgresult_, INT4RANGEOID, row_, column, range<int32_t>());
     }
 
     template<>
-    std::vector<array_item<double>> Row::asArray<double>(int column) const {
-      return readArray<double>(result_, FLOAT8OID, column, 0.);
+    std::vector<array_item<range<int64_t>>> Row::asArray<range<int64_t>>(int column) const {
+      return readArray<range<int64_t>>(pgresult_, INT8RANGEOID, row_, column, range<int64_t>());
     }
 
     template<>
-    std::vector<array_item<date_t>> Row::asArray<date_t>(int column) const {
-      return readArray<date_t>(result_, DATEOID, column, date_t { 0 });
+    std::vector<array_item<range<numeric_t>>> Row::asArray<range<numeric_t>>(int column) const {
+      return readArray<range<numeric_t>>(pgresult_, NUMRANGEOID, row_, column, range<numeric_t>());
     }
 
     template<>
-    std::vector<array_item<timestamptz_t>> Row::asArray<timestamptz_t>(int column) const {
-      return readArray<timestamptz_t>(result_, TIMESTAMPTZOID, column, timestamptz_t { 0 });
+    std::vector<array_item<range<date_t>>> Row::asArray<range<date_t>>(int column) const {
+      return readArray<range<date_t>>(pgresult_, DATERANGEOID, row_, column, range<date_t>());
     }
 
     template<>
-    std::vector<array_item<timestamp_t>> Row::asArray<timestamp_t>(int column) const {
-      return readArray<timestamp_t>(result_, TIMESTAMPOID, column, timestamp_t { 0 });
+    std::vector<array_item<range<timestamp_t>>> Row::asArray<range<timestamp_t>>(int column) const {
+      return readArray<range<timestamp_t>>(pgresult_, TSRANGEOID, row_, column, range<timestamp_t>());
     }
 
     template<>
-    std::vector<array_item<timetz_t>> Row::asArray<timetz_t>(int column) const {
-      return readArray<timetz_t>(result_, TIMETZOID, column, timetz_t { 0, 0 });
+    std::vector<array_item<range<timestamptz_t>>> Row::asArray<range<timestamptz_t>>(int column) const {
+      return readArray<range<timestamptz_t>>(pgresult_, TSTZRANGEOID, row_, column, range<timestamptz_t>());
     }
 
     template<>
-    std::vector<array_item<time_t>> Row::asArray<time_t>(int column) const {
-      return readArray<time_t>(result_, TIMEOID, column, time_t { 0 });
+    range<int32_t> Record::as<range<int32_t>>(int field) const {
+      return value<range<int32_t>>(field, INT4RANGEOID, range<int32_t>());
     }
 
     template<>
-    std::vector<array_item<interval_t>> Row::asArray<interval_t>(int column) const {
-      return readArray<interval_t>(result_, INTERVALOID, column, interval_t { 0, 0, 0 });
+    range<int64_t> Record::as<range<int64_t>>(int field) const {
+      return value<range<int64_t>>(field, INT8RANGEOID, range<int64_t>());
     }
 
     template<>
-    std::vector<array_item<std::string>> Row::asArray<std::string>(int column) const {
-      return readArray<std::string>(result_, UNKNOWNOID, column, std::string());
+    range<numeric_t> Record::as<range<numeric_t>>(int field) const {
+      return value<range<numeric_t>>(field, NUMRANGEOID, range<numeric_t>());
+    }
+
+    template<>
+    range<date_t> Record::as<range<date_t>>(int field) const {
+      return value<range<date_t>>(field, DATERANGEOID, range<date_t>());
+    }
+
+    template<>
+    range<timestamp_t> Record::as<range<timestamp_t>>(int field) const {
+      return value<range<timestamp_t>>(field, TSRANGEOID, range<timestamp_t>());
+    }
+
+    template<>
+    range<timestamptz_t> Record::as<range<timestamptz_t>>(int field) const {
+      return value<range<timestamptz_t>>(field, TSTZRANGEOID, range<timestamptz_t>());
+    }
+
+    template<>
+    multirange<int32_t> Record::as<multirange<int32_t>>(int field) const {
+      return value<multirange<int32_t>>(field, INT4MULTIRANGEOID, multirange<int32_t>());
+    }
+
+    template<>
+    multirange<int64_t> Record::as<multirange<int64_t>>(int field) const {
+      return value<multirange<int64_t>>(field, INT8MULTIRANGEOID, multirange<int64_t>());
+    }
+
+    template<>
+    multirange<numeric_t> Record::as<multirange<numeric_t>>(int field) const {
+      return value<multirange<numeric_t>>(field, NUMMULTIRANGEOID, multirange<numeric_t>());
+    }
+
+    template<>
+    multirange<date_t> Record::as<multirange<date_t>>(int field) const {
+      return value<multirange<date_t>>(field, DATEMULTIRANGEOID, multirange<date_t>());
+    }
+
+    template<>
+    multirange<timestamp_t> Record::as<multirange<timestamp_t>>(int field) const {
+      return value<multirange<timestamp_t>>(field, TSMULTIRANGEOID, multirange<timestamp_t>());
+    }
+
+    template<>
+    multirange<timestamptz_t> Record::as<multirange<timestamptz_t>>(int field) const {
+      return value<multirange<timestamptz_t>>(field, TSTZMULTIRANGEOID, multirange<timestamptz_t>());
+    }
+
+    template<>
+    std::vector<array_item<range<int32_t>>> Record::asArray<range<int32_t>>(int field) const {
+      Oid type;
+      int32_t length;
+      return readArray<range<int32_t>>(this->field(field, type, length), INT4RANGEOID, range<int32_t>());
+    }
+
+    template<>
+    std::vector<array_item<range<int64_t>>> Record::asArray<range<int64_t>>(int field) const {
+      Oid type;
+      int32_t length;
+      return readArray<range<int64_t>>(this->field(field, type, length), INT8RANGEOID, range<int64_t>());
+    }
+
+    template<>
+    std::vector<array_item<range<numeric_t>>> Record::asArray<range<numeric_t>>(int field) const {
+      Oid type;
+      int32_t length;
+      return readArray<range<numeric_t>>(this->field(field, type, length), NUMRANGEOID, range<numeric_t>());
+    }
+
+    template<>
+    std::vector<array_item<range<date_t>>> Record::asArray<range<date_t>>(int field) const {
+      Oid type;
+      int32_t length;
+      return readArray<range<date_t>>(this->field(field, type, length), DATERANGEOID, range<date_t>());
+    }
+
+    template<>
+    std::vector<array_item<range<timestamp_t>>> Record::asArray<range<timestamp_t>>(int field) const {
+      Oid type;
+      int32_t length;
+      return readArray<range<timestamp_t>>(this->field(field, type, length), TSRANGEOID, range<timestamp_t>());
+    }
+
+    template<>
+    std::vector<array_item<range<timestamptz_t>>> Record::asArray<range<timestamptz_t>>(int field) const {
+      Oid type;
+      int32_t length;
+      return readArray<range<timestamptz_t>>(this->field(field, type, length), TSTZRANGEOID, range<timestamptz_t>());
     }
 
     // -------------------------------------------------------------------------
     // Result contructor
     // -------------------------------------------------------------------------
     Result::Result(Connection &conn)
-      : Row(*this), conn_(conn), begin_(*this), end_(*this) {
-      pgresult_ = nullptr;
+      : conn_(conn) {
       status_ = PGRES_EMPTY_QUERY;
     }
 
@@ -352,7 +1439,7 @@ namespace db {
     // First row of the result
     // -------------------------------------------------------------------------
     Result::iterator Result::begin() {
-      return Result::iterator(&begin_);
+      return Result::iterator(this, this);
     }
 
     // -------------------------------------------------------------------------
@@ -360,20 +1447,20 @@ namespace db {
     // -------------------------------------------------------------------------
     Result::iterator Result::end() {
       // If there is no result available then end() = begin()
-      return Result::iterator(status_ == PGRES_SINGLE_TUPLE ? &end_ : &begin_);
+      return Result::iterator(this, status_ == PGRES_SINGLE_TUPLE ? &end_ : this);
     }
 
     // -------------------------------------------------------------------------
     // Next row of the result
     // -------------------------------------------------------------------------
     Result::iterator Result::iterator::operator ++() {
-      ptr_->result_.next();
-      if (ptr_->result_.status_ != PGRES_SINGLE_TUPLE) {
+      result_->next();
+      if (result_->status_ != PGRES_SINGLE_TUPLE) {
         // We've reached the end
-        assert(ptr_->result_.status_ == PGRES_TUPLES_OK);
-        ptr_ = &ptr_->result_.end_;
+        assert(result_->status_ == PGRES_TUPLES_OK);
+        ptr_ = &result_->end_;
       }
-      return iterator (ptr_);
+      return iterator (result_, ptr_);
     }
 
     // -------------------------------------------------------------------------
@@ -386,6 +1473,22 @@ namespace db {
       return std::strtoull(count, &end, 10);
     }
 
+    // -------------------------------------------------------------------------
+    // Detach rows from the connection.
+    // -------------------------------------------------------------------------
+    ResultSet Result::detach(size_t rows) {
+      ResultSet set;
+      set.num_ = num_;
+      while (status_ == PGRES_SINGLE_TUPLE && set.size() < rows) {
+        // The ownership of the current row is moved to the set and the
+        // following one is fetched.
+        set.add(pgresult_);
+        pgresult_ = nullptr;
+        next();
+      }
+      return set;
+    }
+
     // -------------------------------------------------------------------------
     // Get the first result from the server.
     // -------------------------------------------------------------------------
@@ -488,8 +1591,13 @@ namespace db {
           next();
           if (status_ == PGRES_SINGLE_TUPLE) {
             // All results of the previous query have not been processed, we
-            // need to cancel it.
+            // need to cancel it and discard the rows already received.
             conn_.cancel();
+            do {
+              PQclear(pgresult_);
+              pgresult_ = PQgetResult(conn_);
+            } while (pgresult_ != nullptr);
+            status_ = PGRES_EMPTY_QUERY;
           }
           else if (status_ == PGRES_TUPLES_OK) {
             PQclear(pgresult_);
@@ -508,5 +1616,128 @@ namespace db {
 
     }
 
+    // -------------------------------------------------------------------------
+    // ResultSet constructor
+    // -------------------------------------------------------------------------
+    ResultSet::ResultSet() noexcept
+      : size_(0), num_(0) {
+    }
+
+    ResultSet::ResultSet(ResultSet &&other) noexcept
+      : chunks_(std::move(other.chunks_)), size_(other.size_), num_(other.num_) {
+      other.chunks_.clear();
+      other.size_ = 0;
+    }
+
+    ResultSet &ResultSet::operator = (ResultSet &&other) noexcept {
+      if (this != &other) {
+        for (PGresult *pgresult: chunks_) {
+          PQclear(pgresult);
+        }
+        chunks_ = std::move(other.chunks_);
+        size_ = other.size_;
+        num_ = other.num_;
+        other.chunks_.clear();
+        other.size_ = 0;
+      }
+      return *this;
+    }
+
+    // -------------------------------------------------------------------------
+    // Destructor
+    // -------------------------------------------------------------------------
+    ResultSet::~ResultSet() {
+      for (PGresult *pgresult: chunks_) {
+        PQclear(pgresult);
+      }
+    }
+
+    size_t ResultSet::size() const noexcept {
+      return size_;
+    }
+
+    bool ResultSet::empty() const noexcept {
+      return size_ == 0;
+    }
+
+    // -------------------------------------------------------------------------
+    // Take the ownership of a native result
+    // -------------------------------------------------------------------------
+    void ResultSet::add(PGresult *pgresult) {
+      assert(pgresult);
+      chunks_.push_back(pgresult);
+      size_ += PQntuples(pgresult);
+    }
+
+    ResultSet::iterator ResultSet::begin() const {
+      return ResultSet::iterator(this, 0);
+    }
+
+    ResultSet::iterator ResultSet::end() const {
+      return ResultSet::iterator(this, size_);
+    }
+
+    // -------------------------------------------------------------------------
+    // ResultSet iterator
+    // -------------------------------------------------------------------------
+    ResultSet::iterator::iterator(const ResultSet *set, size_t index)
+      : set_(set), index_(index), chunk_(0) {
+      if (index_ < set_->size_) {
+        seek();
+        return;
+      }
+
+      // End of the set: compared by index only, the chunks are not walked.
+      chunk_ = set_->chunks_.size();
+      row_.pgresult_ = nullptr;
+      row_.row_ = 0;
+      row_.num_ = set_->num_ + int(index_);
+    }
+
+    ResultSet::iterator::iterator(const iterator &other)
+      : set_(other.set_), index_(other.index_), chunk_(other.chunk_),
+        row_(other.row_.pgresult_, other.row_.row_, other.row_.num_) {
+    }
+
+    ResultSet::iterator &ResultSet::iterator::operator = (const iterator &other) {
+      set_ = other.set_;
+      index_ = other.index_;
+      chunk_ = other.chunk_;
+      row_.pgresult_ = other.row_.pgresult_;
+      row_.row_ = other.row_.row_;
+      row_.num_ = other.row_.num_;
+      return *this;
+    }
+
+    ResultSet::iterator ResultSet::iterator::operator ++() {
+      index_++;
+      row_.row_++;
+      row_.num_++;
+      if (row_.pgresult_ && row_.row_ >= PQntuples(row_.pgresult_)) {
+        // Move to the next native result.
+        chunk_++;
+        row_.row_ = 0;
+        row_.pgresult_ = chunk_ < set_->chunks_.size() ? set_->chunks_[chunk_] : nullptr;
+      }
+      return *this;
+    }
+
+    // -------------------------------------------------------------------------
+    // Position the iterator on the row at index_
+    // -------------------------------------------------------------------------
+    void ResultSet::iterator::seek() {
+      size_t first = 0;
+      for (chunk_ = 0; chunk_ < set_->chunks_.size(); chunk_++) {
+        size_t count = size_t(PQntuples(set_->chunks_[chunk_]));
+        if (index_ < first + count) {
+          break;
+        }
+        first += count;
+      }
+      row_.pgresult_ = chunk_ < set_->chunks_.size() ? set_->chunks_[chunk_] : nullptr;
+      row_.row_ = int(index_ - first);
+      row_.num_ = set_->num_ + int(index_);
+    }
+
   } // namespace postgres
 }   // namespace db
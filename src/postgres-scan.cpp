@@ -0,0 +1,215 @@
+/**
+ * Copyright (c) 2016 Philippe FERDINAND
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ **/
+#include "postgres-scan.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+namespace db {
+  namespace postgres {
+
+    // -------------------------------------------------------------------------
+    // Constructor
+    // -------------------------------------------------------------------------
+    ParallelScan::ParallelScan(std::vector<Connection *> connections)
+      : connections_(connections), ranges_(4 * connections.size()) {
+      assert(!connections_.empty());
+    }
+
+    ParallelScan &ParallelScan::ranges(size_t count) {
+      ranges_ = count > 0 ? count : 1;
+      return *this;
+    }
+
+    // -------------------------------------------------------------------------
+    // Export the snapshot of the scan
+    // -------------------------------------------------------------------------
+    std::string ParallelScan::begin() {
+      Connection &cnx = *connections_[0];
+      cnx.execute("BEGIN ISOLATION LEVEL REPEATABLE READ, READ ONLY");
+      try {
+        return cnx.execute("SELECT pg_export_snapshot()").as<std::string>(0);
+      }
+      catch (...) {
+        cnx.execute("ROLLBACK");
+        throw;
+      }
+    }
+
+    // -------------------------------------------------------------------------
+    // Scan by ranges of blocks
+    // -------------------------------------------------------------------------
+    void ParallelScan::byBlocks(const char *table, const char *columns, consumer_t consumer) {
+      std::string snapshot = begin();
+
+      int64_t blocks;
+      try {
+        blocks = connections_[0]->execute(
+          "SELECT pg_relation_size($1::regclass) / current_setting('block_size')::int8", table
+        ).as<int64_t>(0);
+      }
+      catch (...) {
+        connections_[0]->execute("ROLLBACK");
+        throw;
+      }
+
+      // Rows visible in the snapshot are in the blocks existing when it was
+      // taken, the last range has no upper bound anyway.
+      std::vector<std::pair<std::string, std::string>> ranges;
+      size_t count = std::max<size_t>(1, std::min<size_t>(ranges_, size_t(blocks)));
+      for (size_t i = 0; i < count; i++) {
+        int64_t first = blocks * int64_t(i) / int64_t(count);
+        int64_t last = blocks * int64_t(i + 1) / int64_t(count);
+        ranges.emplace_back("(" + std::to_string(first) + ",0)",
+                            i + 1 < count ? "(" + std::to_string(last) + ",0)" : "(4294967295,0)");
+      }
+
+      std::string sql = std::string("SELECT ") + columns + " FROM " + table
+                      + " WHERE ctid >= $1::tid AND ctid < $2::tid";
+      scan(snapshot, sql, ranges, consumer);
+    }
+
+    // -------------------------------------------------------------------------
+    // Scan by ranges of a key
+    // -------------------------------------------------------------------------
+    void ParallelScan::byKey(const char *table, const char *key, const char *columns, consumer_t consumer) {
+      std::string snapshot = begin();
+
+      std::vector<std::pair<int64_t, int64_t>> ranges;
+      try {
+        auto &result = connections_[0]->execute(
+          (std::string("SELECT min(") + key + ")::int8, max(" + key + ")::int8 FROM " + table).c_str()
+        );
+        if (!result.isNull(0)) {
+          int64_t min = result.as<int64_t>(0);
+          int64_t max = result.as<int64_t>(1);
+
+          // Bounds computed as unsigned to not overflow.
+          uint64_t span = uint64_t(max) - uint64_t(min);
+          uint64_t step = span / ranges_ + 1;
+          for (uint64_t first = 0; ; first += step) {
+            uint64_t last = span - first < step ? span : first + step - 1;
+            ranges.emplace_back(int64_t(uint64_t(min) + first), int64_t(uint64_t(min) + last));
+            if (last == span) {
+              break;
+            }
+          }
+        }
+      }
+      catch (...) {
+        connections_[0]->execute("ROLLBACK");
+        throw;
+      }
+
+      std::string sql = std::string("SELECT ") + columns + " FROM " + table
+                      + " WHERE " + key + " BETWEEN $1 AND $2";
+      scan(snapshot, sql, ranges, consumer);
+    }
+
+    // -------------------------------------------------------------------------
+    // Scan the ranges
+    // -------------------------------------------------------------------------
+    template<typename T>
+    void ParallelScan::scan(const std::string &snapshot, const std::string &sql,
+                            const std::vector<std::pair<T, T>> &ranges, const consumer_t &consumer) {
+      std::atomic<size_t> next(0);
+      std::atomic<bool> failed(false);
+      std::exception_ptr error;
+
+      // The transaction exporting the snapshot must remain open until the
+      // snapshot is imported by all the other connections.
+      std::mutex mutex;
+      std::condition_variable imported;
+      size_t importing = connections_.size() - 1;
+
+      auto worker = [&](size_t index) {
+        Connection &cnx = *connections_[index];
+        bool waiting = index > 0;
+        try {
+          if (index > 0) {
+            cnx.execute("BEGIN ISOLATION LEVEL REPEATABLE READ, READ ONLY");
+            cnx.execute(("SET TRANSACTION SNAPSHOT '" + snapshot + "'").c_str());
+            waiting = false;
+            std::lock_guard<std::mutex> lock(mutex);
+            if (--importing == 0) {
+              imported.notify_one();
+            }
+          }
+
+          size_t range;
+          while (!failed && (range = next++) < ranges.size()) {
+            for (auto &row: cnx.execute(sql.c_str(), ranges[range].first, ranges[range].second)) {
+              if (failed) {
+                break;
+              }
+              consumer(row);
+            }
+          }
+        }
+        catch (...) {
+          failed = true;
+          std::lock_guard<std::mutex> lock(mutex);
+          if (!error) {
+            error = std::current_exception();
+          }
+          if (waiting && --importing == 0) {
+            imported.notify_one();
+          }
+        }
+
+        if (index == 0) {
+          std::unique_lock<std::mutex> lock(mutex);
+          imported.wait(lock, [&importing] { return importing == 0; });
+        }
+        try {
+          // The rows left after a failure are discarded.
+          cnx.execute(failed ? "ROLLBACK" : "COMMIT");
+        }
+        catch (...) {
+          failed = true;
+          std::lock_guard<std::mutex> lock(mutex);
+          if (!error) {
+            error = std::current_exception();
+          }
+        }
+      };
+
+      std::vector<std::thread> threads;
+      for (size_t i = 1; i < connections_.size(); i++) {
+        threads.emplace_back(worker, i);
+      }
+      worker(0);
+      for (auto &thread: threads) {
+        thread.join();
+      }
+
+      if (error) {
+        std::rethrow_exception(error);
+      }
+    }
+
+  } // namespace postgres
+}   // namespace db
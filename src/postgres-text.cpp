@@ -0,0 +1,1164 @@
+/**
+ * Copyright (c) 2016 Philippe FERDINAND
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ **/
+
+#include "postgres-types.h"
+#include "postgres-exceptions.h"
+
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+
+namespace db {
+  namespace postgres {
+
+    namespace {
+
+      // -----------------------------------------------------------------------
+      // Scanning helpers. `p` is moved forward on what has been consumed.
+      // -----------------------------------------------------------------------
+      /**
+       * A text the parser does not understand (e.g. an unsupported
+       * IntervalStyle or DateStyle).
+       **/
+      [[noreturn]] void invalid(const char *what) {
+        throw ExecutionException(std::string("invalid text value: ") + what);
+      }
+
+      inline bool isDigit(char c) {
+        return c >= '0' && c <= '9';
+      }
+
+      inline bool match(const char *&p, const char *end, char c) {
+        if (p < end && *p == c) {
+          p++;
+          return true;
+        }
+        return false;
+      }
+
+      inline bool match(const char *&p, const char *end, const char *word) {
+        size_t length = std::strlen(word);
+        if (size_t(end - p) >= length && std::strncmp(p, word, length) == 0) {
+          p += length;
+          return true;
+        }
+        return false;
+      }
+
+      inline uint64_t digits(const char *&p, const char *end) {
+        const char *start = p;
+        uint64_t value = 0;
+        for (; p < end && isDigit(*p); p++) {
+          value = value * 10 + uint64_t(*p - '0');
+        }
+        if (p == start) {
+          invalid("a number is expected");
+        }
+        return value;
+      }
+
+      inline int sign(const char *&p, const char *end) {
+        if (match(p, end, '-')) {
+          return -1;
+        }
+        match(p, end, '+');
+        return 1;
+      }
+
+      inline int hex(char c) {
+        if (isDigit(c)) {
+          return c - '0';
+        }
+        c = char(c | 0x20); // lower case
+        if (c < 'a' || c > 'f') {
+          invalid("an hexadecimal digit is expected");
+        }
+        return c - 'a' + 10;
+      }
+
+      // -----------------------------------------------------------------------
+      // Fractional part of the seconds (`.ffffff`) in microseconds.
+      // -----------------------------------------------------------------------
+      int64_t fraction(const char *&p, const char *end) {
+        int64_t value = 0;
+        if (match(p, end, '.')) {
+          int scale = 100000;
+          for (; p < end && isDigit(*p); p++, scale /= 10) {
+            value += (*p - '0') * scale;
+          }
+        }
+        return value;
+      }
+
+      // -----------------------------------------------------------------------
+      // Number of days since 1970-01-01 of a date in the proleptic Gregorian
+      // calendar (http://howardhinnant.github.io/date_algorithms.html).
+      // -----------------------------------------------------------------------
+      int64_t daysFromCivil(int64_t y, int64_t m, int64_t d) {
+        y -= m <= 2;
+        int64_t era = (y >= 0 ? y : y - 399) / 400;
+        int64_t yoe = y - era * 400;
+        int64_t doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+        int64_t doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+        return era * 146097 + doe - 719468;
+      }
+
+      // -----------------------------------------------------------------------
+      // `YYYY-MM-DD` in days since Unix epoch. `bc` is true for a date
+      // followed by ` BC` (year 1 BC is the year 0). ISO 8601 years can be
+      // signed (`-0044-03-15`, `+10000-01-01`).
+      // -----------------------------------------------------------------------
+      int64_t date(const char *&p, const char *end, bool bc) {
+        int64_t year = sign(p, end) * int64_t(digits(p, end));
+        match(p, end, '-');
+        int64_t month = int64_t(digits(p, end));
+        match(p, end, '-');
+        int64_t day = int64_t(digits(p, end));
+        return daysFromCivil(bc ? 1 - year : year, month, day);
+      }
+
+      // -----------------------------------------------------------------------
+      // `HH:MM:SS[.ffffff]` in microseconds. The hours are not limited to 24
+      // for intervals.
+      // -----------------------------------------------------------------------
+      int64_t time(const char *&p, const char *end) {
+        int64_t hours = int64_t(digits(p, end));
+        match(p, end, ':');
+        int64_t minutes = int64_t(digits(p, end));
+        int64_t seconds = 0;
+        if (match(p, end, ':')) {
+          seconds = int64_t(digits(p, end));
+        }
+        return ((hours * 60 + minutes) * 60 + seconds) * 1000000 + fraction(p, end);
+      }
+
+      // -----------------------------------------------------------------------
+      // Two digits of an offset, 0 if there are none.
+      // -----------------------------------------------------------------------
+      inline int32_t twoDigits(const char *&p, const char *end) {
+        if (end - p < 2 || !isDigit(p[0]) || !isDigit(p[1])) {
+          return 0;
+        }
+        p += 2;
+        return (p[-2] - '0') * 10 + (p[-1] - '0');
+      }
+
+      // -----------------------------------------------------------------------
+      // Time zone offset in seconds east of UTC: `Z`, `+HH[:MM[:SS]]` or
+      // `+HH[MM]`.
+      // -----------------------------------------------------------------------
+      int32_t offset(const char *&p, const char *end) {
+        if (match(p, end, 'Z') || p == end || (*p != '+' && *p != '-')) {
+          return 0;
+        }
+        int s = sign(p, end);
+        int32_t seconds = twoDigits(p, end) * 3600;
+        match(p, end, ':');
+        seconds += twoDigits(p, end) * 60;
+        match(p, end, ':');
+        seconds += twoDigits(p, end);
+        return s * seconds;
+      }
+
+      // -----------------------------------------------------------------------
+      // Removes the ` BC` suffix of dates and timestamps.
+      // -----------------------------------------------------------------------
+      bool bc(const char *text, const char *&end) {
+        if (end - text > 3 && std::strncmp(end - 3, " BC", 3) == 0) {
+          end -= 3;
+          return true;
+        }
+        return false;
+      }
+
+      // -----------------------------------------------------------------------
+      // `infinity` and `-infinity` of dates and timestamps.
+      // -----------------------------------------------------------------------
+      template <typename T>
+      bool infinity(const char *text, size_t length, T &value) {
+        if (length == 8 && std::strncmp(text, "infinity", 8) == 0) {
+          value = std::numeric_limits<T>::max();
+          return true;
+        }
+        if (length == 9 && std::strncmp(text, "-infinity", 9) == 0) {
+          value = std::numeric_limits<T>::min();
+          return true;
+        }
+        return false;
+      }
+
+      template <typename T>
+      T integer(const char *text, size_t length) {
+        const char *p = text, *end = text + length;
+        bool negative = match(p, end, '-');
+        uint64_t value = digits(p, end);
+        if (p != end) {
+          invalid("an integer is expected");
+        }
+        return T(negative ? 0 - value : value);
+      }
+
+      // -----------------------------------------------------------------------
+      // Floating point values.
+      //
+      // A decimal value with a mantissa and a power of ten both exactly
+      // representable is correctly rounded by a single multiplication or
+      // division (Clinger's fast path), which covers the shortest
+      // representations printed by the server for most values. Others
+      // values, `NaN` and `Infinity` fall back to strtod().
+      // -----------------------------------------------------------------------
+      const double POW10[] = {
+        1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+        1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+      };
+
+      inline double strto(const char *text, double *) {
+        return std::strtod(text, nullptr);
+      }
+
+      inline float strto(const char *text, float *) {
+        return std::strtof(text, nullptr);
+      }
+
+      template <typename T>
+      T floating(const char *text, size_t length, int maxDigits, int maxExponent) {
+        const char *p = text, *end = text + length;
+        bool negative = match(p, end, '-');
+        uint64_t mantissa = 0;
+        int significant = 0;
+        int exponent = 0;
+        bool dot = false;
+        for (; p < end; p++) {
+          if (isDigit(*p)) {
+            if (mantissa != 0 || *p != '0') {
+              significant++;
+            }
+            mantissa = mantissa * 10 + uint64_t(*p - '0');
+            exponent -= dot;
+          }
+          else if (*p == '.' && !dot) {
+            dot = true;
+          }
+          else {
+            break;
+          }
+        }
+
+        if (p < end && (*p == 'e' || *p == 'E')) {
+          p++;
+          int s = sign(p, end);
+          int e = 0;
+          for (; p < end && isDigit(*p) && e < 10000; p++) {
+            e = e * 10 + (*p - '0');
+          }
+          exponent += s * e;
+        }
+
+        if (p == end && significant <= maxDigits && exponent >= -maxExponent && exponent <= maxExponent) {
+          T value = T(mantissa);
+          value = exponent < 0 ? value / T(POW10[-exponent]) : value * T(POW10[exponent]);
+          return negative ? -value : value;
+        }
+
+        char buf[64];
+        if (length < sizeof(buf)) {
+          std::memcpy(buf, text, length);
+          buf[length] = '\0';
+          return strto(buf, static_cast<T *>(nullptr));
+        }
+        return strto(std::string(text, length).c_str(), static_cast<T *>(nullptr));
+      }
+
+      // -----------------------------------------------------------------------
+      // Token of a range or an array, either quoted or ending with one of the
+      // `delimiters`. Quoted tokens with escaped characters are unescaped
+      // into `scratch`.
+      // -----------------------------------------------------------------------
+      const char *token(const char *&p, const char *end, const char *delimiters,
+                        std::string &scratch, size_t &length, bool &quoted) {
+        quoted = p < end && *p == '"';
+        if (!quoted) {
+          const char *start = p;
+          while (p < end && std::strchr(delimiters, *p) == nullptr) {
+            p++;
+          }
+          length = size_t(p - start);
+          return start;
+        }
+
+        const char *start = ++p;
+        while (p < end && *p != '"' && *p != '\\') {
+          p++;
+        }
+        if (p < end && *p == '"' && (p + 1 == end || p[1] != '"')) {
+          // No escaped characters
+          length = size_t(p++ - start);
+          return start;
+        }
+
+        scratch.assign(start, p);
+        while (p < end) {
+          if (*p == '\\' && p + 1 < end) {
+            scratch += p[1];
+            p += 2;
+          }
+          else if (*p == '"' && p + 1 < end && p[1] == '"') {
+            scratch += '"';
+            p += 2;
+          }
+          else if (*p == '"') {
+            p++;
+            break;
+          }
+          else {
+            scratch += *p++;
+          }
+        }
+        length = scratch.size();
+        return scratch.data();
+      }
+
+      // -----------------------------------------------------------------------
+      // Range: `empty`, `[lower,upper)`, `(,upper]`...
+      // -----------------------------------------------------------------------
+      template <typename T>
+      range<T> parseRange(const char *&p, const char *end, std::string &scratch) {
+        range<T> r;
+        if (match(p, end, "empty")) {
+          return r;
+        }
+
+        size_t length;
+        bool quoted;
+        r.flags = match(p, end, '[') ? range<T>::LB_INC : 0;
+        match(p, end, '(');
+        if (p < end && *p == ',') {
+          r.flags |= range<T>::LB_INF;
+        }
+        else {
+          const char *lower = token(p, end, ",", scratch, length, quoted);
+          r.lower = parse<T>(lower, length);
+        }
+        match(p, end, ',');
+        if (p < end && (*p == ')' || *p == ']')) {
+          r.flags |= range<T>::UB_INF;
+        }
+        else {
+          const char *upper = token(p, end, ")]", scratch, length, quoted);
+          r.upper = parse<T>(upper, length);
+        }
+        if (match(p, end, ']')) {
+          r.flags |= range<T>::UB_INC;
+        }
+        match(p, end, ')');
+        return r;
+      }
+
+      template <typename T>
+      range<T> parseRange(const char *text, size_t length) {
+        const char *p = text;
+        std::string scratch;
+        return parseRange<T>(p, text + length, scratch);
+      }
+
+      // -----------------------------------------------------------------------
+      // Multirange: `{[1,3),[5,7)}`
+      // -----------------------------------------------------------------------
+      template <typename T>
+      multirange<T> parseMultirange(const char *text, size_t length) {
+        const char *p = text, *end = text + length;
+        multirange<T> ranges;
+        std::string scratch;
+        match(p, end, '{');
+        while (p < end && *p != '}') {
+          ranges.push_back(parseRange<T>(p, end, scratch));
+          match(p, end, ',');
+        }
+        return ranges;
+      }
+
+      // -----------------------------------------------------------------------
+      // IPv4 (`192.168.0.1`) and IPv6 (`2001:db8::ff00:42:8329`) addresses.
+      // -----------------------------------------------------------------------
+      bool ipv4(const char *&p, const char *end, uint8_t *bytes) {
+        for (int i = 0; i < 4; i++) {
+          if (i > 0 && !match(p, end, '.')) {
+            return false;
+          }
+          bytes[i] = uint8_t(digits(p, end));
+        }
+        return true;
+      }
+
+      bool ipv6(const char *&p, const char *end, uint8_t *bytes) {
+        uint16_t groups[8] = { 0 };
+        int count = 0;
+        int gap = -1; // position of `::`
+        if (match(p, end, "::")) {
+          gap = 0;
+        }
+        while (p < end && *p != '/' && count < 8) {
+          // Embedded IPv4 address in the last 32 bits
+          const char *q = p;
+          while (q < end && std::isxdigit(uint8_t(*q))) {
+            q++;
+          }
+          if (q < end && *q == '.' && count <= 6) {
+            uint8_t v4[4];
+            if (!ipv4(p, end, v4)) {
+              return false;
+            }
+            groups[count++] = uint16_t(v4[0] << 8 | v4[1]);
+            groups[count++] = uint16_t(v4[2] << 8 | v4[3]);
+            break;
+          }
+
+          if (q == p) {
+            return false;
+          }
+          uint16_t group = 0;
+          for (; p < q; p++) {
+            group = uint16_t(group << 4 | hex(*p));
+          }
+          groups[count++] = group;
+          if (match(p, end, "::")) {
+            gap = count;
+          }
+          else {
+            match(p, end, ':');
+          }
+        }
+
+        int zeros = gap == -1 ? 0 : 8 - count;
+        for (int i = 0, j = 0; i < 8; i++) {
+          uint16_t group = (i >= gap && i < gap + zeros) ? 0 : groups[j++];
+          bytes[2 * i] = uint8_t(group >> 8);
+          bytes[2 * i + 1] = uint8_t(group);
+        }
+        return gap != -1 || count == 8;
+      }
+
+    } // namespace
+
+    // -------------------------------------------------------------------------
+    // Arrays: `{1,2,NULL}`, `{{"a b",c},{d,e}}`, `[0:1]={1,2}`...
+    // -------------------------------------------------------------------------
+    void parseElements(const char *text, size_t length,
+                       const std::function<void(const char *text, int32_t length)> &element) {
+      const char *p = text, *end = text + length;
+      if (p < end && *p == '[') {
+        // Skip the dimensions decoration of arrays not starting at index 1.
+        while (p < end && *p != '=') {
+          p++;
+        }
+        match(p, end, '=');
+      }
+
+      std::string scratch;
+      while (p < end) {
+        if (*p == '{' || *p == '}' || *p == ',' || *p == ' ') {
+          p++;
+          continue;
+        }
+
+        size_t size;
+        bool quoted;
+        const char *value = token(p, end, ",}", scratch, size, quoted);
+        if (!quoted && size == 4 && std::strncmp(value, "NULL", 4) == 0) {
+          element(nullptr, -1);
+        }
+        else {
+          element(value, int32_t(size));
+        }
+      }
+    }
+
+    // -------------------------------------------------------------------------
+    // Scalar types
+    // -------------------------------------------------------------------------
+
+    template <>
+    bool parse<bool>(const char *text, size_t length) {
+      return length > 0 && text[0] == 't';
+    }
+
+    template <>
+    char parse<char>(const char *text, size_t length) {
+      if (length == 4 && text[0] == '\\') {
+        // Non-printable characters are written in octal (`\ooo`).
+        return char((text[1] - '0') << 6 | (text[2] - '0') << 3 | (text[3] - '0'));
+      }
+      return length > 0 ? text[0] : '\0';
+    }
+
+    template <>
+    int16_t parse<int16_t>(const char *text, size_t length) {
+      return integer<int16_t>(text, length);
+    }
+
+    template <>
+    int32_t parse<int32_t>(const char *text, size_t length) {
+      return integer<int32_t>(text, length);
+    }
+
+    template <>
+    int64_t parse<int64_t>(const char *text, size_t length) {
+      return integer<int64_t>(text, length);
+    }
+
+    template <>
+    float parse<float>(const char *text, size_t length) {
+      return floating<float>(text, length, 7, 10);
+    }
+
+    template <>
+    double parse<double>(const char *text, size_t length) {
+      return floating<double>(text, length, 15, 22);
+    }
+
+    template <>
+    std::string parse<std::string>(const char *text, size_t length) {
+      return std::string(text, length);
+    }
+
+    // -------------------------------------------------------------------------
+    // bytea: `\x0a0b` (hex) or `a\\b\012` (escape)
+    // -------------------------------------------------------------------------
+    template <>
+    std::vector<uint8_t> parse<std::vector<uint8_t>>(const char *text, size_t length) {
+      const char *p = text, *end = text + length;
+      std::vector<uint8_t> bytes;
+      if (match(p, end, "\\x")) {
+        bytes.reserve(size_t(end - p) / 2);
+        for (; p + 1 < end; p += 2) {
+          bytes.push_back(uint8_t(hex(p[0]) << 4 | hex(p[1])));
+        }
+        return bytes;
+      }
+
+      bytes.reserve(length);
+      while (p < end) {
+        if (*p == '\\' && p + 1 < end && p[1] == '\\') {
+          bytes.push_back('\\');
+          p += 2;
+        }
+        else if (*p == '\\' && end - p >= 4) {
+          bytes.push_back(uint8_t((p[1] - '0') << 6 | (p[2] - '0') << 3 | (p[3] - '0')));
+          p += 4;
+        }
+        else {
+          bytes.push_back(uint8_t(*p++));
+        }
+      }
+      return bytes;
+    }
+
+    // -------------------------------------------------------------------------
+    // Date and time types
+    // -------------------------------------------------------------------------
+
+    template <>
+    date_t parse<date_t>(const char *text, size_t length) {
+      date_t v;
+      if (infinity(text, length, v.epoch_date)) {
+        return v;
+      }
+      const char *p = text, *end = text + length;
+      bool negative = bc(text, end);
+      v.epoch_date = int32_t(date(p, end, negative) * 86400);
+      return v;
+    }
+
+    template <>
+    timestamp_t parse<timestamp_t>(const char *text, size_t length) {
+      timestamp_t v;
+      if (infinity(text, length, v.epoch_time)) {
+        return v;
+      }
+      const char *p = text, *end = text + length;
+      bool negative = bc(text, end);
+      int64_t days = date(p, end, negative);
+      if (!match(p, end, ' ')) {
+        match(p, end, 'T');
+      }
+      v.epoch_time = days * MICROSEC_PER_DAY + time(p, end);
+      return v;
+    }
+
+    template <>
+    timestamptz_t parse<timestamptz_t>(const char *text, size_t length) {
+      timestamptz_t v;
+      if (infinity(text, length, v.epoch_time)) {
+        return v;
+      }
+      const char *p = text, *end = text + length;
+      bool negative = bc(text, end);
+      int64_t days = date(p, end, negative);
+      if (!match(p, end, ' ')) {
+        match(p, end, 'T');
+      }
+      int64_t local = days * MICROSEC_PER_DAY + time(p, end);
+      v.epoch_time = local - int64_t(offset(p, end)) * 1000000;
+      return v;
+    }
+
+    template <>
+    time_t parse<time_t>(const char *text, size_t length) {
+      const char *p = text;
+      return time_t { time(p, text + length) };
+    }
+
+    template <>
+    timetz_t parse<timetz_t>(const char *text, size_t length) {
+      const char *p = text, *end = text + length;
+      timetz_t v;
+      v.time = time(p, end);
+      v.offset = -offset(p, end); // seconds west of UTC, as the binary format
+      return v;
+    }
+
+    // -------------------------------------------------------------------------
+    // interval: `1 year 2 mons -3 days +04:05:06.789` or ISO 8601 duration
+    // `P1Y2M-3DT4H5M6.789S`
+    // -------------------------------------------------------------------------
+    template <>
+    interval_t parse<interval_t>(const char *text, size_t length) {
+      const char *p = text, *end = text + length;
+      interval_t v = { 0, 0, 0 };
+      if (match(p, end, 'P')) {
+        bool afterT = false;
+        while (p < end) {
+          if (match(p, end, 'T')) {
+            afterT = true;
+            continue;
+          }
+          int s = sign(p, end);
+          int64_t value = int64_t(digits(p, end));
+          int64_t microseconds = fraction(p, end);
+          char unit = p < end ? *p++ : 'S';
+          switch (unit) {
+            case 'Y': v.months += int32_t(s * value * 12); break;
+            case 'M':
+              if (afterT) {
+                v.time += s * value * 60000000;
+              }
+              else {
+                v.months += int32_t(s * value);
+              }
+              break;
+            case 'W': v.days += int32_t(s * value * 7); break;
+            case 'D': v.days += int32_t(s * value); break;
+            case 'H': v.time += s * value * 3600000000; break;
+            case 'S': v.time += s * (value * 1000000 + microseconds); break;
+            default:
+              invalid("not an ISO 8601 duration");
+          }
+        }
+        return v;
+      }
+
+      while (p < end) {
+        if (match(p, end, ' ')) {
+          continue;
+        }
+
+        const char *next = p;
+        while (next < end && *next != ' ' && *next != ':') {
+          next++;
+        }
+
+        int s = sign(p, end);
+        if (next < end && *next == ':') {
+          v.time += s * time(p, end);
+          continue;
+        }
+
+        int32_t value = s * int32_t(digits(p, end));
+        match(p, end, ' ');
+        if (match(p, end, "year")) {
+          v.months += value * 12;
+        }
+        else if (match(p, end, "mon")) {
+          v.months += value;
+        }
+        else if (match(p, end, "day")) {
+          v.days += value;
+        }
+        else {
+          invalid("unsupported IntervalStyle");
+        }
+        while (p < end && *p != ' ') {
+          p++; // plural
+        }
+      }
+      return v;
+    }
+
+    // -------------------------------------------------------------------------
+    // numeric
+    //
+    // The decimal digits are grouped into base 10000 digits aligned on the
+    // decimal point, and the binary form is then read as any binary value so
+    // the choice between the fixed-point and arbitrary-precision forms is the
+    // same.
+    // -------------------------------------------------------------------------
+    template <>
+    numeric_t parse<numeric_t>(const char *text, size_t length) {
+      const char *p = text, *end = text + length;
+      numeric_t n;
+      if (match(p, end, "NaN")) {
+        n.sign = numeric_t::NaN;
+        return n;
+      }
+      bool negative = match(p, end, '-');
+      if (match(p, end, "Infinity")) {
+        n.sign = negative ? numeric_t::NINF : numeric_t::PINF;
+        return n;
+      }
+
+      const char *integer = p;
+      while (p < end && isDigit(*p)) {
+        p++;
+      }
+      const char *integerEnd = p;
+      match(p, end, '.');
+      const char *decimals = p;
+      int dscale = int(end - decimals);
+
+      // Number of base 10000 digits of the integer part, and leading zeros of
+      // the first one.
+      int integerDigits = int(integerEnd - integer);
+      int weight = (integerDigits + 3) / 4 - 1;
+      int position = (4 - integerDigits % 4) % 4;
+      std::vector<int16_t> groups;
+      groups.reserve(size_t(weight + 1 + (dscale + 3) / 4));
+      int16_t group = 0;
+      for (const char *c = integer; c < end; c++) {
+        if (c == integerEnd) {
+          continue; // decimal point
+        }
+        group = int16_t(group * 10 + (*c - '0'));
+        if (++position == 4) {
+          groups.push_back(group);
+          group = 0;
+          position = 0;
+        }
+      }
+      if (position > 0) {
+        for (; position < 4; position++) {
+          group = int16_t(group * 10);
+        }
+        groups.push_back(group);
+      }
+
+      // Leading and trailing zeros are not part of the binary form.
+      size_t first = 0, last = groups.size();
+      while (first < last && groups[first] == 0) {
+        first++;
+        weight--;
+      }
+      while (last > first && groups[last - 1] == 0) {
+        last--;
+      }
+      if (first == last) {
+        weight = 0;
+      }
+
+      std::vector<char> binary((4 + last - first) * sizeof(int16_t));
+      char *buf = binary.data();
+      buf = write(int16_t(last - first), buf);
+      buf = write(int16_t(weight), buf);
+      buf = write(int16_t(negative ? numeric_t::NEG : numeric_t::POS), buf);
+      buf = write(int16_t(dscale), buf);
+      for (size_t i = first; i < last; i++) {
+        buf = write(groups[i], buf);
+      }
+
+      buf = binary.data();
+      return read<numeric_t>(&buf, binary.size());
+    }
+
+    // -------------------------------------------------------------------------
+    // uuid: `a0eebc99-9c0b-4ef8-bb6d-6bb9bd380a11`
+    // -------------------------------------------------------------------------
+    template <>
+    uuid_t parse<uuid_t>(const char *text, size_t length) {
+      const char *p = text, *end = text + length;
+      uuid_t v;
+      for (int i = 0; i < 16 && p + 1 < end; i++) {
+        match(p, end, '-');
+        v.bytes[i] = uint8_t(hex(p[0]) << 4 | hex(p[1]));
+        p += 2;
+      }
+      return v;
+    }
+
+    // -------------------------------------------------------------------------
+    // macaddr: `08:00:2b:01:02:03`
+    // -------------------------------------------------------------------------
+    template <>
+    macaddr_t parse<macaddr_t>(const char *text, size_t length) {
+      const char *p = text, *end = text + length;
+      macaddr_t v;
+      for (int i = 0; i < 6 && p + 1 < end; i++) {
+        match(p, end, ':');
+        v.bytes[i] = uint8_t(hex(p[0]) << 4 | hex(p[1]));
+        p += 2;
+      }
+      return v;
+    }
+
+    // -------------------------------------------------------------------------
+    // inet, cidr: `192.168.0.1/24`, `::1`. The text format does not tell a
+    // cidr from an inet, `cidr` is always false.
+    // -------------------------------------------------------------------------
+    template <>
+    inet_t parse<inet_t>(const char *text, size_t length) {
+      const char *p = text, *end = text + length;
+      inet_t v;
+      std::memset(v.bytes, 0, sizeof(v.bytes));
+      v.cidr = false;
+      v.family = std::memchr(text, ':', length) == nullptr ? inet_t::INET : inet_t::INET6;
+      bool valid = v.family == inet_t::INET ? ipv4(p, end, v.bytes) : ipv6(p, end, v.bytes);
+      if (!valid) {
+        invalid("not an IP address");
+      }
+      v.bits = match(p, end, '/') ? uint8_t(digits(p, end)) : uint8_t(v.size() * 8);
+      return v;
+    }
+
+    // -------------------------------------------------------------------------
+    // json, jsonb: the text is the value.
+    // -------------------------------------------------------------------------
+    template <>
+    json_t parse<json_t>(const char *text, size_t length) {
+      return json_t { text, length };
+    }
+
+    template <>
+    jsonb_t parse<jsonb_t>(const char *text, size_t length) {
+      return jsonb_t { text, length };
+    }
+
+    // -------------------------------------------------------------------------
+    // Ranges and multiranges
+    // -------------------------------------------------------------------------
+
+    template <>
+    range<int32_t> parse<range<int32_t>>(const char *text, size_t length) {
+      return parseRange<int32_t>(text, length);
+    }
+
+    template <>
+    range<int64_t> parse<range<int64_t>>(const char *text, size_t length) {
+      return parseRange<int64_t>(text, length);
+    }
+
+    template <>
+    range<numeric_t> parse<range<numeric_t>>(const char *text, size_t length) {
+      return parseRange<numeric_t>(text, length);
+    }
+
+    template <>
+    range<date_t> parse<range<date_t>>(const char *text, size_t length) {
+      return parseRange<date_t>(text, length);
+    }
+
+    template <>
+    range<timestamp_t> parse<range<timestamp_t>>(const char *text, size_t length) {
+      return parseRange<timestamp_t>(text, length);
+    }
+
+    template <>
+    range<timestamptz_t> parse<range<timestamptz_t>>(const char *text, size_t length) {
+      return parseRange<timestamptz_t>(text, length);
+    }
+
+    template <>
+    multirange<int32_t> parse<multirange<int32_t>>(const char *text, size_t length) {
+      return parseMultirange<int32_t>(text, length);
+    }
+
+    template <>
+    multirange<int64_t> parse<multirange<int64_t>>(const char *text, size_t length) {
+      return parseMultirange<int64_t>(text, length);
+    }
+
+    template <>
+    multirange<numeric_t> parse<multirange<numeric_t>>(const char *text, size_t length) {
+      return parseMultirange<numeric_t>(text, length);
+    }
+
+    template <>
+    multirange<date_t> parse<multirange<date_t>>(const char *text, size_t length) {
+      return parseMultirange<date_t>(text, length);
+    }
+
+    template <>
+    multirange<timestamp_t> parse<multirange<timestamp_t>>(const char *text, size_t length) {
+      return parseMultirange<timestamp_t>(text, length);
+    }
+
+    template <>
+    multirange<timestamptz_t> parse<multirange<timestamptz_t>>(const char *text, size_t length) {
+      return parseMultirange<timestamptz_t>(text, length);
+    }
+
+    // -------------------------------------------------------------------------
+    // ISO 8601 formatting of date and time values
+    // -------------------------------------------------------------------------
+
+    namespace {
+
+      const char DIGITS[] =
+        "00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+        "40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+        "8081828384858687888990919293949596979899";
+
+      inline char *twoDigits(unsigned value, char *buf) {
+        std::memcpy(buf, DIGITS + 2 * value, 2);
+        return buf + 2;
+      }
+
+      // -----------------------------------------------------------------------
+      // Decimal digits of an unsigned value, with at least `width` digits.
+      // -----------------------------------------------------------------------
+      char *unsignedInteger(uint64_t value, char *buf, int width = 1) {
+        char tmp[20];
+        char *p = tmp + sizeof(tmp);
+        while (value >= 100) {
+          p -= 2;
+          std::memcpy(p, DIGITS + 2 * (value % 100), 2);
+          value /= 100;
+        }
+        if (value >= 10) {
+          p -= 2;
+          std::memcpy(p, DIGITS + 2 * value, 2);
+        }
+        else {
+          *--p = char('0' + value);
+        }
+        for (int n = int(tmp + sizeof(tmp) - p); n < width; n++) {
+          *buf++ = '0';
+        }
+        size_t n = size_t(tmp + sizeof(tmp) - p);
+        std::memcpy(buf, p, n);
+        return buf + n;
+      }
+
+      char *integer(int64_t value, char *buf) {
+        if (value < 0) {
+          *buf++ = '-';
+          return unsignedInteger(0 - uint64_t(value), buf);
+        }
+        return unsignedInteger(uint64_t(value), buf);
+      }
+
+      // -----------------------------------------------------------------------
+      // `.ffffff` without the trailing zeros, nothing for 0.
+      // -----------------------------------------------------------------------
+      char *fraction(int64_t microseconds, char *buf) {
+        if (microseconds == 0) {
+          return buf;
+        }
+        *buf++ = '.';
+        unsigned value = unsigned(microseconds);
+        buf = twoDigits(value / 10000, buf);
+        buf = twoDigits(value / 100 % 100, buf);
+        buf = twoDigits(value % 100, buf);
+        while (buf[-1] == '0') {
+          buf--;
+        }
+        return buf;
+      }
+
+      inline int64_t floorDiv(int64_t value, int64_t divisor) {
+        int64_t q = value / divisor;
+        return (value % divisor < 0) ? q - 1 : q;
+      }
+
+      // -----------------------------------------------------------------------
+      // `YYYY-MM-DD` of a number of days since 1970-01-01. Years before 1 or
+      // after 9999 are signed as in ISO 8601 (the year 0 is 1 BC).
+      // (http://howardhinnant.github.io/date_algorithms.html)
+      // -----------------------------------------------------------------------
+      char *date(int64_t days, char *buf) {
+        days += 719468;
+        int64_t era = floorDiv(days, 146097);
+        unsigned doe = unsigned(days - era * 146097);
+        unsigned yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+        unsigned doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+        unsigned mp = (5 * doy + 2) / 153;
+        unsigned day = doy - (153 * mp + 2) / 5 + 1;
+        unsigned month = mp < 10 ? mp + 3 : mp - 9;
+        int64_t year = int64_t(yoe) + era * 400 + (month <= 2);
+
+        if (year >= 0 && year <= 9999) {
+          buf = twoDigits(unsigned(year / 100), buf);
+          buf = twoDigits(unsigned(year % 100), buf);
+        }
+        else {
+          *buf++ = year < 0 ? '-' : '+';
+          buf = unsignedInteger(uint64_t(year < 0 ? -year : year), buf, 4);
+        }
+        *buf++ = '-';
+        buf = twoDigits(month, buf);
+        *buf++ = '-';
+        return twoDigits(day, buf);
+      }
+
+      // -----------------------------------------------------------------------
+      // `HH:MM:SS[.ffffff]` of a number of microseconds since 00:00:00.
+      // -----------------------------------------------------------------------
+      char *time(int64_t microseconds, char *buf) {
+        unsigned seconds = unsigned(microseconds / 1000000);
+        buf = twoDigits(seconds / 3600, buf);
+        *buf++ = ':';
+        buf = twoDigits(seconds / 60 % 60, buf);
+        *buf++ = ':';
+        buf = twoDigits(seconds % 60, buf);
+        return fraction(microseconds % 1000000, buf);
+      }
+
+      // -----------------------------------------------------------------------
+      // `±HH:MM[:SS]` of an offset in seconds east of UTC.
+      // -----------------------------------------------------------------------
+      char *offset(int32_t seconds, char *buf) {
+        *buf++ = seconds < 0 ? '-' : '+';
+        unsigned value = unsigned(seconds < 0 ? -seconds : seconds);
+        buf = twoDigits(value / 3600, buf);
+        *buf++ = ':';
+        buf = twoDigits(value / 60 % 60, buf);
+        if (value % 60) {
+          *buf++ = ':';
+          buf = twoDigits(value % 60, buf);
+        }
+        return buf;
+      }
+
+      template <typename T>
+      char *infinity(T value, char *buf) {
+        const char *text = value == std::numeric_limits<T>::max() ? "infinity" : "-infinity";
+        size_t length = std::strlen(text);
+        std::memcpy(buf, text, length);
+        return buf + length;
+      }
+
+      template <typename T>
+      bool isInfinity(T value) {
+        return value == std::numeric_limits<T>::max() || value == std::numeric_limits<T>::min();
+      }
+
+      // -----------------------------------------------------------------------
+      // `YYYY-MM-DDTHH:MM:SS[.ffffff]` of microseconds since Unix epoch.
+      // -----------------------------------------------------------------------
+      char *timestamp(int64_t epoch_time, char *buf) {
+        int64_t days = floorDiv(epoch_time, MICROSEC_PER_DAY);
+        buf = date(days, buf);
+        *buf++ = 'T';
+        return time(epoch_time - days * MICROSEC_PER_DAY, buf);
+      }
+
+    } // namespace
+
+    char *format(date_t value, char *buf) {
+      if (isInfinity(value.epoch_date)) {
+        return infinity(value.epoch_date, buf);
+      }
+      return date(floorDiv(value.epoch_date, 86400), buf);
+    }
+
+    char *format(time_t value, char *buf) {
+      return time(value.time, buf);
+    }
+
+    char *format(timetz_t value, char *buf) {
+      buf = time(value.time, buf);
+      return offset(-value.offset, buf); // `offset` is in seconds west of UTC
+    }
+
+    char *format(timestamp_t value, char *buf) {
+      if (isInfinity(value.epoch_time)) {
+        return infinity(value.epoch_time, buf);
+      }
+      return timestamp(value.epoch_time, buf);
+    }
+
+    char *format(timestamptz_t value, char *buf) {
+      if (isInfinity(value.epoch_time)) {
+        return infinity(value.epoch_time, buf);
+      }
+      buf = timestamp(value.epoch_time, buf);
+      *buf++ = 'Z';
+      return buf;
+    }
+
+    // -------------------------------------------------------------------------
+    // ISO 8601 duration, as with `IntervalStyle` set to `iso_8601`. Each
+    // field keeps its own sign: `P1Y-2M3DT-4H-5M-6.5S`.
+    // -------------------------------------------------------------------------
+    char *format(interval_t value, char *buf) {
+      *buf++ = 'P';
+      if (value.months == 0 && value.days == 0 && value.time == 0) {
+        std::memcpy(buf, "T0S", 3);
+        return buf + 3;
+      }
+
+      if (value.months / 12 != 0) {
+        buf = integer(value.months / 12, buf);
+        *buf++ = 'Y';
+      }
+      if (value.months % 12 != 0) {
+        buf = integer(value.months % 12, buf);
+        *buf++ = 'M';
+      }
+      if (value.days != 0) {
+        buf = integer(value.days, buf);
+        *buf++ = 'D';
+      }
+      if (value.time != 0) {
+        *buf++ = 'T';
+        int64_t seconds = value.time / 1000000;
+        int64_t microseconds = value.time % 1000000;
+        if (seconds / 3600 != 0) {
+          buf = integer(seconds / 3600, buf);
+          *buf++ = 'H';
+        }
+        if (seconds / 60 % 60 != 0) {
+          buf = integer(seconds / 60 % 60, buf);
+          *buf++ = 'M';
+        }
+        if (seconds % 60 != 0 || microseconds != 0) {
+          if (value.time < 0) {
+            *buf++ = '-';
+          }
+          buf = unsignedInteger(uint64_t(seconds % 60 < 0 ? -(seconds % 60) : seconds % 60), buf);
+          buf = fraction(microseconds < 0 ? -microseconds : microseconds, buf);
+          *buf++ = 'S';
+        }
+      }
+      return buf;
+    }
+
+  } // namespace postgres
+}   // namespace db
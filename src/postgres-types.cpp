@@ -20,8 +20,14 @@
  * SOFTWARE.
  **/
 #include "postgres-types.h"
+#include "postgres-exceptions.h"
 
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstdio>
 #include <cstring>
+#include <limits>
 
 
 // -------------------------------------------------------------------------
@@ -352,5 +358,636 @@ namespace db {
       return buf + sizeof(interval_t);
     }
 
+    // -------------------------------------------------------------------------
+    // numeric
+    // -------------------------------------------------------------------------
+
+    const uint16_t numeric_t::POS;
+    const uint16_t numeric_t::NEG;
+    const uint16_t numeric_t::NaN;
+    const uint16_t numeric_t::PINF;
+    const uint16_t numeric_t::NINF;
+
+    const int NUMERIC_BASE = 10000;
+    const int NUMERIC_BASE_DIGITS = 4;
+    const numeric_uint_t NUMERIC_INT_MAX = ~numeric_uint_t(0) >> 1;
+
+    // Largest scale of a fixed-point value: 10^scale fits in a numeric_uint_t
+    // and is larger than any unscaled value above.
+    const int NUMERIC_INT_DIGITS10 = sizeof(numeric_int_t) == 16 ? 38 : 18;
+
+    // -------------------------------------------------------------------------
+    // 10^exponent
+    // -------------------------------------------------------------------------
+    static numeric_uint_t pow10(int exponent) {
+      numeric_uint_t value = 1;
+      while (exponent-- > 0) {
+        value *= 10;
+      }
+      return value;
+    }
+
+    // -------------------------------------------------------------------------
+    // Convert a fixed-point value into the arbitrary-precision form.
+    // -------------------------------------------------------------------------
+    static void toDigits(const numeric_t &n, int16_t &weight, std::vector<int16_t> &digits) {
+      numeric_uint_t u = n.unscaled < 0 ? numeric_uint_t(0) - numeric_uint_t(n.unscaled) : numeric_uint_t(n.unscaled);
+      bool integral = n.scale <= NUMERIC_INT_DIGITS10; // otherwise, no integer part.
+      numeric_uint_t ip = integral ? u / pow10(n.scale) : 0;
+      numeric_uint_t fp = integral ? u % pow10(n.scale) : u;
+
+      // Digits are collected from the least significant one.
+      std::vector<int16_t> groups;
+      int scale = n.scale;
+      if (scale % NUMERIC_BASE_DIGITS) {
+        // The last group is padded with zeros on its right.
+        int r = scale % NUMERIC_BASE_DIGITS;
+        groups.push_back(int16_t((fp % pow10(r)) * pow10(NUMERIC_BASE_DIGITS - r)));
+        fp /= pow10(r);
+        scale -= r;
+      }
+      for (; scale > 0; scale -= NUMERIC_BASE_DIGITS) {
+        groups.push_back(int16_t(fp % NUMERIC_BASE));
+        fp /= NUMERIC_BASE;
+      }
+      int fractional = int(groups.size());
+      while (ip) {
+        groups.push_back(int16_t(ip % NUMERIC_BASE));
+        ip /= NUMERIC_BASE;
+      }
+      weight = int16_t(int(groups.size()) - fractional - 1);
+
+      // Leading and trailing zeros are not sent.
+      size_t end = groups.size();
+      while (end > 0 && groups[end - 1] == 0) {
+        end--;
+        weight--;
+      }
+      size_t begin = 0;
+      while (begin < end && groups[begin] == 0) {
+        begin++;
+      }
+
+      digits.assign(groups.rbegin() + (groups.size() - end), groups.rend() - begin);
+      if (digits.empty()) {
+        weight = 0;
+      }
+    }
+
+    double numeric_t::toDouble() const {
+      switch (sign) {
+        case NaN: return std::numeric_limits<double>::quiet_NaN();
+        case PINF: return std::numeric_limits<double>::infinity();
+        case NINF: return -std::numeric_limits<double>::infinity();
+        default: break;
+      }
+
+      if (isFixed()) {
+        return double(unscaled) / (scale <= NUMERIC_INT_DIGITS10 ? double(pow10(scale)) : std::pow(10., scale));
+      }
+
+      double value = 0;
+      for (size_t i = 0; i < digits.size(); i++) {
+        value += digits[i] * std::pow(double(NUMERIC_BASE), weight - int(i));
+      }
+      return sign == NEG ? -value : value;
+    }
+
+    std::string numeric_t::str() const {
+      switch (sign) {
+        case NaN: return "NaN";
+        case PINF: return "Infinity";
+        case NINF: return "-Infinity";
+        default: break;
+      }
+
+      int16_t w = weight;
+      const std::vector<int16_t> *d = &digits;
+      std::vector<int16_t> fixed;
+      bool negative = sign == NEG;
+      if (isFixed()) {
+        toDigits(*this, w, fixed);
+        d = &fixed;
+        negative = unscaled < 0;
+      }
+
+      std::string str;
+      if (negative) {
+        str += '-';
+      }
+
+      // Integer part
+      if (w < 0) {
+        str += '0';
+      }
+      else {
+        for (int i = 0; i <= w; i++) {
+          int16_t digit = i < int(d->size()) ? (*d)[i] : 0;
+          char group[5];
+          std::snprintf(group, sizeof(group), i == 0 ? "%d" : "%04d", digit);
+          str += group;
+        }
+      }
+
+      // Fractional part, `scale` digits
+      if (scale > 0) {
+        str += '.';
+        for (int i = 0; i < scale; i++) {
+          // Index of the base 10000 digit holding the decimal digit `i`.
+          int group = w + 1 + i / NUMERIC_BASE_DIGITS;
+          int16_t digit = group >= 0 && group < int(d->size()) ? (*d)[group] : 0;
+          int position = NUMERIC_BASE_DIGITS - 1 - i % NUMERIC_BASE_DIGITS;
+          str += char('0' + (digit / int(pow10(position))) % 10);
+        }
+      }
+
+      return str;
+    }
+
+    // -------------------------------------------------------------------------
+    // The binary format is:
+    //
+    // struct pg_numeric {
+    //   int16_t ndigits;  /* Number of base 10000 digits */
+    //   int16_t weight;   /* Weight of the first digit */
+    //   int16_t sign;     /* NUMERIC_POS, NUMERIC_NEG, NUMERIC_NAN... */
+    //   int16_t dscale;   /* Display scale */
+    //   int16_t digits[]; /* Base 10000 digits */
+    // }
+    // -------------------------------------------------------------------------
+
+    template <>
+    numeric_t read<numeric_t>(char **buf, size_t size) {
+      if (size < 4 * sizeof(int16_t)) {
+        throw ExecutionException("invalid numeric");
+      }
+      int16_t ndigits = read<int16_t>(buf);
+      if (ndigits < 0 || size < (4 + size_t(ndigits)) * sizeof(int16_t)) {
+        throw ExecutionException("invalid numeric");
+      }
+      int16_t weight = read<int16_t>(buf);
+      uint16_t sign = uint16_t(read<int16_t>(buf));
+      int16_t dscale = read<int16_t>(buf);
+
+      numeric_t n(0, dscale);
+      if (sign != numeric_t::POS && sign != numeric_t::NEG) {
+        n.sign = sign; // special value
+        return n;
+      }
+
+      // Try the fixed-point form first, unless 10^dscale does not fit.
+      char *start = *buf;
+      numeric_uint_t value = 0;
+      bool overflow = dscale > NUMERIC_INT_DIGITS10;
+      for (int16_t i = 0; i < ndigits && !overflow; i++) {
+        int16_t digit = read<int16_t>(buf);
+        overflow = value > (NUMERIC_INT_MAX - digit) / NUMERIC_BASE;
+        value = value * NUMERIC_BASE + digit;
+      }
+
+      int exponent = NUMERIC_BASE_DIGITS * (weight - ndigits + 1) + dscale;
+      for (; exponent > 0 && !overflow; exponent--) {
+        overflow = value > NUMERIC_INT_MAX / 10;
+        value *= 10;
+      }
+      if (exponent < 0 && !overflow) {
+        value /= pow10(-exponent);
+      }
+
+      if (!overflow) {
+        n.unscaled = sign == numeric_t::NEG ? -numeric_int_t(value) : numeric_int_t(value);
+        return n;
+      }
+
+      // Arbitrary-precision form
+      *buf = start;
+      n.weight = weight;
+      n.sign = sign;
+      n.digits.resize(ndigits);
+      for (int16_t i = 0; i < ndigits; i++) {
+        n.digits[i] = read<int16_t>(buf);
+      }
+      return n;
+    }
+
+    numeric_t toArbitrary(const numeric_t &n) {
+      if (!n.isFixed()) {
+        return n;
+      }
+      numeric_t a(0, n.scale);
+      a.sign = n.unscaled < 0 ? numeric_t::NEG : numeric_t::POS;
+      toDigits(n, a.weight, a.digits);
+      return a;
+    }
+
+    bool numeric_t::operator==(const numeric_t &other) const {
+      if (isFixed() && other.isFixed() && scale == other.scale) {
+        return unscaled == other.unscaled;
+      }
+      if (!(sign == POS || sign == NEG) || !(other.sign == POS || other.sign == NEG)) {
+        return sign == other.sign;
+      }
+
+      // Compare the significant digits, zeros on both ends being ignored.
+      numeric_t a = toArbitrary(*this), b = toArbitrary(other);
+      size_t abegin = 0, aend = a.digits.size(), bbegin = 0, bend = b.digits.size();
+      while (abegin < aend && a.digits[abegin] == 0) {
+        abegin++;
+      }
+      while (aend > abegin && a.digits[aend - 1] == 0) {
+        aend--;
+      }
+      while (bbegin < bend && b.digits[bbegin] == 0) {
+        bbegin++;
+      }
+      while (bend > bbegin && b.digits[bend - 1] == 0) {
+        bend--;
+      }
+      if (abegin == aend || bbegin == bend) {
+        return abegin == aend && bbegin == bend; // zero has no sign
+      }
+      return a.sign == b.sign
+        && a.weight - int(abegin) == b.weight - int(bbegin)
+        && aend - abegin == bend - bbegin
+        && std::equal(a.digits.begin() + abegin, a.digits.begin() + aend, b.digits.begin() + bbegin);
+    }
+
+    int32_t length(const numeric_t &n) {
+      size_t ndigits = n.digits.size();
+      if (n.isFixed()) {
+        int16_t weight;
+        std::vector<int16_t> digits;
+        toDigits(n, weight, digits);
+        ndigits = digits.size();
+      }
+      return int32_t((4 + ndigits) * sizeof(int16_t));
+    }
+
+    char *write(const numeric_t &n, char *buf) {
+      int16_t weight = n.weight;
+      uint16_t sign = n.sign;
+      const std::vector<int16_t> *digits = &n.digits;
+      std::vector<int16_t> fixed;
+      if (n.isFixed()) {
+        toDigits(n, weight, fixed);
+        digits = &fixed;
+        sign = n.unscaled < 0 ? numeric_t::NEG : numeric_t::POS;
+      }
+
+      buf = write(int16_t(digits->size()), buf);
+      buf = write(weight, buf);
+      buf = write(int16_t(sign), buf);
+      buf = write(n.scale, buf);
+      for (int16_t digit: *digits) {
+        buf = write(digit, buf);
+      }
+      return buf;
+    }
+
+    // -------------------------------------------------------------------------
+    // uuid
+    // -------------------------------------------------------------------------
+
+    std::string uuid_t::str() const {
+      static const char hex[] = "0123456789abcdef";
+      std::string str;
+      str.reserve(36);
+      for (int i = 0; i < 16; i++) {
+        if (i == 4 || i == 6 || i == 8 || i == 10) {
+          str += '-';
+        }
+        str += hex[bytes[i] >> 4];
+        str += hex[bytes[i] & 0x0F];
+      }
+      return str;
+    }
+
+    bool uuid_t::operator==(const uuid_t &other) const {
+      return std::memcmp(bytes, other.bytes, sizeof(bytes)) == 0;
+    }
+
+    template <>
+    uuid_t read<uuid_t>(char **buf, size_t size) {
+      uuid_t v;
+      if (size != sizeof(v.bytes)) {
+        throw ExecutionException("invalid uuid");
+      }
+      std::memcpy(v.bytes, move(buf, sizeof(v.bytes)), sizeof(v.bytes));
+      return v;
+    }
+
+    template <>
+    char *write(uuid_t value, char *buf) {
+      std::memcpy(buf, value.bytes, sizeof(value.bytes));
+      return buf + sizeof(value.bytes);
+    }
+
+    // -------------------------------------------------------------------------
+    // macaddr
+    // -------------------------------------------------------------------------
+
+    bool macaddr_t::operator==(const macaddr_t &other) const {
+      return std::memcmp(bytes, other.bytes, sizeof(bytes)) == 0;
+    }
+
+    template <>
+    macaddr_t read<macaddr_t>(char **buf, size_t size) {
+      macaddr_t v;
+      if (size != sizeof(v.bytes)) {
+        throw ExecutionException("invalid macaddr");
+      }
+      std::memcpy(v.bytes, move(buf, sizeof(v.bytes)), sizeof(v.bytes));
+      return v;
+    }
+
+    template <>
+    char *write(macaddr_t value, char *buf) {
+      std::memcpy(buf, value.bytes, sizeof(value.bytes));
+      return buf + sizeof(value.bytes);
+    }
+
+    // -------------------------------------------------------------------------
+    // inet, cidr
+    //
+    // struct pg_inet {
+    //   uint8_t family;  /* PGSQL_AF_INET or PGSQL_AF_INET6 */
+    //   uint8_t bits;    /* Number of bits in netmask */
+    //   uint8_t is_cidr; /* 1 for cidr values */
+    //   uint8_t nb;      /* Number of bytes of the address */
+    //   uint8_t addr[];  /* The address */
+    // }
+    // -------------------------------------------------------------------------
+
+    const uint8_t inet_t::INET;
+    const uint8_t inet_t::INET6;
+
+    bool inet_t::operator==(const inet_t &other) const {
+      return family == other.family && bits == other.bits && cidr == other.cidr
+        && std::memcmp(bytes, other.bytes, size()) == 0;
+    }
+
+    int32_t length(inet_t value) {
+      return 4 + value.size();
+    }
+
+    template <>
+    inet_t read<inet_t>(char **buf, size_t size) {
+      inet_t v;
+      if (size < 4 || size != 4 + size_t(uint8_t((*buf)[3]))) {
+        throw ExecutionException("invalid inet");
+      }
+      v.family = uint8_t(*move(buf, 1));
+      v.bits = uint8_t(*move(buf, 1));
+      v.cidr = *move(buf, 1) != 0;
+      uint8_t nb = uint8_t(*move(buf, 1));
+      std::memset(v.bytes, 0, sizeof(v.bytes));
+      std::memcpy(v.bytes, move(buf, nb), nb < sizeof(v.bytes) ? nb : sizeof(v.bytes));
+      return v;
+    }
+
+    template <>
+    char *write(inet_t value, char *buf) {
+      *buf++ = char(value.family);
+      *buf++ = char(value.bits);
+      *buf++ = char(value.cidr ? 1 : 0);
+      *buf++ = char(value.size());
+      std::memcpy(buf, value.bytes, value.size());
+      return buf + value.size();
+    }
+
+    // -------------------------------------------------------------------------
+    // json
+    // -------------------------------------------------------------------------
+
+    int32_t length(json_t value) {
+      return int32_t(value.length);
+    }
+
+    template <>
+    json_t read<json_t>(char **buf, size_t size) {
+      return json_t { move(buf, size), size };
+    }
+
+    template <>
+    char *write(json_t value, char *buf) {
+      std::memcpy(buf, value.data, value.length);
+      return buf + value.length;
+    }
+
+    // -------------------------------------------------------------------------
+    // jsonb
+    //
+    // The binary format is a version byte followed by the JSON text.
+    // -------------------------------------------------------------------------
+
+    const char JSONB_VERSION = 1;
+
+    int32_t length(jsonb_t value) {
+      return int32_t(value.length + 1);
+    }
+
+    template <>
+    jsonb_t read<jsonb_t>(char **buf, size_t size) {
+      if (size == 0 || **buf != JSONB_VERSION) {
+        throw ExecutionException("unsupported jsonb version");
+      }
+      move(buf, 1);
+      return jsonb_t { move(buf, size - 1), size - 1 };
+    }
+
+    template <>
+    char *write(jsonb_t value, char *buf) {
+      *buf++ = JSONB_VERSION;
+      std::memcpy(buf, value.data, value.length);
+      return buf + value.length;
+    }
+
+    // -------------------------------------------------------------------------
+    // Ranges
+    //
+    // The binary format is a flags byte followed, for a non empty range, by
+    // the length and the value of each finite bound.
+    // -------------------------------------------------------------------------
+
+    const uint8_t RANGE_FLAGS = 0x1F; // flags known by range<T>
+
+    template <typename T>
+    range<T> readRange(char **buf, size_t /* size */) {
+      range<T> r;
+      r.flags = uint8_t(*move(buf, 1)) & RANGE_FLAGS;
+      if (!r.empty()) {
+        if (!r.lowerInf()) {
+          int32_t length = read<int32_t>(buf);
+          r.lower = read<T>(buf, length);
+        }
+        if (!r.upperInf()) {
+          int32_t length = read<int32_t>(buf);
+          r.upper = read<T>(buf, length);
+        }
+      }
+      return r;
+    }
+
+    template <typename T>
+    int32_t length(const range<T> &value) {
+      int32_t size = 1;
+      if (!value.empty()) {
+        if (!value.lowerInf()) {
+          size += sizeof(int32_t) + length(value.lower);
+        }
+        if (!value.upperInf()) {
+          size += sizeof(int32_t) + length(value.upper);
+        }
+      }
+      return size;
+    }
+
+    template <typename T>
+    char *write(const range<T> &value, char *buf) {
+      *buf++ = char(value.flags);
+      if (!value.empty()) {
+        if (!value.lowerInf()) {
+          buf = write(length(value.lower), buf);
+          buf = write(value.lower, buf);
+        }
+        if (!value.upperInf()) {
+          buf = write(length(value.upper), buf);
+          buf = write(value.upper, buf);
+        }
+      }
+      return buf;
+    }
+
+    // -------------------------------------------------------------------------
+    // Multiranges
+    //
+    // The binary format is the number of ranges followed by the length and
+    // the value of each range.
+    // -------------------------------------------------------------------------
+
+    template <typename T>
+    multirange<T> readMultirange(char **buf, size_t size) {
+      // Each range takes at least its length and its flags.
+      int32_t count = size < sizeof(int32_t) ? -1 : read<int32_t>(buf);
+      if (count < 0 || size_t(count) > (size - sizeof(int32_t)) / (sizeof(int32_t) + 1)) {
+        throw ExecutionException("invalid multirange");
+      }
+      multirange<T> ranges(count);
+      for (auto &r: ranges) {
+        int32_t length = read<int32_t>(buf);
+        r = readRange<T>(buf, length);
+      }
+      return ranges;
+    }
+
+    template <typename T>
+    int32_t length(const multirange<T> &value) {
+      int32_t size = sizeof(int32_t);
+      for (auto &r: value) {
+        size += sizeof(int32_t) + length(r);
+      }
+      return size;
+    }
+
+    template <typename T>
+    char *write(const multirange<T> &value, char *buf) {
+      buf = write(int32_t(value.size()), buf);
+      for (auto &r: value) {
+        buf = write(length(r), buf);
+        buf = write(r, buf);
+      }
+      return buf;
+    }
+
+    template <>
+    range<int32_t> read<range<int32_t>>(char **buf, size_t size) {
+      return readRange<int32_t>(buf, size);
+    }
+
+    template <>
+    multirange<int32_t> read<multirange<int32_t>>(char **buf, size_t size) {
+      return readMultirange<int32_t>(buf, size);
+    }
+
+    template int32_t length(const range<int32_t> &value);
+    template char *write(const range<int32_t> &value, char *buf);
+    template int32_t length(const multirange<int32_t> &value);
+    template char *write(const multirange<int32_t> &value, char *buf);
+
+    template <>
+    range<int64_t> read<range<int64_t>>(char **buf, size_t size) {
+      return readRange<int64_t>(buf, size);
+    }
+
+    template <>
+    multirange<int64_t> read<multirange<int64_t>>(char **buf, size_t size) {
+      return readMultirange<int64_t>(buf, size);
+    }
+
+    template int32_t length(const range<int64_t> &value);
+    template char *write(const range<int64_t> &value, char *buf);
+    template int32_t length(const multirange<int64_t> &value);
+    template char *write(const multirange<int64_t> &value, char *buf);
+
+    template <>
+    range<numeric_t> read<range<numeric_t>>(char **buf, size_t size) {
+      return readRange<numeric_t>(buf, size);
+    }
+
+    template <>
+    multirange<numeric_t> read<multirange<numeric_t>>(char **buf, size_t size) {
+      return readMultirange<numeric_t>(buf, size);
+    }
+
+    template int32_t length(const range<numeric_t> &value);
+    template char *write(const range<numeric_t> &value, char *buf);
+    template int32_t length(const multirange<numeric_t> &value);
+    template char *write(const multirange<numeric_t> &value, char *buf);
+
+    template <>
+    range<date_t> read<range<date_t>>(char **buf, size_t size) {
+      return readRange<date_t>(buf, size);
+    }
+
+    template <>
+    multirange<date_t> read<multirange<date_t>>(char **buf, size_t size) {
+      return readMultirange<date_t>(buf, size);
+    }
+
+    template int32_t length(const range<date_t> &value);
+    template char *write(const range<date_t> &value, char *buf);
+    template int32_t length(const multirange<date_t> &value);
+    template char *write(const multirange<date_t> &value, char *buf);
+
+    template <>
+    range<timestamp_t> read<range<timestamp_t>>(char **buf, size_t size) {
+      return readRange<timestamp_t>(buf, size);
+    }
+
+    template <>
+    multirange<timestamp_t> read<multirange<timestamp_t>>(char **buf, size_t size) {
+      return readMultirange<timestamp_t>(buf, size);
+    }
+
+    template int32_t length(const range<timestamp_t> &value);
+    template char *write(const range<timestamp_t> &value, char *buf);
+    template int32_t length(const multirange<timestamp_t> &value);
+    template char *write(const multirange<timestamp_t> &value, char *buf);
+
+    template <>
+    range<timestamptz_t> read<range<timestamptz_t>>(char **buf, size_t size) {
+      return readRange<timestamptz_t>(buf, size);
+    }
+
+    template <>
+    multirange<timestamptz_t> read<multirange<timestamptz_t>>(char **buf, size_t size) {
+      return readMultirange<timestamptz_t>(buf, size);
+    }
+
+    template int32_t length(const range<timestamptz_t> &value);
+    template char *write(const range<timestamptz_t> &value, char *buf);
+    template int32_t length(const multirange<timestamptz_t> &value);
+    template char *write(const multirange<timestamptz_t> &value, char *buf);
+
   } // namespace postgres
 }   // namespace db
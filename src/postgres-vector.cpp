@@ -0,0 +1,121 @@
+/**
+ * Copyright (c) 2016 Philippe FERDINAND
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ **/
+#include "postgres-vector.h"
+
+#include <cassert>
+#include <cstring>
+#include <mutex>
+
+#if defined(__SSE2__) || defined(_M_X64)
+  #include <emmintrin.h>
+  #define VECTOR_SWAP_SSE2 1
+#elif defined(__ARM_NEON) && defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+  #include <arm_neon.h>
+  #define VECTOR_SWAP_NEON 1
+#endif
+
+namespace db {
+  namespace postgres {
+
+    // -------------------------------------------------------------------------
+    // Byte order of the components
+    //
+    // The components are sent as big-endian 32 bit floats. They are swapped
+    // four at a time when SIMD instructions are available, the remaining
+    // components (or all of them otherwise) being swapped one by one.
+    // -------------------------------------------------------------------------
+    static void swapFloats(const char *src, char *dst, size_t size) {
+      size_t i = 0;
+#if VECTOR_SWAP_SSE2
+      for (; i + 4 <= size; i += 4) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i * 4));
+        v = _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8)); // bytes of each 16 bit word
+        v = _mm_shufflelo_epi16(v, _MM_SHUFFLE(2, 3, 0, 1));          // 16 bit words of each float
+        v = _mm_shufflehi_epi16(v, _MM_SHUFFLE(2, 3, 0, 1));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i * 4), v);
+      }
+#elif VECTOR_SWAP_NEON
+      for (; i + 4 <= size; i += 4) {
+        uint8x16_t v = vld1q_u8(reinterpret_cast<const uint8_t *>(src + i * 4));
+        vst1q_u8(reinterpret_cast<uint8_t *>(dst + i * 4), vrev32q_u8(v));
+      }
+#endif
+      for (; i < size; i++) {
+        char *buf = const_cast<char *>(src + i * 4);
+        int32_t v = read<int32_t>(&buf);
+        std::memcpy(dst + i * 4, &v, sizeof(v));
+      }
+    }
+
+    // -------------------------------------------------------------------------
+    // vector
+    //
+    // The binary format is the number of components and an unused field, both
+    // 16 bit integers, followed by the components.
+    // -------------------------------------------------------------------------
+    const size_t VECTOR_HEADER = 2 * sizeof(int16_t);
+
+    static char *writeVector(const float *values, size_t size, char *buf) {
+      assert(size <= 16000); // maximum number of dimensions of a vector.
+      buf = write(int16_t(size), buf);
+      buf = write(int16_t(0), buf);
+      swapFloats(reinterpret_cast<const char *>(values), buf, size);
+      return buf + size * sizeof(float);
+    }
+
+    static vector_t readVector(char *buf, size_t length) {
+      vector_t vector;
+      size_t size = uint16_t(read<int16_t>(&buf));
+      read<int16_t>(&buf); // unused
+      assert(length == VECTOR_HEADER + size * sizeof(float));
+      vector.values.resize(size);
+      swapFloats(buf, reinterpret_cast<char *>(vector.values.data()), size);
+      return vector;
+    }
+
+    // -------------------------------------------------------------------------
+    // Register the pgvector types
+    // -------------------------------------------------------------------------
+    void registerVectorTypes(const std::string &name) {
+      static std::once_flag registered;
+      std::call_once(registered, [&name]() {
+        TypeRegistry::add<vector_t>(name,
+          [](const vector_t &v) { return VECTOR_HEADER + v.values.size() * sizeof(float); },
+          [](const vector_t &v, char *buf) { return writeVector(v.values.data(), v.values.size(), buf); },
+          readVector);
+
+        TypeRegistry::add<vector_view_t>(name,
+          [](const vector_view_t &v) { return VECTOR_HEADER + v.size * sizeof(float); },
+          [](const vector_view_t &v, char *buf) { return writeVector(v.data, v.size, buf); },
+          nullptr);
+
+#if LIBPQMXX_HAS_SPAN
+        TypeRegistry::add<std::span<const float>>(name,
+          [](const std::span<const float> &v) { return VECTOR_HEADER + v.size_bytes(); },
+          [](const std::span<const float> &v, char *buf) { return writeVector(v.data(), v.size(), buf); },
+          nullptr);
+#endif
+      });
+    }
+
+  } // namespace postgres
+}   // namespace db
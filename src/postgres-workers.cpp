@@ -0,0 +1,144 @@
+/**
+ * Copyright (c) 2016 Philippe FERDINAND
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ **/
+#include "postgres-workers.h"
+
+#include <cassert>
+
+namespace db {
+  namespace postgres {
+
+    // Pool and queue of the worker running on the current thread, if any.
+    static thread_local WorkerPool *currentPool = nullptr;
+    static thread_local size_t currentQueue = 0;
+
+    // -------------------------------------------------------------------------
+    // Constructor
+    // -------------------------------------------------------------------------
+    WorkerPool::WorkerPool(size_t threads)
+      : next_(0), queued_(0), stopped_(false) {
+      if (threads == 0) {
+        threads = 1;
+      }
+      for (size_t i = 0; i < threads; i++) {
+        queues_.emplace_back(new Queue());
+      }
+      for (size_t i = 0; i < threads; i++) {
+        threads_.emplace_back(&WorkerPool::run, this, i);
+      }
+    }
+
+    // -------------------------------------------------------------------------
+    // Destructor
+    // -------------------------------------------------------------------------
+    WorkerPool::~WorkerPool() {
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopped_ = true;
+      }
+      wakeup_.notify_all();
+      for (auto &thread: threads_) {
+        thread.join();
+      }
+    }
+
+    size_t WorkerPool::size() const noexcept {
+      return threads_.size();
+    }
+
+    // -------------------------------------------------------------------------
+    // Submit a task
+    // -------------------------------------------------------------------------
+    void WorkerPool::submit(std::function<void()> task) {
+      size_t index = currentPool == this
+        ? currentQueue
+        : next_.fetch_add(1, std::memory_order_relaxed) % queues_.size();
+
+      {
+        // The counter is incremented under the lock to avoid a lost wakeup,
+        // and before the task is queued so it never goes below zero.
+        std::lock_guard<std::mutex> lock(mutex_);
+        queued_++;
+      }
+
+      {
+        std::lock_guard<std::mutex> lock(queues_[index]->mutex);
+        queues_[index]->tasks.push_back(std::move(task));
+      }
+      wakeup_.notify_one();
+    }
+
+    // -------------------------------------------------------------------------
+    // Get a task
+    // -------------------------------------------------------------------------
+    bool WorkerPool::pop(size_t index, std::function<void()> &task) {
+      {
+        // Own queue first, newest task first (most likely to be hot in cache).
+        std::lock_guard<std::mutex> lock(queues_[index]->mutex);
+        auto &tasks = queues_[index]->tasks;
+        if (!tasks.empty()) {
+          task = std::move(tasks.back());
+          tasks.pop_back();
+          queued_--;
+          return true;
+        }
+      }
+
+      // Steal the oldest task of another queue.
+      for (size_t i = 1; i < queues_.size(); i++) {
+        Queue &victim = *queues_[(index + i) % queues_.size()];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.tasks.empty()) {
+          task = std::move(victim.tasks.front());
+          victim.tasks.pop_front();
+          queued_--;
+          return true;
+        }
+      }
+
+      return false;
+    }
+
+    // -------------------------------------------------------------------------
+    // Worker thread
+    // -------------------------------------------------------------------------
+    void WorkerPool::run(size_t index) {
+      currentPool = this;
+      currentQueue = index;
+
+      std::function<void()> task;
+      for (;;) {
+        if (pop(index, task)) {
+          task();
+          task = nullptr;
+          continue;
+        }
+
+        std::unique_lock<std::mutex> lock(mutex_);
+        wakeup_.wait(lock, [this] { return queued_ > 0 || stopped_; });
+        if (stopped_ && queued_ == 0) {
+          return;
+        }
+      }
+    }
+
+  } // namespace postgres
+}   // namespace db
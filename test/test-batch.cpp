@@ -0,0 +1,153 @@
+/**
+ * Copyright (c) 2016 Philippe FERDINAND
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ **/
+#include "gtest/gtest.h"
+#include "postgres-batch.h"
+#include "postgres-exceptions.h"
+
+#include <set>
+
+using namespace db::postgres;
+
+static std::shared_ptr<Connection> connect() {
+  auto cnx = std::make_shared<Connection>();
+  cnx->connect();
+  return cnx;
+}
+
+TEST(batch, load) {
+
+  BatchLoader<int32_t, std::string> loader(connect(),
+    "SELECT x, 'label ' || x FROM generate_series(1, 1000) AS x WHERE x = ANY($1)",
+    [](const Row &row) { return row.as<std::string>(1); });
+  loader.window(std::chrono::milliseconds(10)).batchSize(100);
+
+  // Each key is requested by several threads.
+  std::vector<std::future<std::vector<std::string>>> futures[4];
+  std::vector<std::thread> threads;
+  for (auto &f: futures) {
+    threads.emplace_back([&loader, &f]() {
+      for (int32_t key = 1; key <= 1200; key++) {
+        f.push_back(loader.load(key));
+      }
+    });
+  }
+  for (auto &thread: threads) {
+    thread.join();
+  }
+
+  for (auto &f: futures) {
+    for (int32_t key = 1; key <= 1200; key++) {
+      std::vector<std::string> values = f[key - 1].get();
+      if (key <= 1000) {
+        ASSERT_EQ(1, values.size());
+        EXPECT_EQ("label " + std::to_string(key), values[0]);
+      }
+      else {
+        EXPECT_TRUE(values.empty());
+      }
+    }
+  }
+
+}
+
+TEST(batch, coalesce) {
+
+  // The loader is held on the first key while the threads request the
+  // others, each statement having its own transaction id.
+  std::promise<void> entered;
+  std::promise<void> released;
+  std::shared_future<void> release = released.get_future().share();
+  std::set<int64_t> batches;
+  BatchLoader<int32_t, int64_t> loader(connect(),
+    "SELECT x, txid_current() FROM generate_series(0, 1200) AS x WHERE x = ANY($1)",
+    [&](const Row &row) {
+      if (row.as<int32_t>(0) == 0) {
+        entered.set_value();
+        release.wait();
+      }
+      batches.insert(row.as<int64_t>(1));
+      return row.as<int64_t>(1);
+    });
+  loader.window(std::chrono::milliseconds(10)).batchSize(100);
+
+  auto first = loader.load(0);
+  entered.get_future().wait();
+
+  std::vector<std::future<std::vector<int64_t>>> futures[4];
+  std::vector<std::thread> threads;
+  for (auto &f: futures) {
+    threads.emplace_back([&loader, &f]() {
+      for (int32_t key = 1; key <= 1200; key++) {
+        f.push_back(loader.load(key));
+      }
+    });
+  }
+  for (auto &thread: threads) {
+    thread.join();
+  }
+  released.set_value();
+
+  // Each key is loaded once, by batches of 100 keys.
+  first.get();
+  for (int32_t key = 1; key <= 1200; key++) {
+    std::vector<int64_t> values = futures[0][key - 1].get();
+    ASSERT_EQ(1, values.size());
+    for (int i = 1; i < 4; i++) {
+      EXPECT_EQ(values, futures[i][key - 1].get());
+    }
+  }
+  EXPECT_EQ(1 + 12, batches.size());
+
+}
+
+TEST(batch, many) {
+
+  // Several rows for a key.
+  BatchLoader<std::string, int32_t> loader(connect(),
+    "SELECT k, x FROM generate_series(1, 9) AS x, LATERAL (SELECT (x % 3)::text AS k) AS t WHERE k = ANY($1) ORDER BY x",
+    [](const Row &row) { return row.as<int32_t>(1); });
+
+  auto zero = loader.load("0");
+  auto one = loader.load("1");
+  auto unknown = loader.load("3");
+  EXPECT_EQ(std::vector<int32_t>({ 3, 6, 9 }), zero.get());
+  EXPECT_EQ(std::vector<int32_t>({ 1, 4, 7 }), one.get());
+  EXPECT_TRUE(unknown.get().empty());
+
+}
+
+TEST(batch, error) {
+
+  BatchLoader<int32_t, int32_t> loader(connect(),
+    "SELECT x, 1 / (x - 2) FROM generate_series(1, 3) AS x WHERE x = ANY($1)",
+    [](const Row &row) { return row.as<int32_t>(1); });
+  loader.window(std::chrono::milliseconds(10));
+
+  auto one = loader.load(1);
+  auto two = loader.load(2);
+  EXPECT_THROW(one.get(), ExecutionException);
+  EXPECT_THROW(two.get(), ExecutionException);
+
+  // The next batches are loaded.
+  EXPECT_EQ(std::vector<int32_t>({ 1 }), loader.load(3).get());
+
+}
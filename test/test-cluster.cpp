@@ -0,0 +1,96 @@
+/**
+ * Copyright (c) 2016 Philippe FERDINAND
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ **/
+#include "gtest/gtest.h"
+#include "postgres-cluster.h"
+#include "postgres-exceptions.h"
+
+#include <map>
+
+using namespace db::postgres;
+
+TEST(cluster, consistent_hashing) {
+
+  // Pools with no connection: only the routing is tested.
+  ShardedCluster cluster;
+  EXPECT_THROW(cluster.locate(1), ExecutionException);
+  for (int i = 0; i < 4; i++) {
+    cluster.add("shard-" + std::to_string(i), std::make_shared<ConnectionPool>(0));
+  }
+  EXPECT_EQ(4, cluster.size());
+  EXPECT_THROW(cluster.add("shard-0", std::make_shared<ConnectionPool>(0)), ExecutionException);
+  EXPECT_EQ(cluster.locate("tenant"), cluster.locate(std::string("tenant")));
+
+  std::map<std::string, int> keys;
+  std::vector<std::string> before;
+  for (int32_t key = 0; key < 10000; key++) {
+    before.push_back(cluster.locate(key));
+    keys[before.back()]++;
+  }
+  for (auto &shard: keys) {
+    EXPECT_GT(shard.second, 1500);
+  }
+
+  // Only keys moving to the new shard.
+  cluster.add("shard-4", std::make_shared<ConnectionPool>(0));
+  int moved = 0;
+  for (int32_t key = 0; key < 10000; key++) {
+    std::string shard = cluster.locate(key);
+    if (shard != before[key]) {
+      EXPECT_EQ("shard-4", shard);
+      moved++;
+    }
+  }
+  EXPECT_GT(moved, 1000);
+  EXPECT_LT(moved, 3000);
+
+  // Back to the initial mapping.
+  cluster.remove("shard-4");
+  for (int32_t key = 0; key < 10000; key++) {
+    EXPECT_EQ(before[key], cluster.locate(key));
+  }
+
+}
+
+TEST(cluster, execute) {
+
+  ShardedCluster cluster;
+  auto first = std::make_shared<ConnectionPool>(1);
+  auto second = std::make_shared<ConnectionPool>(1);
+  cluster.add("first", first);
+  cluster.add("second", second);
+
+  for (int32_t key = 0; key < 10; key++) {
+    EXPECT_EQ(key, (*cluster.execute(key, "SELECT $1", key).begin()).as<int32_t>(0));
+  }
+
+  std::vector<ResultSet> sets = cluster.scatter("SELECT generate_series(1, $1)", 3);
+  ASSERT_EQ(2, sets.size());
+  EXPECT_EQ(3, sets[0].size());
+  EXPECT_EQ(3, sets[1].size());
+
+  // The connections remain usable after an error.
+  EXPECT_THROW(cluster.scatter("SELECT 1/$1", 0), ExecutionException);
+  EXPECT_EQ(2, cluster.scatter("SELECT 1").size());
+  EXPECT_EQ(1, first->idle());
+  EXPECT_EQ(1, second->idle());
+
+}
@@ -0,0 +1,159 @@
+/**
+ * Copyright (c) 2016 Philippe FERDINAND
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ **/
+#include "gtest/gtest.h"
+#include "postgres-copy.h"
+#include "postgres-exceptions.h"
+
+#include <cstdio>
+#include <fstream>
+
+using namespace db::postgres;
+
+// Connections to load a table and a temporary file.
+struct Copy {
+  Connection cnx[3];
+  std::vector<Connection *> connections;
+  std::string path;
+
+  Copy() : path("test_copy.tmp") {
+    for (auto &c: cnx) {
+      c.connect();
+      connections.push_back(&c);
+    }
+    cnx[0].execute("DROP TABLE IF EXISTS test_copy");
+    cnx[0].execute("CREATE TABLE test_copy (id INTEGER PRIMARY KEY, label TEXT)");
+  }
+
+  ~Copy() {
+    cnx[0].execute("DROP TABLE test_copy");
+    std::remove(path.c_str());
+  }
+
+  void write(const std::string &content) {
+    std::ofstream(path, std::ios::binary) << content;
+  }
+
+  int64_t count() {
+    return cnx[0].execute("SELECT count(*) FROM test_copy").as<int64_t>(0);
+  }
+};
+
+TEST(copy, csv) {
+
+  Copy test;
+  std::string content = "id,label\n";
+  for (int i = 1; i <= 10000; i++) {
+    content += std::to_string(i) + ",\"label\n\"\"" + std::to_string(i) + "\"\"\"\n";
+  }
+  test.write(content);
+
+  CopyLoader loader(test.connections);
+  EXPECT_EQ(10000, loader.header(true).chunkSize(4096).load(test.path.c_str(), "test_copy"));
+  EXPECT_TRUE(loader.errors().empty());
+  EXPECT_EQ(3, loader.committed().size());
+  EXPECT_EQ(10000, test.count());
+  EXPECT_EQ(50005000, test.cnx[0].execute("SELECT sum(id) FROM test_copy").as<int64_t>(0));
+  EXPECT_EQ("label\n\"42\"", test.cnx[0].execute("SELECT label FROM test_copy WHERE id = 42").as<std::string>(0));
+
+}
+
+TEST(copy, text) {
+
+  Copy test;
+  std::string content;
+  for (int i = 1; i <= 10000; i++) {
+    content += "label\\\n" + std::to_string(i) + "|" + std::to_string(i) + "\n";
+  }
+  test.write(content);
+
+  CopyLoader loader(test.connections);
+  loader.format(CopyLoader::FileFormat::TEXT).delimiter('|').chunkSize(4096);
+  EXPECT_EQ(10000, loader.load(test.path.c_str(), "test_copy", "label, id"));
+  EXPECT_EQ(10000, test.count());
+  EXPECT_EQ("label\n42", test.cnx[0].execute("SELECT label FROM test_copy WHERE id = 42").as<std::string>(0));
+
+}
+
+TEST(copy, rejects) {
+
+  Copy test;
+  test.write("1,one\n2\n3,three\n4,four,4\n5,five\n");
+
+  CopyLoader loader(test.connections);
+  EXPECT_EQ(3, loader.rejects(2).load(test.path.c_str(), "test_copy"));
+  ASSERT_EQ(2, loader.errors().size());
+  EXPECT_EQ(6, loader.errors()[0].offset);
+  EXPECT_EQ(16, loader.errors()[1].offset);
+  EXPECT_EQ(3, test.count());
+
+  // Too many records rejected: nothing is loaded.
+  test.cnx[0].execute("TRUNCATE test_copy");
+  EXPECT_THROW(loader.rejects(1).load(test.path.c_str(), "test_copy"), ExecutionException);
+  EXPECT_EQ(0, test.count());
+
+}
+
+TEST(copy, error) {
+
+  Copy test;
+  std::string content;
+  for (int i = 1; i <= 10000; i++) {
+    content += (i == 5000 ? std::string("five thousand") : std::to_string(i)) + ",label\n";
+  }
+  test.write(content);
+
+  // A row rejected by the server: nothing is loaded.
+  CopyLoader loader(test.connections);
+  EXPECT_THROW(loader.chunkSize(4096).load(test.path.c_str(), "test_copy"), ExecutionException);
+  EXPECT_FALSE(loader.errors().empty());
+  EXPECT_TRUE(loader.committed().empty());
+  EXPECT_EQ(0, test.count());
+  EXPECT_THROW(loader.load("/nonexistent/file.csv", "test_copy"), ExecutionException);
+
+  // No transaction left in progress.
+  for (auto &c: test.cnx) {
+    EXPECT_EQ(42, c.execute("SELECT 42").as<int32_t>(0));
+    c.begin();
+    c.commit();
+  }
+
+}
+
+TEST(copy, two_phase) {
+
+  Copy test;
+  if (test.cnx[0].execute("SELECT current_setting('max_prepared_transactions')::int").as<int32_t>(0) < 3) {
+    return; // prepared transactions disabled on the test server.
+  }
+  std::string content;
+  for (int i = 1; i <= 10000; i++) {
+    content += std::to_string(i) + ",label\n";
+  }
+  test.write(content);
+
+  CopyLoader loader(test.connections);
+  EXPECT_EQ(10000, loader.twoPhase(true).chunkSize(4096).load(test.path.c_str(), "test_copy"));
+  EXPECT_EQ(3, loader.committed().size());
+  EXPECT_EQ(10000, test.count());
+  EXPECT_EQ(0, test.cnx[0].execute("SELECT count(*) FROM pg_prepared_xacts WHERE gid LIKE 'libpqmxx_copy_%'").as<int64_t>(0));
+
+}
@@ -0,0 +1,159 @@
+/**
+ * Copyright (c) 2016 Philippe FERDINAND
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ **/
+#include "gtest/gtest.h"
+#include "postgres-connection.h"
+#include "postgres-decoder.h"
+#include "postgres-exceptions.h"
+
+#include <atomic>
+#include <chrono>
+#include <stdexcept>
+#include <thread>
+
+using namespace db::postgres;
+
+TEST(workers, submit) {
+
+  std::atomic<int> actual(0);
+  {
+    WorkerPool pool(4);
+    for (int i = 1; i <= 1000; i++) {
+      pool.submit([&actual, i]() { actual += i; });
+    }
+  }
+
+  EXPECT_EQ(500500, actual);
+
+}
+
+TEST(workers, nested_submit) {
+
+  std::atomic<int> actual(0);
+  {
+    WorkerPool pool(4);
+    for (int i = 0; i < 100; i++) {
+      pool.submit([&pool, &actual]() {
+        for (int j = 0; j < 10; j++) {
+          pool.submit([&actual]() { actual++; });
+        }
+      });
+    }
+  }
+
+  EXPECT_EQ(1000, actual);
+
+}
+
+TEST(decoder, ordered) {
+
+  Connection cnx;
+  cnx.connect();
+
+  WorkerPool pool(4);
+  ParallelDecoder<int64_t> decoder(pool, [](const Row &row) {
+    return int64_t(row.as<int32_t>(0)) * 2;
+  }, true, 100);
+
+  int64_t expected = 2;
+  decoder.run(cnx.execute("SELECT generate_series(1, 10000)"), [&expected](std::vector<int64_t> &values) {
+    for (auto value: values) {
+      EXPECT_EQ(expected, value);
+      expected += 2;
+    }
+  });
+
+  EXPECT_EQ(20002, expected);
+
+}
+
+TEST(decoder, bounded) {
+
+  Connection cnx;
+  cnx.connect();
+
+  // While the first chunk is slow, the next ones decoded are not delivered
+  // and no more than 2 chunks per worker are detached.
+  WorkerPool pool(4);
+  std::atomic<int> decoded(0);
+  int seen = 0;
+  ParallelDecoder<int32_t> decoder(pool, [&decoded, &seen](const Row &row) {
+    int32_t value = row.as<int32_t>(0);
+    if (value == 1) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(200));
+      seen = decoded;
+    }
+    decoded++;
+    return value;
+  }, true, 10);
+
+  int32_t expected = 1;
+  decoder.run(cnx.execute("SELECT generate_series(1, 1000)"), [&expected](std::vector<int32_t> &values) {
+    for (auto value: values) {
+      EXPECT_EQ(expected++, value);
+    }
+  });
+
+  EXPECT_EQ(1001, expected);
+  EXPECT_LE(seen, 2 * 4 * 10);
+
+}
+
+TEST(decoder, unordered) {
+
+  Connection cnx;
+  cnx.connect();
+
+  WorkerPool pool(4);
+  ParallelDecoder<int32_t> decoder(pool, [](const Row &row) {
+    return row.as<int32_t>(0);
+  }, false, 64);
+
+  int64_t actual = 0;
+  decoder.run(cnx.execute("SELECT generate_series(1, 10000)"), [&actual](std::vector<int32_t> &values) {
+    for (auto value: values) {
+      actual += value;
+    }
+  });
+
+  EXPECT_EQ(50005000, actual);
+
+}
+
+TEST(decoder, error) {
+
+  Connection cnx;
+  cnx.connect();
+
+  WorkerPool pool(2);
+  ParallelDecoder<int32_t> decoder(pool, [](const Row &row) -> int32_t {
+    if (row.num() == 500) {
+      throw std::runtime_error("decoding error");
+    }
+    return row.as<int32_t>(0);
+  }, true, 10);
+
+  EXPECT_THROW(decoder.run(cnx.execute("SELECT generate_series(1, 1000)"), [](std::vector<int32_t> &) {}),
+               std::runtime_error);
+
+  EXPECT_EQ(42, cnx.execute("SELECT 42").as<int32_t>(0));
+
+}
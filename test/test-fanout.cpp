@@ -0,0 +1,127 @@
+/**
+ * Copyright (c) 2016 Philippe FERDINAND
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ **/
+#include "gtest/gtest.h"
+#include "postgres-fanout.h"
+#include "postgres-exceptions.h"
+
+using namespace db::postgres;
+
+TEST(fanout, arrival) {
+
+  Connection cnx[3];
+  for (auto &c: cnx) {
+    c.connect();
+  }
+
+  // Rows of the slow server come last.
+  FanOut fanout;
+  fanout.execute(cnx[0], "SELECT x FROM generate_series(1, 10) AS x, pg_sleep(0.2)");
+  fanout.execute(cnx[1], "SELECT generate_series(11, 20)");
+  fanout.execute(cnx[2], "SELECT generate_series(21, 30)");
+
+  int32_t actual = 0;
+  int count = 0;
+  while (const Row *row = fanout.next()) {
+    actual += row->as<int32_t>(0);
+    if (count < 20) {
+      EXPECT_NE(0, fanout.source());
+    }
+    count++;
+  }
+  EXPECT_EQ(30, count);
+  EXPECT_EQ(465, actual);
+  EXPECT_EQ(nullptr, fanout.next());
+
+}
+
+TEST(fanout, ordered) {
+
+  Connection cnx[3];
+  for (auto &c: cnx) {
+    c.connect();
+  }
+
+  // Partitions of the same query, merged by key.
+  FanOut fanout;
+  fanout.orderBy(FanOut::ascending<int32_t>(0));
+  for (int32_t i = 0; i < 3; i++) {
+    fanout.execute(cnx[i], "SELECT x FROM generate_series(1, 30) AS x WHERE x % 3 = $1 ORDER BY x", i);
+  }
+
+  int32_t expected = 1;
+  while (const Row *row = fanout.next()) {
+    EXPECT_EQ(expected, row->as<int32_t>(0));
+    EXPECT_EQ(expected % 3, fanout.source());
+    expected++;
+  }
+  EXPECT_EQ(31, expected);
+
+}
+
+TEST(fanout, limit) {
+
+  Connection cnx[2];
+  for (auto &c: cnx) {
+    c.connect();
+  }
+
+  {
+    FanOut fanout;
+    fanout.orderBy(FanOut::descending<int32_t>(0)).limit(5);
+    fanout.execute(cnx[0], "SELECT generate_series(1000000, 1, -2)");
+    fanout.execute(cnx[1], "SELECT generate_series(999999, 1, -2)");
+
+    int32_t expected = 1000000;
+    int count = 0;
+    while (const Row *row = fanout.next()) {
+      EXPECT_EQ(expected--, row->as<int32_t>(0));
+      count++;
+    }
+    EXPECT_EQ(5, count);
+  }
+
+  // The connections are usable once the queries in progress are cancelled.
+  for (auto &c: cnx) {
+    EXPECT_EQ(42, c.execute("SELECT 42").as<int32_t>(0));
+  }
+
+}
+
+TEST(fanout, error) {
+
+  Connection cnx[2];
+  for (auto &c: cnx) {
+    c.connect();
+  }
+
+  {
+    FanOut fanout;
+    fanout.execute(cnx[0], "SELECT generate_series(1, 3)");
+    fanout.execute(cnx[1], "SELECT 1/0");
+    EXPECT_THROW({ while (fanout.next()) {} }, ExecutionException);
+  }
+
+  for (auto &c: cnx) {
+    EXPECT_EQ(42, c.execute("SELECT 42").as<int32_t>(0));
+  }
+
+}
@@ -0,0 +1,123 @@
+/**
+ * Copyright (c) 2016 Philippe FERDINAND
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ **/
+#include "gtest/gtest.h"
+#include "postgres-multiplexer.h"
+#include "postgres-exceptions.h"
+
+#include <atomic>
+#include <thread>
+
+using namespace db::postgres;
+
+// A geometric point, sent as two double precision values.
+struct mux_point_t {
+  double x;
+  double y;
+};
+
+TEST(multiplexer, threads) {
+
+  auto cnx = std::make_shared<Connection>();
+  cnx->connect();
+
+  {
+    Multiplexer mux(cnx, 16);
+    std::atomic<int64_t> actual(0);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 8; t++) {
+      threads.emplace_back([&mux, &actual]() {
+        std::vector<std::future<ResultSet>> futures;
+        for (int32_t i = 1; i <= 100; i++) {
+          futures.push_back(mux.execute("SELECT $1::int4 * 2", i));
+        }
+        for (int32_t i = 1; i <= 100; i++) {
+          ResultSet rows = futures[i - 1].get();
+          EXPECT_EQ(1, rows.size());
+          int32_t value = (*rows.begin()).as<int32_t>(0);
+          EXPECT_EQ(i * 2, value);
+          actual += value;
+        }
+      });
+    }
+    for (auto &thread: threads) {
+      thread.join();
+    }
+    EXPECT_EQ(8 * 10100, actual);
+  }
+
+  // The connection is usable again once the multiplexer is gone.
+  EXPECT_EQ(42, cnx->execute("SELECT 42").as<int32_t>(0));
+
+}
+
+TEST(multiplexer, error) {
+
+  auto cnx = std::make_shared<Connection>();
+  cnx->connect();
+  Multiplexer mux(cnx);
+
+  // The failure of a query does not affect the others.
+  auto before = mux.execute("SELECT generate_series(1, 3)");
+  auto failed = mux.execute("SELECT 1/0");
+  auto after = mux.execute("SELECT 'after'::text");
+
+  EXPECT_EQ(3, before.get().size());
+  EXPECT_THROW(failed.get(), ExecutionException);
+  EXPECT_EQ("after", (*after.get().begin()).as<std::string>(0));
+
+}
+
+TEST(multiplexer, registered_type) {
+
+  auto cnx = std::make_shared<Connection>();
+  cnx->connect();
+
+  // Registered once the connection is open: resolved by the multiplexer.
+  static bool registered = false;
+  if (!registered) {
+    registered = true;
+    TypeRegistry::add<mux_point_t>("point",
+      [](const mux_point_t &) { return 2 * sizeof(double); },
+      [](const mux_point_t &p, char *buf) { return write(p.y, write(p.x, buf)); },
+      [](char *buf, size_t) {
+        mux_point_t p;
+        p.x = read<double>(&buf);
+        p.y = read<double>(&buf);
+        return p;
+      });
+  }
+
+  Multiplexer mux(cnx);
+  std::vector<std::future<ResultSet>> futures;
+  for (int i = 0; i < 100; i++) {
+    futures.push_back(mux.execute("SELECT $1, $2::int4", mux_point_t { double(i), 4. }, i));
+  }
+  for (int i = 0; i < 100; i++) {
+    ResultSet rows = futures[i].get();
+    ASSERT_EQ(1, rows.size());
+    mux_point_t p = (*rows.begin()).as<mux_point_t>(0);
+    EXPECT_EQ(double(i), p.x);
+    EXPECT_EQ(4., p.y);
+    EXPECT_EQ(i, (*rows.begin()).as<int32_t>(1));
+  }
+
+}
@@ -184,3 +184,314 @@ TEST(param_sync, multi) {
 
 }
 
+
+TEST(param_sync, compact_array) {
+
+  compact_array<int32_t> array;
+  array.push_back(1);
+  EXPECT_FALSE(array.hasNulls());
+  array.push_back(nullptr);
+  for (int32_t i = 0; i < 20; i++) {
+    array.push_back(i);
+  }
+  EXPECT_TRUE(array.hasNulls());
+  EXPECT_EQ(22, array.size());
+  EXPECT_FALSE(array.isNull(0));
+  EXPECT_TRUE(array.isNull(1));
+  EXPECT_FALSE(array.isNull(21));
+
+  array.clear();
+  EXPECT_FALSE(array.hasNulls());
+  EXPECT_EQ(0, array.size());
+
+}
+
+TEST(param_sync, compact_array_types) {
+
+  Connection cnx;
+  cnx.connect();
+
+  {
+    compact_array<double> expected;
+    expected.push_back(877.198);
+    expected.push_back(nullptr);
+    expected.push_back(-2300.8008);
+
+    compact_array<double> actual;
+    cnx.execute("SELECT $1", expected).asArray(0, actual);
+    EXPECT_EQ(3, actual.size());
+    EXPECT_TRUE(actual.hasNulls());
+    EXPECT_DOUBLE_EQ(877.198, actual.values[0]);
+    EXPECT_TRUE(actual.isNull(1));
+    EXPECT_DOUBLE_EQ(-2300.8008, actual.values[2]);
+  }
+
+  {
+    compact_array<int64_t> expected;
+    for (int64_t i = 0; i < 100; i++) {
+      expected.push_back(i * 7000000000);
+    }
+
+    compact_array<int64_t> actual;
+    cnx.execute("SELECT $1", expected).asArray(0, actual);
+    EXPECT_FALSE(actual.hasNulls());
+    EXPECT_TRUE(expected.values == actual.values);
+  }
+
+  {
+    compact_array<bool> expected;
+    expected.push_back(true);
+    expected.push_back(nullptr);
+    expected.push_back(false);
+
+    compact_array<bool> actual;
+    cnx.execute("SELECT $1", expected).asArray(0, actual);
+    EXPECT_TRUE(expected.values == actual.values);
+    EXPECT_TRUE(actual.isNull(1));
+    const uint8_t *values = actual.values.data();
+    EXPECT_EQ(1, values[0]);
+    EXPECT_EQ(0, values[2]);
+  }
+
+  {
+    // No dimension for an empty array, as for the server.
+    compact_array<int32_t> empty;
+    EXPECT_EQ(0, empty.ndim());
+    auto &result = cnx.execute("SELECT array_ndims($1), $1 = '{}'::int4[]", empty);
+    EXPECT_TRUE(result.isNull(0));
+    EXPECT_TRUE(result.as<bool>(1));
+  }
+
+  {
+    compact_array<float> actual;
+    actual.push_back(1.f);
+    cnx.execute("SELECT '{}'::real[]").asArray(0, actual);
+    EXPECT_EQ(0, actual.size());
+
+    cnx.execute("SELECT NULL::real[]").asArray(0, actual);
+    EXPECT_EQ(0, actual.size());
+  }
+
+}
+
+TEST(param_sync, multi_dimensional_array) {
+
+  Connection cnx;
+  cnx.connect();
+
+  {
+    compact_array<double> actual;
+    cnx.execute("SELECT '{{1,2,3},{4,NULL,6}}'::float8[][]").asArray(0, actual);
+    EXPECT_EQ(2, actual.ndim());
+    EXPECT_EQ(2, actual.dims[0]);
+    EXPECT_EQ(3, actual.dims[1]);
+    EXPECT_EQ(6, actual.size());
+    EXPECT_DOUBLE_EQ(6., actual.values[5]);
+    EXPECT_TRUE(actual.isNull(4));
+  }
+
+  {
+    compact_array<float> expected;
+    expected.dims = { 2, 2 };
+    for (int i = 0; i < 4; i++) {
+      expected.push_back(float(i));
+    }
+
+    EXPECT_EQ(2, cnx.execute("SELECT array_ndims($1)", expected).as<int32_t>(0));
+    EXPECT_FLOAT_EQ(2.f, cnx.execute("SELECT ($1)[2][1]", expected).as<float>(0));
+
+    compact_array<float> actual;
+    cnx.execute("SELECT $1", expected).asArray(0, actual);
+    EXPECT_TRUE(expected.dims == actual.dims);
+    EXPECT_TRUE(expected.values == actual.values);
+  }
+
+  {
+    auto actual = cnx.execute("SELECT '{{1,2},{3,4}}'::int[][]").asArray<int32_t>(0);
+    EXPECT_EQ(4, actual.size());
+    EXPECT_EQ(4, actual[3].value);
+  }
+
+}
+
+TEST(param_sync, string_array) {
+
+  Connection cnx;
+  cnx.connect();
+
+  string_array expected;
+  expected.push_back("hello");
+  expected.push_back(nullptr);
+  expected.push_back(u8"メインページ");
+
+  string_array actual;
+  cnx.execute("SELECT $1", expected).asArray(0, actual);
+  EXPECT_EQ(3, actual.size());
+  EXPECT_STREQ("hello", actual.str(0).c_str());
+  EXPECT_TRUE(actual.isNull(1));
+  EXPECT_STREQ(u8"メインページ", actual.str(2).c_str());
+  EXPECT_TRUE(expected.data == actual.data);
+  EXPECT_TRUE(expected.offsets == actual.offsets);
+
+  cnx.execute("SELECT ARRAY['a', 'bc']::text[]").asArray(0, actual);
+  EXPECT_EQ(2, actual.size());
+  EXPECT_FALSE(actual.hasNulls());
+  EXPECT_EQ(2, actual.length(1));
+
+}
+
+TEST(param_sync, numeric) {
+
+  Connection cnx;
+  cnx.connect();
+
+  numeric_t price = cnx.execute("SELECT 12345.678::numeric").as<numeric_t>(0);
+  EXPECT_TRUE(price.isFixed());
+  EXPECT_EQ(12345678, int64_t(price.unscaled));
+  EXPECT_EQ(3, price.scale);
+  EXPECT_STREQ("12345.678", price.str().c_str());
+
+  EXPECT_STREQ("-0.05", cnx.execute("SELECT -0.05::numeric").as<numeric_t>(0).str().c_str());
+  EXPECT_TRUE(cnx.execute("SELECT 'NaN'::numeric").as<numeric_t>(0).isNaN());
+
+  numeric_t big = cnx.execute("SELECT 10::numeric ^ 60").as<numeric_t>(0);
+  EXPECT_FALSE(big.isFixed());
+  EXPECT_STREQ(cnx.execute("SELECT (10::numeric ^ 60)::text").as<std::string>(0).c_str(), big.str().c_str());
+  EXPECT_TRUE(cnx.execute("SELECT $1 = 10::numeric ^ 60", big).as<bool>(0));
+
+  // A scale too large for the fixed-point form.
+  numeric_t tiny = cnx.execute("SELECT '1e-50'::numeric(60, 50)").as<numeric_t>(0);
+  EXPECT_FALSE(tiny.isFixed());
+  EXPECT_DOUBLE_EQ(1e-50, tiny.toDouble());
+  EXPECT_STREQ(cnx.execute("SELECT '1e-50'::numeric(60, 50)::text").as<std::string>(0).c_str(), tiny.str().c_str());
+  EXPECT_TRUE(cnx.execute("SELECT $1 = 1e-50", tiny).as<bool>(0));
+  EXPECT_STREQ("-0.0000000000000000000000000000000000000000000000000003",
+               cnx.execute("SELECT $1::text", numeric_t(-3, 52)).as<std::string>(0).c_str());
+  EXPECT_DOUBLE_EQ(-3e-52, numeric_t(-3, 52).toDouble());
+
+  EXPECT_STREQ("19.99", cnx.execute("SELECT $1::text", numeric_t(1999, 2)).as<std::string>(0).c_str());
+  EXPECT_STREQ("-0.00001", cnx.execute("SELECT $1::text", numeric_t(-1, 5)).as<std::string>(0).c_str());
+
+  array_numeric_t expected({numeric_t(1999, 2), nullptr, numeric_t(-42)});
+  auto actual = cnx.execute("SELECT $1", expected).asArray<numeric_t>(0);
+  EXPECT_EQ(3, actual.size());
+  EXPECT_STREQ("19.99", actual[0].value.str().c_str());
+  EXPECT_TRUE(actual[1].isNull);
+  EXPECT_STREQ("-42", actual[2].value.str().c_str());
+
+}
+
+TEST(param_sync, network_and_json_types) {
+
+  Connection cnx;
+  cnx.connect();
+
+  uuid_t uuid = cnx.execute("SELECT 'a0eebc99-9c0b-4ef8-bb6d-6bb9bd380a11'::uuid").as<uuid_t>(0);
+  EXPECT_STREQ("a0eebc99-9c0b-4ef8-bb6d-6bb9bd380a11", uuid.str().c_str());
+  EXPECT_TRUE(uuid == cnx.execute("SELECT $1", uuid).as<uuid_t>(0));
+
+  macaddr_t mac = cnx.execute("SELECT '08:00:2b:01:02:03'::macaddr").as<macaddr_t>(0);
+  EXPECT_EQ(0x08, mac.bytes[0]);
+  EXPECT_EQ(0x03, mac.bytes[5]);
+  EXPECT_STREQ("08:00:2b:01:02:03", cnx.execute("SELECT $1::text", mac).as<std::string>(0).c_str());
+
+  inet_t inet = cnx.execute("SELECT '192.168.1.5/24'::inet").as<inet_t>(0);
+  EXPECT_EQ(inet_t::INET, inet.family);
+  EXPECT_EQ(24, inet.bits);
+  EXPECT_FALSE(inet.cidr);
+  EXPECT_EQ(5, inet.bytes[3]);
+  EXPECT_STREQ("192.168.1.5/24", cnx.execute("SELECT $1::text", inet).as<std::string>(0).c_str());
+
+  inet_t cidr = cnx.execute("SELECT '2001:db8::/32'::cidr").as<inet_t>(0);
+  EXPECT_EQ(inet_t::INET6, cidr.family);
+  EXPECT_TRUE(cidr.cidr);
+  EXPECT_STREQ("2001:db8::/32", cnx.execute("SELECT $1::text", cidr).as<std::string>(0).c_str());
+
+  EXPECT_STREQ("{\"a\": 1}", cnx.execute("SELECT '{\"a\":1}'::jsonb").as<jsonb_t>(0).str().c_str());
+  EXPECT_STREQ("{\"a\":1}", cnx.execute("SELECT '{\"a\":1}'::json").as<json_t>(0).str().c_str());
+  EXPECT_EQ(2, cnx.execute("SELECT ($1->>'b')::int", jsonb_t { "{\"b\":2}", 7 }).as<int32_t>(0));
+  EXPECT_EQ(3, cnx.execute("SELECT ($1->>'c')::int", json_t { "{\"c\":3}", 7 }).as<int32_t>(0));
+
+  array_jsonb_t documents({jsonb_t { "[1]", 3 }, nullptr});
+  auto actual = cnx.execute("SELECT $1", documents).asArray<jsonb_t>(0);
+  EXPECT_EQ(2, actual.size());
+  EXPECT_STREQ("[1]", actual[0].value.str().c_str());
+  EXPECT_TRUE(actual[1].isNull);
+
+  array_uuid_t uuids({uuid, nullptr});
+  auto actualUuids = cnx.execute("SELECT $1", uuids).asArray<uuid_t>(0);
+  EXPECT_TRUE(actualUuids == uuids);
+
+}
+
+TEST(param_sync, range_types) {
+
+  Connection cnx;
+  cnx.connect();
+
+  int4range_t r = cnx.execute("SELECT '[1,10]'::int4range").as<int4range_t>(0);
+  EXPECT_EQ(1, r.lower);
+  EXPECT_EQ(11, r.upper); // canonical form [1,11)
+  EXPECT_TRUE(r.lowerInc());
+  EXPECT_FALSE(r.upperInc());
+  EXPECT_STREQ("[1,11)", cnx.execute("SELECT $1::text", r).as<std::string>(0).c_str());
+
+  int8range_t unbounded(5, 0, int8range_t::LB_INC | int8range_t::UB_INF);
+  EXPECT_STREQ("[5,)", cnx.execute("SELECT $1::text", unbounded).as<std::string>(0).c_str());
+  EXPECT_TRUE(cnx.execute("SELECT 'empty'::int4range").as<int4range_t>(0).empty());
+
+  numrange_t num = cnx.execute("SELECT numrange(1.5, 2.25, '(]')").as<numrange_t>(0);
+  EXPECT_STREQ("1.5", num.lower.str().c_str());
+  EXPECT_TRUE(num.upperInc());
+  EXPECT_STREQ("(1.5,2.25]", cnx.execute("SELECT $1::text", num).as<std::string>(0).c_str());
+
+  tstzrange_t slot(timestamptz_t { 0 }, timestamptz_t { 3600000000 });
+  EXPECT_TRUE(cnx.execute("SELECT $1 @> '1970-01-01 00:30:00+00'::timestamptz", slot).as<bool>(0));
+  EXPECT_TRUE(slot == cnx.execute("SELECT $1", slot).as<tstzrange_t>(0));
+
+  array_daterange_t dates({daterange_t(date_t { 0 }, date_t { 86400 }), nullptr});
+  auto actual = cnx.execute("SELECT $1", dates).asArray<daterange_t>(0);
+  EXPECT_TRUE(actual == dates);
+
+  if (cnx.execute("SELECT current_setting('server_version_num')::int >= 140000").as<bool>(0)) {
+    int4multirange_t ranges = cnx.execute("SELECT '{[1,3), [5,)}'::int4multirange").as<int4multirange_t>(0);
+    ASSERT_EQ(2, ranges.size());
+    EXPECT_TRUE(ranges[1].upperInf());
+    EXPECT_STREQ("{[1,3),[5,)}", cnx.execute("SELECT $1::text", ranges).as<std::string>(0).c_str());
+  }
+
+}
+
+TEST(param_sync, chrono_types) {
+
+  using namespace std::chrono;
+
+  Connection cnx;
+  cnx.connect();
+  cnx.execute("SET TIME ZONE 'UTC'");
+
+  typedef time_point<system_clock, microseconds> sys_us;
+  typedef time_point<system_clock, seconds> sys_s;
+
+  sys_us t = sys_us(microseconds(1478000000123456));
+  EXPECT_STREQ("2016-11-01 11:33:20.123456+00", cnx.execute("SELECT $1::text", t).as<std::string>(0).c_str());
+  EXPECT_TRUE(t == cnx.execute("SELECT $1", t).as<sys_us>(0));
+  EXPECT_EQ(1478000000, cnx.execute("SELECT $1", t).as<sys_s>(0).time_since_epoch().count());
+
+  EXPECT_STREQ("01:30:00", cnx.execute("SELECT $1::text", minutes(90)).as<std::string>(0).c_str());
+  EXPECT_EQ(86400 + 3600, cnx.execute("SELECT interval '1 day 1 hour'").as<seconds>(0).count());
+  EXPECT_EQ(3600000, cnx.execute("SELECT time '01:00:00'").as<milliseconds>(0).count());
+
+#if LIBPQMXX_HAS_OPTIONAL
+  auto &result = cnx.execute("SELECT $1, $2", std::optional<int32_t>(), std::optional<int32_t>(7));
+  EXPECT_FALSE(result.as<std::optional<int32_t>>(0).has_value());
+  EXPECT_EQ(7, *result.as<std::optional<int32_t>>(1));
+#endif
+
+#if LIBPQMXX_HAS_CALENDAR
+  year_month_day d { year(2050), month(3), day(14) };
+  EXPECT_STREQ("2050-03-14", cnx.execute("SELECT $1::text", d).as<std::string>(0).c_str());
+  EXPECT_TRUE(d == cnx.execute("SELECT $1", d).as<year_month_day>(0));
+#endif
+
+}
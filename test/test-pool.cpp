@@ -0,0 +1,71 @@
+/**
+ * Copyright (c) 2016 Philippe FERDINAND
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ **/
+#include "gtest/gtest.h"
+#include "postgres-pool.h"
+
+#include <atomic>
+#include <thread>
+
+using namespace db::postgres;
+
+TEST(pool, acquire) {
+
+  ConnectionPool pool(4, nullptr, Settings(), 2);
+  EXPECT_EQ(4, pool.size());
+  EXPECT_EQ(2, pool.shards());
+
+  // More threads than connections.
+  std::atomic<int64_t> actual(0);
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 8; t++) {
+    threads.emplace_back([&pool, &actual]() {
+      for (int32_t i = 1; i <= 50; i++) {
+        auto cnx = pool.acquire();
+        actual += cnx->execute("SELECT $1", i).as<int32_t>(0);
+      }
+    });
+  }
+  for (auto &thread: threads) {
+    thread.join();
+  }
+  EXPECT_EQ(8 * 1275, actual);
+
+}
+
+TEST(pool, try_acquire) {
+
+  ConnectionPool pool(2);
+
+  auto first = pool.acquire();
+  auto second = pool.tryAcquire();
+  ASSERT_TRUE(second);
+  EXPECT_NE(first.get(), second.get());
+
+  // All the connections are in use.
+  EXPECT_FALSE(pool.tryAcquire());
+
+  second.release();
+  auto third = pool.tryAcquire();
+  ASSERT_TRUE(third);
+  EXPECT_EQ(42, third->execute("SELECT 42").as<int32_t>(0));
+
+}
@@ -0,0 +1,195 @@
+/**
+ * Copyright (c) 2016 Philippe FERDINAND
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ **/
+#include "gtest/gtest.h"
+#include "postgres-reactor.h"
+#include "postgres-exceptions.h"
+
+#include <thread>
+
+using namespace db::postgres;
+
+TEST(reactor, queries) {
+
+  Reactor reactor;
+  for (int i = 0; i < 4; i++) {
+    auto cnx = std::make_shared<Connection>();
+    cnx->connect();
+    reactor.add(cnx);
+  }
+
+  // More queries than connections: some of them are queued.
+  int32_t actual = 0;
+  int completed = 0;
+  for (int32_t i = 1; i <= 20; i++) {
+    reactor.execute([&](ResultSet &rows, std::exception_ptr error) {
+      EXPECT_FALSE(error);
+      for (auto &row: rows) {
+        actual += row.as<int32_t>(0);
+      }
+      completed++;
+    }, "SELECT $1 FROM pg_sleep(0.01)", i);
+  }
+
+  EXPECT_EQ(20, reactor.pending());
+  reactor.run();
+  EXPECT_EQ(0, reactor.pending());
+  EXPECT_EQ(20, completed);
+  EXPECT_EQ(210, actual);
+
+}
+
+TEST(reactor, chained) {
+
+  auto cnx = std::make_shared<Connection>();
+  cnx->connect();
+
+  int64_t actual = 0;
+  {
+    Reactor reactor;
+    reactor.add(cnx);
+
+    // Queries executed from a callback.
+    reactor.execute([&](ResultSet &rows, std::exception_ptr error) {
+      EXPECT_FALSE(error);
+      int32_t count = (*rows.begin()).as<int32_t>(0);
+      reactor.execute([&](ResultSet &rows, std::exception_ptr error) {
+        EXPECT_FALSE(error);
+        for (auto &row: rows) {
+          actual += row.as<int32_t>(0);
+        }
+      }, "SELECT generate_series(1, $1)", count);
+    }, "SELECT 100");
+
+    reactor.run();
+  }
+  EXPECT_EQ(5050, actual);
+
+  // The connection is back to the blocking mode once the reactor is gone.
+  EXPECT_EQ(42, cnx->execute("SELECT 42").as<int32_t>(0));
+
+}
+
+TEST(reactor, error) {
+
+  Reactor reactor;
+  auto cnx = std::make_shared<Connection>();
+  cnx->connect();
+  reactor.add(cnx);
+
+  bool failed = false;
+  int32_t actual = 0;
+  reactor.execute([&](ResultSet &rows, std::exception_ptr error) {
+    EXPECT_EQ(0, rows.size());
+    ASSERT_TRUE(error);
+    try {
+      std::rethrow_exception(error);
+    }
+    catch (ExecutionException &) {
+      failed = true;
+    }
+  }, "SELECT * FROM unknown_table");
+
+  // The connection remains usable after an error.
+  reactor.execute([&](ResultSet &rows, std::exception_ptr error) {
+    EXPECT_FALSE(error);
+    actual = (*rows.begin()).as<int32_t>(0);
+  }, "SELECT 42");
+
+  reactor.run();
+  EXPECT_TRUE(failed);
+  EXPECT_EQ(42, actual);
+
+}
+
+TEST(reactor, backends) {
+
+  Reactor::Backend backends[] = { Reactor::Backend::EPOLL, Reactor::Backend::AUTO };
+  for (auto backend: backends) {
+    Reactor reactor(backend);
+    EXPECT_NE(Reactor::Backend::AUTO, reactor.backend());
+    for (int i = 0; i < 2; i++) {
+      auto cnx = std::make_shared<Connection>();
+      cnx->connect();
+      reactor.add(cnx);
+    }
+
+    // Queries executed on behalf of another thread.
+    int64_t actual = 0;
+    std::thread producer([&]() {
+      for (int32_t i = 1; i <= 10; i++) {
+        reactor.post([&reactor, &actual, i]() {
+          reactor.execute([&actual](ResultSet &rows, std::exception_ptr error) {
+            EXPECT_FALSE(error);
+            actual += (*rows.begin()).as<int64_t>(0);
+          }, "SELECT sum(x) FROM generate_series(1, $1) AS x", i);
+        });
+      }
+    });
+
+    while (actual != 220) {
+      reactor.poll(1000);
+    }
+    producer.join();
+    reactor.run();
+    EXPECT_EQ(220, actual);
+  }
+
+}
+
+TEST(reactor, lost) {
+
+  Reactor::Backend backends[] = { Reactor::Backend::EPOLL, Reactor::Backend::AUTO };
+  for (auto backend: backends) {
+    Reactor reactor(backend);
+    std::vector<int32_t> pids;
+    for (int i = 0; i < 2; i++) {
+      auto cnx = std::make_shared<Connection>();
+      cnx->connect();
+      pids.push_back(cnx->execute("SELECT pg_backend_pid()").as<int32_t>(0));
+      reactor.add(cnx);
+    }
+
+    // The queries in progress and the queries waiting fail once all the
+    // connections are lost.
+    int failed = 0;
+    for (int i = 0; i < 6; i++) {
+      reactor.execute([&](ResultSet &, std::exception_ptr error) {
+        EXPECT_TRUE(error);
+        failed++;
+      }, "SELECT pg_sleep(10)");
+    }
+
+    std::thread killer([&]() {
+      Connection cnx;
+      cnx.connect();
+      std::this_thread::sleep_for(std::chrono::milliseconds(200));
+      for (int32_t pid: pids) {
+        cnx.execute("SELECT pg_terminate_backend($1)", pid);
+      }
+    });
+    reactor.run();
+    killer.join();
+    EXPECT_EQ(6, failed);
+    EXPECT_EQ(0, reactor.pending());
+  }
+
+}
@@ -0,0 +1,92 @@
+/**
+ * Copyright (c) 2016 Philippe FERDINAND
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ **/
+#include "gtest/gtest.h"
+#include "postgres-connection.h"
+#include "postgres-exceptions.h"
+#include "postgres-readahead.h"
+
+using namespace db::postgres;
+
+TEST(readahead, all_rows) {
+
+  Connection cnx;
+  cnx.connect();
+
+  int64_t actual = 0;
+  int chunks = 0;
+  {
+    ReadAhead rows(cnx.execute("SELECT generate_series(1, 10000)"), 128);
+    ResultSet chunk;
+    while (rows.next(chunk)) {
+      EXPECT_LE(chunk.size(), 128);
+      for (auto &row: chunk) {
+        actual += row.as<int32_t>(0);
+      }
+      chunks++;
+    }
+  }
+
+  EXPECT_EQ(50005000, actual);
+  EXPECT_EQ(79, chunks);
+
+  // The connection can be reused.
+  EXPECT_EQ(42, cnx.execute("SELECT 42").as<int32_t>(0));
+
+}
+
+TEST(readahead, no_row) {
+
+  Connection cnx;
+  cnx.connect();
+
+  ReadAhead rows(cnx.execute("SELECT 1 WHERE 1=2"));
+  ResultSet chunk;
+  EXPECT_FALSE(rows.next(chunk));
+
+}
+
+TEST(readahead, early_stop) {
+
+  Connection cnx;
+  cnx.connect();
+
+  {
+    ReadAhead rows(cnx.execute("SELECT generate_series(1, 100000)"), 100, 4);
+    ResultSet chunk;
+    EXPECT_TRUE(rows.next(chunk));
+    EXPECT_EQ(100, chunk.size());
+  }
+
+  EXPECT_EQ(42, cnx.execute("SELECT 42").as<int32_t>(0));
+
+}
+
+TEST(readahead, error) {
+
+  Connection cnx;
+  cnx.connect();
+
+  ReadAhead rows(cnx.execute("SELECT 1/(10 - generate_series(1, 20))"), 4);
+  ResultSet chunk;
+  EXPECT_THROW({ while (rows.next(chunk)); }, ExecutionException);
+
+}
@@ -0,0 +1,154 @@
+/**
+ * Copyright (c) 2016 Philippe FERDINAND
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ **/
+#include "gtest/gtest.h"
+#include "postgres-connection.h"
+#include "postgres-exceptions.h"
+
+#include <cstring>
+
+using namespace db::postgres;
+
+enum class mood { sad, ok, happy };
+
+static const char *moods[] = { "sad", "ok", "happy" };
+
+// A geometric point, sent as two double precision values.
+struct point_t {
+  double x;
+  double y;
+};
+
+// Not a type of the database.
+struct unknown_t {
+  int32_t value;
+};
+
+static void registerTypes() {
+  static bool registered = false;
+  if (registered) {
+    return;
+  }
+  registered = true;
+
+  TypeRegistry::add<mood>("test_mood",
+    [](const mood &m) { return strlen(moods[int(m)]); },
+    [](const mood &m, char *buf) {
+      size_t length = strlen(moods[int(m)]);
+      memcpy(buf, moods[int(m)], length);
+      return buf + length;
+    },
+    [](char *buf, size_t length) {
+      for (int i = 0; i < 3; i++) {
+        if (strlen(moods[i]) == length && strncmp(moods[i], buf, length) == 0) {
+          return mood(i);
+        }
+      }
+      return mood::ok;
+    });
+
+  TypeRegistry::add<point_t>("pg_catalog.point",
+    [](const point_t &) { return 2 * sizeof(double); },
+    [](const point_t &p, char *buf) {
+      return write(p.y, write(p.x, buf));
+    },
+    [](char *buf, size_t) {
+      point_t p;
+      p.x = read<double>(&buf);
+      p.y = read<double>(&buf);
+      return p;
+    });
+
+  TypeRegistry::add<unknown_t>("test_unknown_type",
+    [](const unknown_t &) { return sizeof(int32_t); },
+    [](const unknown_t &u, char *buf) { return write(u.value, buf); },
+    [](char *buf, size_t) { return unknown_t { read<int32_t>(&buf) }; });
+}
+
+TEST(registry, enum_type) {
+
+  registerTypes();
+
+  Connection cnx;
+  cnx.connect();
+  cnx.execute(R"SQL(
+    DROP TYPE IF EXISTS test_mood;
+    CREATE TYPE test_mood AS ENUM ('sad', 'ok', 'happy');
+  )SQL");
+  cnx.resolveTypes();
+
+  auto &result = cnx.execute("SELECT $1, $2::text, 'sad'::test_mood, NULL::test_mood", mood::happy, mood::ok);
+  EXPECT_EQ(mood::happy, result.as<mood>(0));
+  EXPECT_EQ("ok", result.as<std::string>(1));
+  EXPECT_EQ(mood::sad, result.as<mood>(2));
+  EXPECT_TRUE(result.isNull(3));
+
+  std::vector<array_item<mood>> moods { mood::sad, mood::happy, array_item<mood>() };
+  moods[2].isNull = true;
+  auto array = cnx.execute("SELECT $1", moods).asArray<mood>(0);
+  ASSERT_EQ(3, array.size());
+  EXPECT_EQ(mood::sad, array[0].value);
+  EXPECT_EQ(mood::happy, array[1].value);
+  EXPECT_TRUE(array[2].isNull);
+
+  array = cnx.execute("SELECT ARRAY[['ok', 'sad'], ['happy', NULL]]::test_mood[]").asArray<mood>(0);
+  ASSERT_EQ(4, array.size());
+  EXPECT_EQ(mood::ok, array[0].value);
+  EXPECT_EQ(mood::happy, array[2].value);
+  EXPECT_TRUE(array[3].isNull);
+
+  cnx.execute("DROP TYPE test_mood");
+
+}
+
+TEST(registry, schema_qualified_name) {
+
+  registerTypes();
+
+  Connection cnx;
+  cnx.connect();
+
+  point_t p = cnx.execute("SELECT $1 <-> point(0, 0), $1", point_t { 3., 4. }).as<point_t>(1);
+  EXPECT_EQ(3., p.x);
+  EXPECT_EQ(4., p.y);
+  EXPECT_EQ(5., cnx.execute("SELECT $1 <-> point(0, 0)", point_t { 3., 4. }).as<double>(0));
+
+}
+
+TEST(registry, unknown_type) {
+
+  registerTypes();
+
+  Connection cnx;
+  cnx.connect();
+
+  EXPECT_THROW(cnx.execute("SELECT $1", unknown_t { 1 }), ExecutionException);
+
+  // Values of another type.
+  EXPECT_THROW(cnx.execute("SELECT 'happy'::text").as<mood>(0), ExecutionException);
+  EXPECT_THROW(cnx.execute("SELECT ARRAY[point(1, 2)]").as<point_t>(0), ExecutionException);
+  EXPECT_THROW(cnx.execute("SELECT point(1, 2)").asArray<point_t>(0), ExecutionException);
+  EXPECT_EQ(2., cnx.execute("SELECT ARRAY[point(1, 2)]").asArray<point_t>(0)[0].value.y);
+
+  // The connection is still usable.
+  EXPECT_EQ(42, cnx.execute("SELECT 42").as<int32_t>(0));
+
+}
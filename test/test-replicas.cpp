@@ -0,0 +1,165 @@
+/**
+ * Copyright (c) 2016 Philippe FERDINAND
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ **/
+#include "gtest/gtest.h"
+#include "postgres-replicas.h"
+
+using namespace db::postgres;
+
+// The test server stands for both the primary and its replicas: not being a
+// standby, it is only considered up to date when standalone servers are
+// accepted. The replay positions of a standby are injected.
+
+struct InjectedRouter : ReplicaRouter {
+  InjectedRouter(std::shared_ptr<ConnectionPool> primary, std::shared_ptr<ConnectionPool> replica)
+    : ReplicaRouter(primary, { replica }), standby(true), position(0), queries(0) {
+  }
+
+  bool replayed(Connection &, lsn_t &lsn) override {
+    queries++;
+    lsn = position;
+    return standby;
+  }
+
+  bool standby;
+  lsn_t position;
+  int queries;
+};
+
+TEST(replicas, read_your_writes) {
+
+  auto primary = std::make_shared<ConnectionPool>(1);
+  auto replica = std::make_shared<ConnectionPool>(2);
+  ReplicaRouter router(primary, { replica }, ReplicaRouter::Policy::LEAST_LOADED, true);
+
+  router.write(nullptr, "DROP TABLE IF EXISTS test_replicas");
+  router.write(nullptr, "CREATE TABLE test_replicas (id INTEGER)");
+
+  lsn_t lsn = 0;
+  router.write(&lsn, "INSERT INTO test_replicas VALUES ($1)", 42);
+  EXPECT_GT(lsn, 0);
+
+  ResultSet rows = router.read(lsn, "SELECT id FROM test_replicas");
+  EXPECT_EQ(1, rows.size());
+  EXPECT_EQ(42, (*rows.begin()).as<int32_t>(0));
+
+  // Reads are not executed on the primary.
+  {
+    auto cnx = router.primary();
+    EXPECT_EQ(0, primary->idle());
+    EXPECT_EQ(1, router.read(lsn, "SELECT 1").size());
+  }
+
+  router.write(nullptr, "DROP TABLE test_replicas");
+
+}
+
+TEST(replicas, round_robin) {
+
+  auto primary = std::make_shared<ConnectionPool>(1);
+  auto first = std::make_shared<ConnectionPool>(1);
+  auto second = std::make_shared<ConnectionPool>(1);
+  ReplicaRouter router(primary, { first, second }, ReplicaRouter::Policy::ROUND_ROBIN);
+
+  auto a = router.replica();
+  auto b = router.replica();
+  EXPECT_EQ(0, first->idle());
+  EXPECT_EQ(0, second->idle());
+
+}
+
+TEST(replicas, no_replica) {
+
+  auto primary = std::make_shared<ConnectionPool>(1);
+  ReplicaRouter router(primary, {});
+
+  EXPECT_EQ(42, (*router.read(0, "SELECT 42").begin()).as<int32_t>(0));
+
+}
+
+TEST(replicas, catch_up) {
+
+  auto primary = std::make_shared<ConnectionPool>(1);
+  auto replica = std::make_shared<ConnectionPool>(1);
+  InjectedRouter router(primary, replica);
+  router.position = 100;
+
+  {
+    auto cnx = router.replica(50);
+    EXPECT_EQ(0, replica->idle());
+    EXPECT_EQ(1, router.queries);
+  }
+
+  // The cached position is recent enough.
+  {
+    auto cnx = router.replica(100);
+    EXPECT_EQ(0, replica->idle());
+    EXPECT_EQ(1, router.queries);
+  }
+
+  // Behind: the read is executed on the primary.
+  {
+    auto cnx = router.replica(150);
+    EXPECT_EQ(0, primary->idle());
+    EXPECT_EQ(1, replica->idle());
+    EXPECT_EQ(2, router.queries);
+  }
+
+  // Caught up.
+  router.position = 200;
+  {
+    auto cnx = router.replica(150);
+    EXPECT_EQ(0, replica->idle());
+    EXPECT_EQ(3, router.queries);
+  }
+
+}
+
+TEST(replicas, not_standby) {
+
+  auto primary = std::make_shared<ConnectionPool>(1);
+  auto replica = std::make_shared<ConnectionPool>(1);
+  InjectedRouter router(primary, replica);
+  router.standby = false;
+
+  // Not eligible, and queried again by each read.
+  for (int i = 1; i <= 2; i++) {
+    auto cnx = router.replica(10);
+    EXPECT_EQ(0, primary->idle());
+    EXPECT_EQ(1, replica->idle());
+    EXPECT_EQ(i, router.queries);
+  }
+
+  // Any replica for a read given no position.
+  {
+    auto cnx = router.replica(0);
+    EXPECT_EQ(0, replica->idle());
+  }
+
+  // Back to a standby.
+  router.standby = true;
+  router.position = 10;
+  {
+    auto cnx = router.replica(10);
+    EXPECT_EQ(0, replica->idle());
+  }
+
+}
@@ -274,3 +274,135 @@ TEST(result_sync, column_name) {
   EXPECT_STREQ(u8"メインページ", result.columnName(3));
 
 }
+
+TEST(result_sync, records) {
+
+  Connection cnx;
+  cnx.connect();
+
+  auto &result = cnx.execute("SELECT ROW(42, 'hello'::text, NULL::integer, ARRAY[1, 2], ROW(true)), NULL::record");
+  Record record = result.as<Record>(0);
+  ASSERT_EQ(5, record.size());
+  EXPECT_EQ(INT4OID, record.type(0));
+  EXPECT_EQ(42, record.as<int32_t>(0));
+  EXPECT_EQ("hello", record.as<std::string>(1));
+  EXPECT_TRUE(record.isNull(2));
+  EXPECT_EQ(2, record.asArray<int32_t>(3).size());
+  EXPECT_TRUE(record.as<Record>(4).as<bool>(0));
+  EXPECT_EQ(0, result.as<Record>(1).size());
+  EXPECT_THROW(result.as<Record>(1).as<int32_t>(0), ExecutionException);
+  EXPECT_THROW(result.as<Record>(1).isNull(0), ExecutionException);
+  EXPECT_THROW(record.type(5), ExecutionException);
+
+  // Fields read in any order.
+  std::string sql = "SELECT ROW(0";
+  for (int i = 1; i < 200; i++) {
+    sql += ", " + std::to_string(i);
+  }
+  sql += ")";
+  Record many = cnx.execute(sql.c_str()).as<Record>(0);
+  ASSERT_EQ(200, many.size());
+  for (int i = 199; i >= 0; i--) {
+    EXPECT_EQ(i, many.as<int32_t>(i));
+  }
+
+  std::vector<std::string> names;
+  for (auto &row: cnx.execute(R"SQL(
+    SELECT array_agg(ROW(i, 'name ' || i) ORDER BY i) FROM generate_series(1, 3) AS i
+  )SQL")) {
+    for (auto &item: row.asArray<Record>(0)) {
+      names.push_back(item.value.as<std::string>(1));
+    }
+  }
+  ASSERT_EQ(3, names.size());
+  EXPECT_EQ("name 3", names[2]);
+
+}
+
+TEST(result_sync, text_format) {
+
+  Connection cnx;
+  cnx.connect();
+  cnx.execute("set timezone TO 'GMT'");
+
+  auto &result = cnx.execute(Format::TEXT, R"SQL(
+    SELECT true, 32767::smallint, -2147483648, 9223372036854775807, 4.46678::real,
+           4.46678::double precision, 'hello'::text, DATE '2016-01-01',
+           TIMESTAMP WITH TIME ZONE '1970-01-01 00:00:00.600123+02',
+           INTERVAL '3 months 7 days 2:03:04', 123.45::numeric, '\x0a0b'::bytea,
+           ARRAY[1, NULL, 3], ARRAY['a b', NULL, 'c"d'], int4range(1, 10)
+  )SQL");
+  EXPECT_EQ(true, result.as<bool>(0));
+  EXPECT_EQ(32767, result.as<int16_t>(1));
+  EXPECT_EQ(-2147483647 - 1, result.as<int32_t>(2));
+  EXPECT_EQ(9223372036854775807, result.as<int64_t>(3));
+  EXPECT_FLOAT_EQ(4.46678f, result.as<float>(4));
+  EXPECT_DOUBLE_EQ(4.46678, result.as<double>(5));
+  EXPECT_EQ("hello", result.as<std::string>(6));
+  EXPECT_EQ(1451606400, result.as<date_t>(7));
+  EXPECT_EQ(600123 - int64_t(7200) * 1000000, result.as<timestamptz_t>(8));
+  auto interval = result.as<interval_t>(9);
+  EXPECT_EQ(7384000000, interval.time);
+  EXPECT_EQ(7, interval.days);
+  EXPECT_EQ(3, interval.months);
+  EXPECT_EQ("123.45", result.as<numeric_t>(10).str());
+  EXPECT_EQ(2, result.as<std::vector<uint8_t>>(11).size());
+
+  auto integers = result.asArray<int32_t>(12);
+  ASSERT_EQ(3, integers.size());
+  EXPECT_TRUE(integers[1].isNull);
+  EXPECT_EQ(3, integers[2].value);
+
+  auto strings = result.asArray<std::string>(13);
+  ASSERT_EQ(3, strings.size());
+  EXPECT_EQ("a b", strings[0].value);
+  EXPECT_TRUE(strings[1].isNull);
+  EXPECT_EQ("c\"d", strings[2].value);
+
+  auto range = result.as<int4range_t>(14);
+  EXPECT_EQ(1, range.lower);
+  EXPECT_EQ(10, range.upper);
+
+  // Multiple commands always return text results.
+  EXPECT_EQ(42, cnx.execute("SELECT 1; SELECT 42").as<int32_t>(0));
+
+  // Unsupported styles are errors.
+  cnx.execute("SET IntervalStyle TO sql_standard");
+  EXPECT_THROW(cnx.execute(Format::TEXT, "SELECT INTERVAL '1 year 2 months 3 days'").as<interval_t>(0), ExecutionException);
+  EXPECT_THROW(parse<interval_t>("P1X", 3), ExecutionException);
+  EXPECT_THROW(parse<inet_t>("not an address", 14), ExecutionException);
+  EXPECT_THROW(parse<int32_t>("42x", 3), ExecutionException);
+
+}
+
+TEST(result_sync, iso8601) {
+
+  Connection cnx;
+  cnx.connect();
+  cnx.execute("SET IntervalStyle TO iso_8601");
+
+  auto text = [](char *buf, char *end) { return std::string(buf, end); };
+  char buf[FORMAT_MAX_LENGTH];
+
+  auto &result = cnx.execute(R"SQL(
+    SELECT DATE '2016-10-01', TIME '04:05:06.789', TIME WITH TIME ZONE '04:05:06+05:30',
+           TIMESTAMP '0044-03-15 10:00:00 BC', TIMESTAMP WITH TIME ZONE '2016-10-01 09:00:00.5+02',
+           INTERVAL '1 year 2 months -3 days 04:05:06.5', INTERVAL '1 year 2 months -3 days 04:05:06.5'::text
+  )SQL");
+  EXPECT_EQ("2016-10-01", text(buf, format(result.as<date_t>(0), buf)));
+  EXPECT_EQ("04:05:06.789", text(buf, format(result.as<db::postgres::time_t>(1), buf)));
+  EXPECT_EQ("04:05:06+05:30", text(buf, format(result.as<timetz_t>(2), buf)));
+  EXPECT_EQ("-0043-03-15T10:00:00", text(buf, format(result.as<timestamp_t>(3), buf)));
+  EXPECT_EQ("2016-10-01T07:00:00.5Z", text(buf, format(result.as<timestamptz_t>(4), buf)));
+  EXPECT_EQ(result.as<std::string>(6), text(buf, format(result.as<interval_t>(5), buf)));
+
+  // The server reads the ISO 8601 text back.
+  char *end = format(timestamptz_t { 1475305200500000 }, buf);
+  EXPECT_TRUE(cnx.execute("SELECT $1::timestamptz = '2016-10-01 09:00:00.5+02'", text(buf, end)).as<bool>(0));
+  end = format(interval_t { 14706500000, -3, 14 }, buf);
+  EXPECT_TRUE(cnx.execute("SELECT $1::interval = '1 year 2 months -3 days 04:05:06.5'", text(buf, end)).as<bool>(0));
+
+  timestamptz_t ts = parse<timestamptz_t>("2016-10-01T09:00:00.5+02:00", 27);
+  EXPECT_EQ(1475305200500000, ts);
+
+}
@@ -0,0 +1,108 @@
+/**
+ * Copyright (c) 2016 Philippe FERDINAND
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ **/
+#include "gtest/gtest.h"
+#include "postgres-connection.h"
+#include "postgres-exceptions.h"
+
+#include <thread>
+
+using namespace db::postgres;
+
+TEST(resultset, detach_all) {
+
+  Connection cnx;
+  cnx.connect();
+
+  ResultSet rows = cnx.execute("SELECT generate_series(1, 3)").detach();
+  EXPECT_EQ(3, rows.size());
+
+  // The set remains valid after the next query.
+  EXPECT_EQ(42, cnx.execute("SELECT 42").as<int32_t>(0));
+
+  int32_t actual = 0;
+  int32_t num = 0;
+  for (auto &row: rows) {
+    actual += row.as<int32_t>(0);
+    num += row.num();
+  }
+
+  EXPECT_EQ(6, actual);
+  EXPECT_EQ(6, num);
+
+}
+
+TEST(resultset, detach_partial) {
+
+  Connection cnx;
+  cnx.connect();
+
+  auto &result = cnx.execute("SELECT generate_series(1, 5)");
+  ResultSet first = result.detach(2);
+  EXPECT_EQ(2, first.size());
+
+  int32_t actual = 0;
+  for (auto &row: result) {
+    actual += row.as<int32_t>(0);
+    EXPECT_GT(row.num(), 2);
+  }
+  EXPECT_EQ(12, actual);
+
+  actual = 0;
+  for (auto &row: first) {
+    actual += row.as<int32_t>(0);
+  }
+  EXPECT_EQ(3, actual);
+
+}
+
+TEST(resultset, no_row) {
+
+  Connection cnx;
+  cnx.connect();
+
+  ResultSet rows = cnx.execute("SELECT 1 WHERE 1=2").detach();
+  EXPECT_TRUE(rows.empty());
+  EXPECT_FALSE(rows.begin() != rows.end());
+
+}
+
+TEST(resultset, move_to_thread) {
+
+  Connection cnx;
+  cnx.connect();
+
+  ResultSet rows = cnx.execute("SELECT generate_series(1, 100)").detach();
+
+  int32_t actual = 0;
+  std::thread worker([&actual](ResultSet rows) {
+    for (auto &row: rows) {
+      actual += row.as<int32_t>(0);
+    }
+  }, std::move(rows));
+
+  cnx.execute("SELECT 1");
+  worker.join();
+
+  EXPECT_TRUE(rows.empty());
+  EXPECT_EQ(5050, actual);
+
+}
@@ -0,0 +1,135 @@
+/**
+ * Copyright (c) 2016 Philippe FERDINAND
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ **/
+#include "gtest/gtest.h"
+#include "postgres-scan.h"
+#include "postgres-exceptions.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <thread>
+
+using namespace db::postgres;
+
+// Connections to scan a table of 10000 rows.
+struct Scan {
+  Connection cnx[3];
+  std::vector<Connection *> connections;
+
+  Scan() {
+    for (auto &c: cnx) {
+      c.connect();
+      connections.push_back(&c);
+    }
+    cnx[0].execute("DROP TABLE IF EXISTS test_scan");
+    cnx[0].execute("CREATE TABLE test_scan (id INTEGER PRIMARY KEY, label TEXT)");
+    cnx[0].execute("INSERT INTO test_scan SELECT x, 'label ' || x FROM generate_series(1, 10000) AS x");
+  }
+
+  ~Scan() {
+    cnx[0].execute("DROP TABLE test_scan");
+  }
+};
+
+TEST(scan, by_blocks) {
+
+  Scan test;
+  std::mutex mutex;
+  int64_t count = 0;
+  int64_t sum = 0;
+  ParallelScan(test.connections).byBlocks("test_scan", "id, label", [&](const Row &row) {
+    std::lock_guard<std::mutex> lock(mutex);
+    EXPECT_EQ("label " + std::to_string(row.as<int32_t>(0)), row.as<std::string>(1));
+    sum += row.as<int32_t>(0);
+    count++;
+  });
+  EXPECT_EQ(10000, count);
+  EXPECT_EQ(50005000, sum);
+
+}
+
+TEST(scan, by_key) {
+
+  Scan test;
+  std::mutex mutex;
+  int64_t count = 0;
+  int64_t sum = 0;
+  ParallelScan(test.connections).ranges(7).byKey("test_scan", "id", "id", [&](const Row &row) {
+    std::lock_guard<std::mutex> lock(mutex);
+    sum += row.as<int32_t>(0);
+    count++;
+  });
+  EXPECT_EQ(10000, count);
+  EXPECT_EQ(50005000, sum);
+
+}
+
+TEST(scan, snapshot) {
+
+  Scan test;
+  // Rows deleted once the scan has started are still scanned by all the
+  // connections: each one waits on its first row for the others, then the
+  // rows are deleted before the other ranges are queried.
+  std::mutex mutex;
+  std::condition_variable started;
+  std::map<std::thread::id, int64_t> counts;
+  int64_t count = 0;
+  Connection other;
+  other.connect();
+  ParallelScan(test.connections).ranges(30).byKey("test_scan", "id", "id", [&](const Row &) {
+    std::unique_lock<std::mutex> lock(mutex);
+    count++;
+    if (counts[std::this_thread::get_id()]++ == 0) {
+      if (counts.size() == test.connections.size()) {
+        other.execute("DELETE FROM test_scan");
+        started.notify_all();
+      }
+      else {
+        started.wait_for(lock, std::chrono::seconds(30), [&] {
+          return counts.size() == test.connections.size();
+        });
+      }
+    }
+  });
+  EXPECT_EQ(10000, count);
+  EXPECT_EQ(test.connections.size(), counts.size());
+  EXPECT_EQ(0, other.execute("SELECT count(*) FROM test_scan").as<int64_t>(0));
+
+}
+
+TEST(scan, error) {
+
+  Scan test;
+  EXPECT_THROW(ParallelScan(test.connections).byBlocks("test_scan", "unknown_column", [](const Row &) {}), ExecutionException);
+  EXPECT_THROW(ParallelScan(test.connections).byKey("test_scan", "id", "id", [](const Row &) {
+    throw ExecutionException("consumer");
+  }), ExecutionException);
+
+  // No transaction left in progress.
+  for (auto &c: test.cnx) {
+    EXPECT_EQ(42, c.execute("SELECT 42").as<int32_t>(0));
+    c.begin();
+    c.commit();
+  }
+
+}
@@ -0,0 +1,61 @@
+/**
+ * Copyright (c) 2016 Philippe FERDINAND
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ **/
+#include "gtest/gtest.h"
+#include "postgres-connection.h"
+#include "postgres-vector.h"
+
+using namespace db::postgres;
+
+TEST(vector, pgvector) {
+
+  Connection cnx;
+  cnx.connect();
+
+  if (cnx.execute("SELECT count(*) FROM pg_available_extensions WHERE name = 'vector'").as<int64_t>(0) == 0) {
+    return; // pgvector is not installed.
+  }
+
+  registerVectorTypes();
+
+  cnx.execute("CREATE EXTENSION IF NOT EXISTS vector");
+  cnx.resolveTypes();
+
+  vector_t v = cnx.execute("SELECT '[1, -2.5, 3, 4, 5]'::vector").as<vector_t>(0);
+  ASSERT_EQ(5, v.values.size());
+  EXPECT_EQ(1.f, v.values[0]);
+  EXPECT_EQ(-2.5f, v.values[1]);
+  EXPECT_EQ(5.f, v.values[4]);
+
+  EXPECT_STREQ("[1,-2.5,3,4,5]", cnx.execute("SELECT $1::text", v).as<std::string>(0).c_str());
+
+  float query[] = { 1.f, 0.f, 0.f };
+  EXPECT_EQ(1., cnx.execute("SELECT $1 <-> '[1, 1, 0]'::vector", vector_view_t { query, 3 }).as<double>(0));
+
+  std::vector<float> large(1536, 0.5f);
+  EXPECT_EQ(1536, cnx.execute("SELECT vector_dims($1)", vector_view_t { large.data(), large.size() }).as<int32_t>(0));
+
+  auto vectors = cnx.execute("SELECT ARRAY['[1]'::vector, NULL]").asArray<vector_t>(0);
+  ASSERT_EQ(2, vectors.size());
+  EXPECT_EQ(1.f, vectors[0].value.values[0]);
+  EXPECT_TRUE(vectors[1].isNull);
+
+}